@@ -0,0 +1,210 @@
+// Benchmark.hpp
+// Minimal microbenchmark harness writing Google Benchmark compatible JSON
+#ifndef BENCHMARK
+#define BENCHMARK
+
+#include "../include/json.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Benchmark {
+
+    // Keep `value` alive without the compiler seeing through it
+    template <typename T>
+    inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const void* sink;
+        sink = &value;
+#endif
+    }
+
+    /*
+    Timed loop of one run, iterated as `for (auto _ : state)`. The clock runs
+    from the first to the last iteration, so setup before the loop is not
+    counted.
+
+    Fields:
+    - `iterations`: Iterations of the run, chosen by the harness;
+    - `arguments`: Arguments of the registration, see `range`;
+    - `itemsProcessed`: Items handled by the whole run, reported per second
+        when set by the benchmark;
+    - `label`: Free text reported with the run.
+    */
+    class State {
+    public:
+        std::int64_t iterations;
+        std::vector<std::int64_t> arguments;
+        std::int64_t itemsProcessed = 0;
+        std::string label;
+
+        State(std::int64_t iterations, std::vector<std::int64_t> arguments) : iterations(iterations), arguments(std::move(arguments)) {}
+
+        std::int64_t range(std::size_t k = 0) const { return arguments.at(k); }
+        void setItemsProcessed(std::int64_t items) { itemsProcessed = items; }
+        void setLabel(const std::string& text) { label = text; }
+
+        double realSeconds() const { return std::chrono::duration<double>(realEnd - realStart).count(); }
+        double cpuSeconds() const { return double(cpuEnd - cpuStart) / CLOCKS_PER_SEC; }
+
+        struct Iterator {
+            // Value of the loop variable, not trivially destructible so that the unused variable does not warn
+            struct Value {
+                ~Value() {}
+            };
+
+            State* state;
+            std::int64_t remaining;
+
+            bool operator!=(const Iterator&) {
+                if (remaining > 0) return true;
+                state->stop();
+                return false;
+            }
+            void operator++() { remaining--; }
+            Value operator*() const { return {}; }
+        };
+
+        Iterator begin() {
+            start();
+            return {this, iterations};
+        }
+        Iterator end() { return {this, 0}; }
+
+    private:
+        void start() {
+            cpuStart = std::clock();
+            realStart = std::chrono::steady_clock::now();
+        }
+
+        void stop() {
+            realEnd = std::chrono::steady_clock::now();
+            cpuEnd = std::clock();
+        }
+
+        std::chrono::steady_clock::time_point realStart, realEnd;
+        std::clock_t cpuStart = 0, cpuEnd = 0;
+    };
+
+    using Function = std::function<void(State&)>;
+
+    // Benchmark function with the arguments of each of its runs
+    struct Registration {
+        std::string name;
+        Function function;
+        std::vector<std::vector<std::int64_t>> arguments;
+
+        // One more run with a single argument
+        Registration& arg(std::int64_t value) {
+            arguments.push_back({value});
+            return *this;
+        }
+
+        Registration& args(const std::vector<std::int64_t>& values) {
+            for (std::int64_t value : values) arg(value);
+            return *this;
+        }
+    };
+
+    inline std::vector<Registration>& registry() {
+        static std::vector<Registration> registrations;
+        return registrations;
+    }
+
+    inline Registration& add(const std::string& name, Function function) {
+        registry().push_back({name, std::move(function), {}});
+        return registry().back();
+    }
+
+    /*
+    Options of `run`.
+
+    Fields:
+    - `minTime`: Shortest timed run (in s). Iterations grow tenfold, or as
+        predicted by the last run, until a run lasts that long;
+    - `filter`: Substring of the names of the runs to keep, empty for all;
+    - `maxIterations`: Upper bound of the iterations of a run.
+    */
+    struct Options {
+        double minTime = 0.5;
+        std::string filter;
+        std::int64_t maxIterations = 1000000000;
+    };
+
+    // Run every registered benchmark and return the report in the Google Benchmark JSON layout
+    inline nlohmann::json run(const Options& options) {
+        using nlohmann::json;
+
+        char date[32];
+        std::time_t now = std::time(nullptr);
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+        json report;
+        report["context"] = {
+            {"date", date},
+            {"num_cpus", std::thread::hardware_concurrency()},
+#ifdef NDEBUG
+            {"library_build_type", "release"},
+#else
+            {"library_build_type", "debug"},
+#endif
+            {"min_time", options.minTime}
+        };
+        report["benchmarks"] = json::array();
+
+        for (Registration& registration : registry()) {
+            std::vector<std::vector<std::int64_t>> arguments = registration.arguments;
+            if (arguments.empty()) arguments.push_back({});
+
+            for (const std::vector<std::int64_t>& runArguments : arguments) {
+                std::string name = registration.name;
+                for (std::int64_t argument : runArguments) name += "/" + std::to_string(argument);
+                if (!options.filter.empty() && name.find(options.filter) == std::string::npos) continue;
+
+                std::int64_t iterations = 1;
+                for (;;) {
+                    State state(iterations, runArguments);
+                    registration.function(state);
+
+                    double seconds = state.realSeconds();
+                    if (seconds >= options.minTime || iterations >= options.maxIterations) {
+                        json entry = {
+                            {"name", name},
+                            {"run_name", name},
+                            {"run_type", "iteration"},
+                            {"iterations", iterations},
+                            {"real_time", 1e9 * seconds / iterations},
+                            {"cpu_time", 1e9 * state.cpuSeconds() / iterations},
+                            {"time_unit", "ns"}
+                        };
+                        if (state.itemsProcessed > 0) entry["items_per_second"] = state.itemsProcessed / seconds;
+                        if (!state.label.empty()) entry["label"] = state.label;
+                        report["benchmarks"].push_back(entry);
+
+                        std::cerr << name << ": " << 1e9 * seconds / iterations << " ns, " << iterations << " iterations\n";
+                        break;
+                    }
+
+                    // 40% more than predicted, at most tenfold
+                    double predicted = seconds > 0.0 ? 1.4 * options.minTime / seconds * iterations : 10.0 * iterations;
+                    iterations = std::min<std::int64_t>(options.maxIterations, std::max<double>(iterations + 1, std::min(predicted, 10.0 * iterations)));
+                }
+            }
+        }
+
+        return report;
+    }
+
+}
+
+#endif
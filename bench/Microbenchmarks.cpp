@@ -0,0 +1,308 @@
+#include "Benchmark.hpp"
+#include "../src/IdealGas.cpp"
+#include "../src/PengRobinson.cpp"
+#include "../include/Snapshot.hpp"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using Benchmark::State;
+
+namespace {
+
+    // Mixture sizes of the per-component benchmarks
+    const std::vector<std::int64_t> COMPONENT_COUNTS = {1, 2, 5, 10, 20, 50};
+
+    // States cycled through by the EoS benchmarks, so the temperature cache of the workspace is not always hit
+    const int N_STATES = 64;
+
+    // Run `body` with std::cerr muted, for the warnings of the EoS constructors about missing BIPs
+    template <typename Body>
+    void quietly(const Body& body) {
+        std::streambuf* buffer = std::cerr.rdbuf(nullptr);
+        body();
+        std::cerr.clear();
+        std::cerr.rdbuf(buffer);
+    }
+
+    // The `n` gases with the most interaction parameter records, most first
+    const std::vector<std::string>& gasNames(std::size_t n) {
+        static std::vector<std::string> names;
+
+        if (names.empty()) {
+            const ComponentRegistry& registry = ComponentRegistry::instance();
+            std::vector<int> records(registry.gases().size(), 0);
+            for (const BinaryIPs::InteractionParameter& ip : registry.interactionParameters()) {
+                for (const std::string* id : {&ip.CASN_1, &ip.CASN_2}) {
+                    if (auto found = registry.findComponent(*id)) records[*found]++;
+                }
+            }
+
+            std::vector<ComponentId> ids(records.size());
+            for (std::size_t i = 0; i < ids.size(); i++) ids[i] = i;
+            std::stable_sort(ids.begin(), ids.end(), [&](ComponentId a, ComponentId b) { return records[a] > records[b]; });
+
+            std::size_t nMax = *std::max_element(COMPONENT_COUNTS.begin(), COMPONENT_COUNTS.end());
+            for (std::size_t i = 0; i < nMax && i < ids.size(); i++) names.push_back(registry.gas(ids[i]).name);
+        }
+
+        static std::map<std::size_t, std::vector<std::string>> prefixes;
+        auto& prefix = prefixes[n];
+        if (prefix.empty()) prefix.assign(names.begin(), names.begin() + std::min(n, names.size()));
+        return prefix;
+    }
+
+    std::vector<double> equimolar(std::size_t n) {
+        return std::vector<double>(n, 1.0 / n);
+    }
+
+    const PengRobinsonEOS& pengRobinson(std::size_t n) {
+        static std::map<std::size_t, std::unique_ptr<PengRobinsonEOS>> cache;
+        auto& eos = cache[n];
+        if (!eos) quietly([&] { eos.reset(new PengRobinsonEOS(gasNames(n))); });
+        return *eos;
+    }
+
+    const IdealGasEOS& idealGas(std::size_t n) {
+        static std::map<std::size_t, std::unique_ptr<IdealGasEOS>> cache;
+        auto& eos = cache[n];
+        if (!eos) eos.reset(new IdealGasEOS(gasNames(n)));
+        return *eos;
+    }
+
+    // Pressures from 1 to 100 bar and temperatures from 250 to 450 K
+    void states(std::vector<double>& pressures, std::vector<double>& temperatures) {
+        std::mt19937 generator(1);
+        std::uniform_real_distribution<double> lnP(log(1e5), log(100e5)), T(250.0, 450.0);
+        pressures.resize(N_STATES);
+        temperatures.resize(N_STATES);
+        for (int k = 0; k < N_STATES; k++) {
+            pressures[k] = exp(lnP(generator));
+            temperatures[k] = T(generator);
+        }
+    }
+
+    // Polynomial of degree m with coefficients uniform in [-1, 1]
+    std::vector<std::complex<double>> polynomial(int m) {
+        std::mt19937 generator(m);
+        std::uniform_real_distribution<double> coefficient(-1.0, 1.0);
+        std::vector<std::complex<double>> a(m + 1);
+        for (auto& ak : a) ak = coefficient(generator);
+        return a;
+    }
+
+    // Databases
+
+    // Maps the snapshot itself, without the JSON fallback of the registry: a missing or stale snapshot throws
+    void databaseLoadSnapshot(State& state) {
+        for (auto _ : state) {
+            Snapshot::Database database(Snapshot::DEFAULT_PATH);
+            Benchmark::doNotOptimize(database.gasProperties().size());
+            Benchmark::doNotOptimize(database.interactionParameters().size());
+        }
+    }
+
+    void databaseLoadJson(State& state) {
+        for (auto _ : state) {
+            ComponentRegistry registry("", "utils/databases/chemsepdb.json", "utils/databases/pripdb.json");
+            Benchmark::doNotOptimize(registry.gases().size());
+        }
+    }
+
+    void registryGetGasProperties(State& state) {
+        const ComponentRegistry& registry = ComponentRegistry::instance();
+        const std::vector<std::string>& names = gasNames(state.range());
+
+        for (auto _ : state) {
+            for (const std::string& name : names) Benchmark::doNotOptimize(registry.getGasProperties(name).criticalTemperature);
+        }
+        state.setItemsProcessed(state.iterations * names.size());
+    }
+
+    void linearGetGasProperties(State& state) {
+        const std::vector<GasConstants::GasProperties>& gases = ComponentRegistry::instance().gases();
+        const std::vector<std::string>& names = gasNames(state.range());
+
+        for (auto _ : state) {
+            for (const std::string& name : names) Benchmark::doNotOptimize(GasConstants::getGasProperties(gases, name).criticalTemperature);
+        }
+        state.setItemsProcessed(state.iterations * names.size());
+    }
+
+    // Pairs of the first `n` gases with a record in the database
+    std::vector<std::pair<std::string, std::string>> knownPairs(std::size_t n) {
+        const ComponentRegistry& registry = ComponentRegistry::instance();
+        const std::vector<std::string>& names = gasNames(n);
+        std::vector<std::pair<std::string, std::string>> pairs;
+
+        for (std::size_t i = 0; i < names.size(); i++) {
+            for (std::size_t j = i + 1; j < names.size(); j++) {
+                if (registry.findInteractionParameters(registry.componentId(names[i]), registry.componentId(names[j]))) {
+                    pairs.push_back({names[i], names[j]});
+                }
+            }
+        }
+        return pairs;
+    }
+
+    void registryGetInteractionParameters(State& state) {
+        const ComponentRegistry& registry = ComponentRegistry::instance();
+        std::vector<std::pair<std::string, std::string>> pairs = knownPairs(state.range());
+
+        for (auto _ : state) {
+            for (const auto& pair : pairs) Benchmark::doNotOptimize(registry.getInteractionParameters(pair.first, pair.second).k12);
+        }
+        state.setItemsProcessed(state.iterations * pairs.size());
+        state.setLabel(std::to_string(pairs.size()) + " pairs");
+    }
+
+    void linearGetInteractionParameters(State& state) {
+        const std::vector<BinaryIPs::InteractionParameter>& records = ComponentRegistry::instance().interactionParameters();
+        std::vector<std::pair<std::string, std::string>> pairs = knownPairs(state.range());
+
+        for (auto _ : state) {
+            for (const auto& pair : pairs) Benchmark::doNotOptimize(BinaryIPs::getInteractionParameters(records, pair.first, pair.second).k12);
+        }
+        state.setItemsProcessed(state.iterations * pairs.size());
+        state.setLabel(std::to_string(pairs.size()) + " pairs");
+    }
+
+    // Root finding, the argument is the degree of the polynomial
+
+    void roots(State& state) {
+        std::vector<std::complex<double>> a = polynomial(state.range()), results, work;
+
+        for (auto _ : state) {
+            RootFind::roots(a, results, work);
+            Benchmark::doNotOptimize(results.data());
+        }
+    }
+
+    void laguerre(State& state) {
+        std::vector<std::complex<double>> a = polynomial(state.range());
+
+        for (auto _ : state) {
+            std::complex<double> x = 0.0;
+            Benchmark::doNotOptimize(RootFind::Laguerre(a, x));
+        }
+    }
+
+    // Equations of state, one state per iteration
+
+    void compressibilityFactor(State& state) {
+        const PengRobinsonEOS& eos = pengRobinson(state.range());
+        std::vector<double> z = equimolar(state.range()), pressures, temperatures;
+        states(pressures, temperatures);
+        PengRobinsonEOS::Workspace ws = eos.createWorkspace();
+
+        int k = 0;
+        for (auto _ : state) {
+            Benchmark::doNotOptimize(eos.compressibilityFactor(pressures[k], temperatures[k], z, ws));
+            k = (k + 1) % N_STATES;
+        }
+        state.setItemsProcessed(state.iterations);
+    }
+
+    void volume(State& state) {
+        const PengRobinsonEOS& eos = pengRobinson(state.range());
+        std::vector<double> z = equimolar(state.range()), pressures, temperatures;
+        states(pressures, temperatures);
+
+        int k = 0;
+        for (auto _ : state) {
+            Benchmark::doNotOptimize(eos.volume(pressures[k], temperatures[k], z));
+            k = (k + 1) % N_STATES;
+        }
+        state.setItemsProcessed(state.iterations);
+    }
+
+    void density(State& state) {
+        const PengRobinsonEOS& eos = pengRobinson(state.range());
+        std::vector<double> z = equimolar(state.range()), pressures, temperatures;
+        states(pressures, temperatures);
+
+        int k = 0;
+        for (auto _ : state) {
+            Benchmark::doNotOptimize(eos.density(pressures[k], temperatures[k], z));
+            k = (k + 1) % N_STATES;
+        }
+        state.setItemsProcessed(state.iterations);
+    }
+
+    void idealGasEnthalpy(State& state) {
+        const IdealGasEOS& eos = idealGas(state.range());
+        std::vector<double> z = equimolar(state.range()), pressures, temperatures;
+        states(pressures, temperatures);
+
+        int k = 0;
+        for (auto _ : state) {
+            Benchmark::doNotOptimize(eos.enthalpy(pressures[k], temperatures[k], z, UnitBase::MASS));
+            k = (k + 1) % N_STATES;
+        }
+        state.setItemsProcessed(state.iterations);
+    }
+
+}
+
+/*
+Microbenchmarks of the database loading and lookups, the polynomial root
+finders and the EoS properties, across 1 to 50 components (the degree for
+the root finders). Writes the report in the Google Benchmark JSON layout to
+stdout, or to the file of `--out`, so it can be compared across releases
+with the tools of that project.
+
+Usage: Microbenchmarks.exe [--min-time=seconds] [--filter=substring] [--out=file]
+*/
+int main(int argc, char* argv[]) {
+    Benchmark::Options options;
+    std::string outPath;
+
+    for (int k = 1; k < argc; k++) {
+        std::string argument = argv[k];
+        if (argument.rfind("--min-time=", 0) == 0) {
+            options.minTime = std::stod(argument.substr(11));
+        } else if (argument.rfind("--filter=", 0) == 0) {
+            options.filter = argument.substr(9);
+        } else if (argument.rfind("--out=", 0) == 0) {
+            outPath = argument.substr(6);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--min-time=seconds] [--filter=substring] [--out=file]\n";
+            return 1;
+        }
+    }
+
+    Benchmark::add("DatabaseLoad_Snapshot", databaseLoadSnapshot);
+    Benchmark::add("DatabaseLoad_Json", databaseLoadJson);
+    Benchmark::add("ComponentRegistry_getGasProperties", registryGetGasProperties).args(COMPONENT_COUNTS);
+    Benchmark::add("GasConstants_getGasProperties", linearGetGasProperties).args(COMPONENT_COUNTS);
+    Benchmark::add("ComponentRegistry_getInteractionParameters", registryGetInteractionParameters).args({2, 5, 10, 20, 50});
+    Benchmark::add("BinaryIPs_getInteractionParameters", linearGetInteractionParameters).args({2, 5, 10, 20, 50});
+    Benchmark::add("RootFind_roots", roots).args(COMPONENT_COUNTS);
+    Benchmark::add("RootFind_Laguerre", laguerre).args(COMPONENT_COUNTS);
+    Benchmark::add("PengRobinson_compressibilityFactor", compressibilityFactor).args(COMPONENT_COUNTS);
+    Benchmark::add("PengRobinson_volume", volume).args(COMPONENT_COUNTS);
+    Benchmark::add("PengRobinson_density", density).args(COMPONENT_COUNTS);
+    Benchmark::add("IdealGas_enthalpy", idealGasEnthalpy).args(COMPONENT_COUNTS);
+
+    nlohmann::json report = Benchmark::run(options);
+
+    if (outPath.empty()) {
+        std::cout << report.dump(2) << std::endl;
+    } else {
+        std::ofstream file(outPath);
+        if (!file) {
+            std::cerr << "Failed to open " << outPath << ".\n";
+            return 1;
+        }
+        file << report.dump(2) << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,135 @@
+#ifndef COMPONENTREGISTRY
+#define COMPONENTREGISTRY
+
+#include "GasProperties.hpp"
+#include "InteractionParameters.hpp"
+#include "Snapshot.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Stable integer handle of a gas, equal to its position in `ComponentRegistry::gases()`
+using ComponentId = std::uint32_t;
+
+/*
+Immutable store of the gas constants and interaction parameters databases.
+
+The databases are loaded once, when the registry is constructed, and the EoS
+classes keep references to the records. A registry must therefore outlive every
+EoS built from it. All member functions are const, so a registry can be shared
+between threads once constructed.
+
+`ComponentRegistry::instance()` returns a process-wide registry built from the
+default database paths on first use. A registry built from other files can be
+passed explicitly to the EoS constructors instead.
+
+Gases are looked up through an open-addressing hash table keyed on the
+case-folded gas names, CASN numbers and a few common aliases (`CO2`, `nC4`, ...).
+*/
+class ComponentRegistry {
+public:
+    ComponentRegistry(
+        const std::string& snapshotPath = Snapshot::DEFAULT_PATH,
+        const std::string& chemsepPath = "utils/databases/chemsepdb.json",
+        const std::string& pripPath = "utils/databases/pripdb.json");
+
+    ComponentRegistry(const ComponentRegistry&) = delete;
+    ComponentRegistry& operator=(const ComponentRegistry&) = delete;
+
+    // Shared registry, lazily initialized in a thread-safe way on the first call
+    static const ComponentRegistry& instance();
+
+    const std::vector<GasConstants::GasProperties>& gases() const { return gases_; }
+
+    const std::vector<BinaryIPs::InteractionParameter>& interactionParameters() const { return gasesIPs_; }
+
+    /*
+    Function to find the id of a gas. The identifier can be the gas name, its
+    CASN number or an alias, and is matched case-insensitively.
+
+    Returns:
+        The gas id, or an empty optional if the identifier is unknown.
+    */
+    std::optional<ComponentId> findComponent(std::string_view identifier) const;
+
+    // Same as `findComponent`, but throws `std::invalid_argument` if the identifier is unknown
+    ComponentId componentId(const std::string& identifier) const;
+
+    const GasConstants::GasProperties& gas(ComponentId id) const { return gases_[id]; }
+
+    /*
+    Function to get the physical constants of a gas.
+    The gas identifier can be either the gas name or its CASN number.
+
+    Throws `std::invalid_argument` if the gas is not in the database.
+    */
+    const GasConstants::GasProperties& getGasProperties(const std::string& identifier) const;
+
+    /*
+    Function to find the interaction parameter record of a couple of gases.
+    The pair is unordered, `(id_1, id_2)` and `(id_2, id_1)` give the same record.
+
+    When the database holds several records for the same pair (e.g. fits over
+    different temperature ranges), the first one in database order is returned.
+
+    Returns:
+        A pointer to the record, or `nullptr` if the pair is not in the database.
+    */
+    const BinaryIPs::InteractionParameter* findInteractionParameters(ComponentId id_1, ComponentId id_2) const;
+
+    // Number of database records for the pair, larger than one for duplicated pairs
+    std::size_t interactionParameterCount(ComponentId id_1, ComponentId id_2) const;
+
+    // k-th record of the pair in database order, with `k < interactionParameterCount(id_1, id_2)`
+    const BinaryIPs::InteractionParameter& interactionParameter(ComponentId id_1, ComponentId id_2, std::size_t k) const;
+
+    /*
+    Function to find the k12(T) table of a pair whose records were fitted over
+    different temperature ranges. The tables are built once, with the registry.
+
+    Returns:
+        A pointer to the table, or `nullptr` if k12 does not depend on temperature.
+    */
+    const BinaryIPs::KijTable* findKijTable(ComponentId id_1, ComponentId id_2) const;
+
+    /*
+    Function to get the interaction parameter record of a couple of gases.
+    The id's of the gases can be either the gas name or its CASN number.
+
+    Throws `std::invalid_argument` if the pair is not in the database.
+    */
+    const BinaryIPs::InteractionParameter& getInteractionParameters(const std::string& id_1, const std::string& id_2) const;
+
+private:
+    struct IndexSlot {
+        std::uint64_t hash;
+        std::uint32_t key; // Position in `keys_` plus one, 0 marks an empty slot
+        ComponentId id;
+    };
+
+    // Records of one pair are `pairEntries_[begin, begin + count)`
+    struct PairSlot {
+        std::uint64_t key; // Pair key plus one, 0 marks an empty slot
+        std::uint32_t begin;
+        std::uint32_t count;
+        std::int32_t table; // Position in `kijTables_`, -1 if k12 is constant
+    };
+
+    void buildIndex();
+    void addKey(std::string_view key, ComponentId id);
+    void buildPairIndex();
+    const PairSlot* findPair(ComponentId id_1, ComponentId id_2) const;
+
+    std::vector<GasConstants::GasProperties> gases_;
+    std::vector<BinaryIPs::InteractionParameter> gasesIPs_;
+    std::vector<std::string> keys_;
+    std::vector<IndexSlot> index_;
+    std::vector<std::uint32_t> pairEntries_;
+    std::vector<PairSlot> pairIndex_;
+    std::vector<BinaryIPs::KijTable> kijTables_;
+};
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef EQUATIONOFSTATE
 #define EQUATIONOFSTATE
 
+#include <cstddef>
+#include <stdexcept>
 #include <string>
 #include <vector>
 #include <complex>
@@ -10,6 +12,12 @@ enum class UnitBase {
     MASS   // Mass base, kg
 };
 
+enum class PhaseRoot {
+    VAPOR,  // Largest root of the cubic
+    LIQUID, // Smallest root above the covolume
+    STABLE  // Root with the lowest Gibbs energy
+};
+
 // Base class for EoS implementations
 class EquationOfState {
 public:
@@ -20,6 +28,43 @@ public:
 
     // Compute the compressibility factor Z
     virtual double compressibilityFactor(double pressure, double temperature, const std::vector<double>& moleFractions) const = 0;
+
+    // Compute the compressibility factor Z of many (P, T) states, written to `Z`.
+    // `moleFractions` is a single composition shared by all the states, or, when
+    // `compositionPerState` is set, one composition per state stored row-major.
+    // The default evaluates the states one at a time.
+    virtual void compressibilityFactors(
+        const std::vector<double>& pressures,
+        const std::vector<double>& temperatures,
+        const std::vector<double>& moleFractions,
+        std::vector<double>& Z,
+        bool compositionPerState = false) const {
+        std::size_t nStates = pressures.size();
+
+        if (temperatures.size() != nStates) {
+            throw std::invalid_argument("The pressures and temperatures must have the same size.");
+        }
+        if (compositionPerState && nStates > 0 && moleFractions.size() % nStates != 0) {
+            throw std::invalid_argument("The compositions must have one row per state.");
+        }
+
+        Z.resize(nStates);
+
+        if (!compositionPerState) {
+            for (std::size_t k = 0; k < nStates; k++) {
+                Z[k] = compressibilityFactor(pressures[k], temperatures[k], moleFractions);
+            }
+            return;
+        }
+
+        std::size_t nComponents = nStates > 0 ? moleFractions.size() / nStates : 0;
+        std::vector<double> x(nComponents);
+
+        for (std::size_t k = 0; k < nStates; k++) {
+            x.assign(moleFractions.begin() + k * nComponents, moleFractions.begin() + (k + 1) * nComponents);
+            Z[k] = compressibilityFactor(pressures[k], temperatures[k], x);
+        }
+    }
     
     // Compute the volume V, either in m3/mol or in m3/kg
     virtual double volume(double pressure, double temperature, const std::vector<double>& moleFractions, UnitBase unit) const = 0;
@@ -1,8 +1,8 @@
 #ifndef GASPROPERTIES
 #define GASPROPERTIES
 
+#include <array>
 #include <iostream>
-#include <map>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -21,7 +21,7 @@ namespace GasConstants {
     - `molecularWeight`: Molecular weight (in kg/kmol);
     - `acentricFactor`.
     - `idealGasHeatCapacityPolyCoeffs`: The ideal gas heat capacity coefficients
-        of the polynomial equation C(T) = A + BT + CT^2 + DT^3
+        {A, B, C, D} of the polynomial equation C(T) = A + BT + CT^2 + DT^3 (in J/kmol/K)
     */
     struct GasProperties {
         std::string name;
@@ -31,7 +31,7 @@ namespace GasConstants {
         double criticalVolume;
         double molecularWeight;
         double acentricFactor;
-        std::map<std::string, double> idealGasHeatCapacityPolyCoeffs;
+        std::array<double, 4> idealGasHeatCapacityPolyCoeffs;
     };
 
     /* 
@@ -55,6 +55,16 @@ namespace GasConstants {
     */
     GasProperties getGasProperties(const std::vector<GasProperties>& gases, const std::string& identifier);
 
+    /*
+    Function to integrate the ideal gas heat capacity polynomial,
+    A T + B T^2 / 2 + C T^3 / 3 + D T^4 / 4 (in J/kmol).
+
+    Arguments:
+    - `coeffs`: The heat capacity coefficients {A, B, C, D};
+    - `temperature`: Upper bound of the integral (in K).
+    */
+    double idealGasHeatCapacityIntegral(const std::array<double, 4>& coeffs, double temperature);
+
 }
 
 #endif
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef INTERACTIONPARAMETERS
 #define INTERACTIONPARAMETERS
 
+#include <cstddef>
 #include <fstream>
 #include <iostream>
 #include <string>
@@ -16,7 +17,10 @@ namespace BinaryIPs {
     - `CASN_2`: CASN number of the second gas;
     - `Name_1`: Name of the first gas;
     - `Name_2`: Name of the second gas;
-    - `k12`: Interaction parameter.
+    - `k12`: Interaction parameter;
+    - `Comments`: Source notes, e.g. the temperature range of the fit;
+    - `minTemperature`, `maxTemperature`: Temperature range of the fit (in K),
+        parsed from `Comments`. Both are NaN when the comments give no range.
     */ 
     struct InteractionParameter {
         std::string CASN_1;
@@ -24,6 +28,53 @@ namespace BinaryIPs {
         std::string Name_1;
         std::string Name_2;
         double k12;
+        std::string Comments;
+        double minTemperature;
+        double maxTemperature;
+    };
+
+    // Largest half-width of the blend across a step between two ranges, and width of the blend outside the ranges (in K)
+    constexpr double KIJ_SMOOTHING = 10.0;
+
+    /*
+    Interaction parameter k12(T) of a pair fitted over several temperature
+    ranges.
+
+    k12 keeps the fitted value of each range and only changes across the gaps
+    and steps between ranges, so k12 and its temperature derivative are
+    continuous:
+    - across a gap, and over `KIJ_SMOOTHING` beyond the first and last knot, a
+        cubic with zero slope at both ends joins the two values;
+    - a step between adjacent ranges is averaged over a triangular kernel whose
+        half-width is `KIJ_SMOOTHING`, clamped to half the width of each of the
+        two ranges. The midpoint of every range keeps its fitted value.
+
+    Fields:
+    - `temperatures`: Knot temperatures in ascending order (in K). A repeated
+        temperature marks a step between two adjacent ranges;
+    - `values`: Fitted k12 at each knot;
+    - `below`, `above`: k12 below the first and above the last knot.
+    */
+    struct KijTable {
+        std::vector<double> temperatures;
+        std::vector<double> values;
+        double below;
+        double above;
+
+        // Evaluate the smoothed k12 at the given temperature, without allocating
+        double kij(double temperature) const;
+
+        // Derivative of the smoothed k12 with respect to the temperature
+        double slope(double temperature) const;
+
+        // Second derivative of the smoothed k12 with respect to the temperature
+        double curvature(double temperature) const;
+
+        // Smoothed k12 at the given temperature, with its first and second temperature derivatives
+        void evaluate(double temperature, double& value, double& first, double& second) const;
+
+        // Half-width of the blend across the step that starts at knot `k`
+        double stepWidth(std::size_t k) const;
     };
 
     /*
@@ -51,6 +102,37 @@ namespace BinaryIPs {
         const std::string& id_1, 
         const std::string& id_2);
 
+    /*
+    Function to read the temperature range from the comments of a pripdb entry,
+    e.g. "T=90-113K", "T=77.35K" or "T=40,100,160 F". The "T=" key may follow
+    any character but an upper-case letter, as in "Ammonia/WaterT=273.15K".
+
+    Arguments:
+    - `comments`: The `Comments` field of the entry;
+    - `minTemperature`, `maxTemperature`: Set to the range bounds (in K).
+
+    Returns:
+        `true` if a range was found, otherwise the bounds are set to NaN.
+    */
+    bool parseTemperatureRange(const std::string& comments, double& minTemperature, double& maxTemperature);
+
+    /*
+    Function to build the k12(T) table of a pair from all its database records.
+
+    Inside a fitted range the narrowest range containing the temperature wins,
+    k12 is blended across gaps between ranges, and outside the fitted ranges
+    the first record without a range is used (or the nearest range when every
+    record has one). A single temperature fit is dropped when a wider range or
+    an earlier single temperature fit covers it. See `KijTable`.
+
+    Arguments:
+    - `records`: The records of one pair, in database order.
+
+    Returns:
+        A `KijTable` object.
+    */
+    KijTable buildKijTable(const std::vector<const InteractionParameter*>& records);
+
 }
 
 #endif
\ No newline at end of file
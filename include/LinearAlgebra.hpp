@@ -0,0 +1,38 @@
+// LinearAlgebra.hpp
+// Dense linear solvers for the small systems of the phase equilibrium algorithms
+#ifndef LINEARALGEBRA
+#define LINEARALGEBRA
+
+namespace LinearAlgebra {
+
+    // Function for the in-place LU factorization of the row-major n x n matrix `A` with partial pivoting.
+    // `pivots` must hold n integers. Returns the sign of the row permutation, or 0 if the matrix is singular
+    int factorize(double* A, int n, int* pivots);
+
+    // Function for solving A x = b with the factors and pivots from `factorize`, `b` is overwritten by the solution
+    void substitute(const double* A, double* b, int n, const int* pivots);
+
+    // Function for solving the n x n system A x = b by Gaussian elimination with partial pivoting.
+    // `A` is row-major and is overwritten by its LU factors, `b` is overwritten by the solution
+    // and `pivots` must hold n integers. Returns false if the matrix is singular
+    bool solve(double* A, double* b, int n, int* pivots);
+
+    // Function for solving the symmetric positive definite n x n system A x = b by Cholesky factorization,
+    // about half the work of `solve`. Only the lower triangle of the row-major `A` is read, and it is
+    // overwritten by the factor L with 1 / L_ii on the diagonal. `b` is overwritten by the solution.
+    // Returns false if `A` is not positive definite
+    bool solveSymmetric(double* A, double* b, int n);
+
+    // Function for the determinant of the row-major n x n matrix `A`, overwritten by its LU factors.
+    // `pivots` must hold n integers
+    double determinant(double* A, int n, int* pivots);
+
+    // Function for the eigenvalues and eigenvectors of the symmetric row-major n x n matrix `A`,
+    // by the cyclic Jacobi method. `A` is overwritten, `values` receives the n eigenvalues and
+    // `vectors` the n x n row-major matrix whose column k is the unit eigenvector of values[k].
+    // Returns false if the off-diagonal part did not vanish within `maxSweeps` sweeps
+    bool symmetricEigen(double* A, int n, double* values, double* vectors, int maxSweeps = 50);
+
+}
+
+#endif
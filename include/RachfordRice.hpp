@@ -0,0 +1,37 @@
+// RachfordRice.hpp
+// Solvers of the Rachford-Rice material balance
+#ifndef RACHFORDRICE
+#define RACHFORDRICE
+
+namespace RachfordRice {
+
+    // Function for the Rachford-Rice residual sum_i z_i (K_i - 1) / (1 + beta (K_i - 1))
+    double residual(const double* z, const double* K, int n, double beta);
+
+    // Function for the window [betaMin, betaMax] of Leibovici and Neoschil, where every
+    // x_i = z_i / (1 + beta (K_i - 1)) and y_i = K_i x_i stay between 0 and 1.
+    // Returns false if the K-values are all above or all below 1
+    bool window(const double* z, const double* K, int n, double& betaMin, double& betaMax);
+
+    // Function for finding the vapor fraction beta by Newton's method, safeguarded by
+    // bisection inside the Leibovici-Neoschil window, from `initialGuess` when it lies in the
+    // window. The result can be negative or above 1 (negative flash); 0 is returned if all
+    // K_i <= 1 and 1 if all K_i >= 1
+    double solve(const double* z, const double* K, int n, double initialGuess = 0.5, double tolerance = 1e-14, int maxIterations = 100);
+
+    // Largest number of phases besides the reference one of `multiphase`
+    constexpr int MAX_PHASES = 7;
+
+    // Function for the phase fractions of the multiphase Rachford-Rice equations, in the convex
+    // formulation of Okuno, Johns and Sepehrnoori: minimize F(beta) = -sum_i z_i ln t_i with
+    // t_i = 1 + sum_j beta_j (K_ij - 1), over the region where every x_i0 = z_i / t_i and
+    // x_ij = K_ij x_i0 stays below 1. `K` is row-major n x m, relative to the reference phase 0,
+    // and `beta` holds the fractions of the m other phases: the initial guess, used if it lies in
+    // the region, then the result. The fractions can be negative (negative flash), the one of the
+    // reference phase is 1 - sum_j beta_j. Returns false if m > MAX_PHASES, no starting point
+    // was found in the region or Newton's method did not converge
+    bool multiphase(const double* z, const double* K, int n, int m, double* beta, double tolerance = 1e-14, int maxIterations = 100);
+
+}
+
+#endif
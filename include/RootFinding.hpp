@@ -12,9 +12,22 @@ namespace RootFind {
     // Function for finding the root of a polynomial using Laguerre's method
     std::complex<double> Laguerre(const std::vector<std::complex<double>>& a, std::complex<double>& x);
 
+    // Same as above, for the degree m polynomial with coefficients a[0], ..., a[m]
+    std::complex<double> Laguerre(const std::complex<double>* a, int m, std::complex<double>& x);
+
     // Function for finding all complex roots of a polynomial
     std::vector<std::complex<double>> roots(const std::vector<std::complex<double>>& a);
 
+    // Same as above, writing the roots into `results` and using `work` as scratch space.
+    // Does not allocate once both vectors have a capacity of at least a.size()
+    void roots(const std::vector<std::complex<double>>& a, std::vector<std::complex<double>>& results, std::vector<std::complex<double>>& work);
+
+    // Function for finding the real roots of the monic cubic a0 + a1 x + a2 x^2 + x^3
+    // with the trigonometric/Cardano formulas, each root polished by Newton's method.
+    // Writes the real roots in ascending order into `x` and returns their number, 1 or 3.
+    // Repeated roots are written once per multiplicity
+    int cubicRoots(double a0, double a1, double a2, double x[3]);
+
 }
 
 #endif
@@ -0,0 +1,74 @@
+// Simd.hpp
+// Minimal packed-double type used by the batched EoS kernels
+#ifndef SIMD
+#define SIMD
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#include <cmath>
+
+namespace Simd {
+
+    /*
+    Packed doubles of the widest instruction set enabled at compile time:
+    8 lanes with AVX-512 (-mavx512f), 4 lanes with AVX2 (-mavx2 -mfma), and a
+    single-lane scalar fallback otherwise.
+    */
+#if defined(__AVX512F__)
+    struct Vec {
+        static constexpr int LANES = 8;
+        __m512d v;
+
+        static Vec broadcast(double x) { return {_mm512_set1_pd(x)}; }
+        static Vec load(const double* p) { return {_mm512_loadu_pd(p)}; }
+        void store(double* p) const { _mm512_storeu_pd(p, v); }
+    };
+
+    inline Vec operator+(Vec a, Vec b) { return {_mm512_add_pd(a.v, b.v)}; }
+    inline Vec operator-(Vec a, Vec b) { return {_mm512_sub_pd(a.v, b.v)}; }
+    inline Vec operator*(Vec a, Vec b) { return {_mm512_mul_pd(a.v, b.v)}; }
+    inline Vec operator/(Vec a, Vec b) { return {_mm512_div_pd(a.v, b.v)}; }
+    inline Vec sqrt(Vec a) { return {_mm512_sqrt_pd(a.v)}; }
+    inline Vec fma(Vec a, Vec b, Vec c) { return {_mm512_fmadd_pd(a.v, b.v, c.v)}; }
+#elif defined(__AVX2__)
+    struct Vec {
+        static constexpr int LANES = 4;
+        __m256d v;
+
+        static Vec broadcast(double x) { return {_mm256_set1_pd(x)}; }
+        static Vec load(const double* p) { return {_mm256_loadu_pd(p)}; }
+        void store(double* p) const { _mm256_storeu_pd(p, v); }
+    };
+
+    inline Vec operator+(Vec a, Vec b) { return {_mm256_add_pd(a.v, b.v)}; }
+    inline Vec operator-(Vec a, Vec b) { return {_mm256_sub_pd(a.v, b.v)}; }
+    inline Vec operator*(Vec a, Vec b) { return {_mm256_mul_pd(a.v, b.v)}; }
+    inline Vec operator/(Vec a, Vec b) { return {_mm256_div_pd(a.v, b.v)}; }
+    inline Vec sqrt(Vec a) { return {_mm256_sqrt_pd(a.v)}; }
+#if defined(__FMA__)
+    inline Vec fma(Vec a, Vec b, Vec c) { return {_mm256_fmadd_pd(a.v, b.v, c.v)}; }
+#else
+    inline Vec fma(Vec a, Vec b, Vec c) { return a * b + c; }
+#endif
+#else
+    struct Vec {
+        static constexpr int LANES = 1;
+        double v;
+
+        static Vec broadcast(double x) { return {x}; }
+        static Vec load(const double* p) { return {*p}; }
+        void store(double* p) const { *p = v; }
+    };
+
+    inline Vec operator+(Vec a, Vec b) { return {a.v + b.v}; }
+    inline Vec operator-(Vec a, Vec b) { return {a.v - b.v}; }
+    inline Vec operator*(Vec a, Vec b) { return {a.v * b.v}; }
+    inline Vec operator/(Vec a, Vec b) { return {a.v / b.v}; }
+    inline Vec sqrt(Vec a) { return {std::sqrt(a.v)}; }
+    inline Vec fma(Vec a, Vec b, Vec c) { return {a.v * b.v + c.v}; }
+#endif
+
+}
+
+#endif
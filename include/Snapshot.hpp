@@ -0,0 +1,166 @@
+#ifndef SNAPSHOT
+#define SNAPSHOT
+
+#include "GasProperties.hpp"
+#include "InteractionParameters.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Snapshot {
+
+    // Default location of the binary snapshot generated by `make snapshot`
+    const std::string DEFAULT_PATH = "utils/databases/cthermodb.bin";
+
+    const char MAGIC[4] = {'C', 'T', 'D', 'B'};
+    const std::uint32_t VERSION = 2;
+
+    /*
+    Reference to a string stored in the snapshot string table.
+
+    Fields:
+    - `offset`: Position of the first character, relative to the string table;
+    - `length`: Number of characters (the string is not null terminated).
+    */
+    struct StringRef {
+        std::uint32_t offset;
+        std::uint32_t length;
+    };
+
+    /*
+    Fixed-layout file header. All offsets are in bytes from the start of the file.
+
+    Fields:
+    - `magic`: Always `CTDB`;
+    - `version`: Format version, must match `VERSION`;
+    - `gasRecordSize`, `interactionParameterRecordSize`: Record sizes used to
+        reject snapshots written with a different layout;
+    - `nGases`, `nInteractionParameters`: Number of records of each kind;
+    - `gasesOffset`, `interactionParametersOffset`: Start of each record array;
+    - `stringsOffset`, `stringsSize`: Location and size of the string table.
+    */
+    struct Header {
+        char magic[4];
+        std::uint32_t version;
+        std::uint32_t gasRecordSize;
+        std::uint32_t interactionParameterRecordSize;
+        std::uint32_t nGases;
+        std::uint32_t nInteractionParameters;
+        std::uint64_t gasesOffset;
+        std::uint64_t interactionParametersOffset;
+        std::uint64_t stringsOffset;
+        std::uint64_t stringsSize;
+    };
+
+    // On-disk counterpart of `GasConstants::GasProperties`
+    struct GasRecord {
+        StringRef name;
+        StringRef CASN;
+        double criticalTemperature;
+        double criticalPressure;
+        double criticalVolume;
+        double molecularWeight;
+        double acentricFactor;
+        double idealGasHeatCapacityPolyCoeffs[4];
+    };
+
+    // On-disk counterpart of `BinaryIPs::InteractionParameter`
+    struct InteractionParameterRecord {
+        StringRef CASN_1;
+        StringRef CASN_2;
+        StringRef Name_1;
+        StringRef Name_2;
+        StringRef Comments;
+        double k12;
+        double minTemperature;
+        double maxTemperature;
+    };
+
+    /*
+    Read-only memory mapping of a whole file. The mapping is released when the
+    object goes out of scope.
+    */
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        explicit MappedFile(const std::string& filePath);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        const unsigned char* data() const { return data_; }
+        std::size_t size() const { return size_; }
+
+    private:
+        void release();
+
+        const unsigned char* data_ = nullptr;
+        std::size_t size_ = 0;
+#ifdef _WIN32
+        void* fileHandle_ = nullptr;
+        void* mappingHandle_ = nullptr;
+#endif
+    };
+
+    /*
+    View over a memory mapped snapshot file. Records are read in place, nothing
+    is copied until `gasProperties` or `interactionParameters` are called.
+
+    Throws `std::runtime_error` if the file cannot be mapped or is not a valid
+    snapshot.
+    */
+    class Database {
+    public:
+        explicit Database(const std::string& filePath);
+
+        std::size_t gasCount() const { return header().nGases; }
+        std::size_t interactionParameterCount() const { return header().nInteractionParameters; }
+
+        const GasRecord& gas(std::size_t i) const;
+        const InteractionParameterRecord& interactionParameter(std::size_t i) const;
+        std::string_view string(const StringRef& ref) const;
+
+        // Materialize the records into the structs used by the EoS classes
+        std::vector<GasConstants::GasProperties> gasProperties() const;
+        std::vector<BinaryIPs::InteractionParameter> interactionParameters() const;
+
+    private:
+        const Header& header() const { return *reinterpret_cast<const Header*>(file_.data()); }
+
+        MappedFile file_;
+    };
+
+    /*
+    Function to write a binary snapshot of the gas constants and interaction
+    parameters databases.
+
+    Arguments:
+    - `filePath`: Output file;
+    - `gases`: A vector of `GasProperties` objects;
+    - `gasesIPs`: A vector of `InteractionParameter` objects.
+    */
+    void writeSnapshot(
+        const std::string& filePath,
+        const std::vector<GasConstants::GasProperties>& gases,
+        const std::vector<BinaryIPs::InteractionParameter>& gasesIPs);
+
+    /*
+    Functions to load the databases from the binary snapshot, falling back to
+    parsing the JSON file when the snapshot is missing or invalid.
+
+    Arguments:
+    - `snapshotPath`: Path of the binary snapshot;
+    - `jsonPath`: Path of the JSON database used as fallback.
+    */
+    std::vector<GasConstants::GasProperties> loadGasProperties(const std::string& snapshotPath, const std::string& jsonPath);
+
+    std::vector<BinaryIPs::InteractionParameter> loadInteractionParameters(const std::string& snapshotPath, const std::string& jsonPath);
+
+}
+
+#endif
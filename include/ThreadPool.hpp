@@ -0,0 +1,87 @@
+// ThreadPool.hpp
+// Work-stealing pool of worker threads for the batched evaluations
+#ifndef THREADPOOL
+#define THREADPOOL
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+Fixed set of threads running the chunks of `parallelFor`.
+
+[0, n) is cut into chunks of `grain` indices and every thread is handed a
+contiguous run of chunks. A thread takes its chunks from the front of its
+run; once out of work it steals the back half of the longest run left to
+another thread, so uneven chunks (flashes near a phase boundary against
+single-phase states) still keep every thread busy. The caller takes part
+as thread 0.
+
+Which thread runs a chunk depends on the scheduling, the chunk bounds do
+not: a body writing the results of [begin, end) to their own slots, with a
+workspace indexed by `thread`, gives the same output for any number of
+threads.
+
+Calls to `parallelFor` from several threads are serialized. It must not be
+called from inside a body. If a body throws, no further chunk is started
+and the first exception is rethrown to the caller once every thread is idle.
+*/
+class ThreadPool {
+public:
+    // Body of `parallelFor`, run on [begin, end) by thread `thread` < `size()`
+    using Body = std::function<void(std::size_t begin, std::size_t end, int thread)>;
+
+    // `nThreads` threads including the caller, 0 for one per hardware thread
+    explicit ThreadPool(int nThreads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return nThreads_; }
+
+    void parallelFor(std::size_t n, std::size_t grain, const Body& body);
+
+    // Runs taken from another thread during the last `parallelFor`
+    std::size_t steals() const { return steals_.load(); }
+
+private:
+    // Chunks [begin, end) left to a thread, on its own cache line
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::size_t begin = 0;
+        std::size_t end = 0;
+    };
+
+    void workerLoop(int thread);
+    void runChunks(int thread);
+    bool take(int thread, std::size_t& chunk);
+
+    int nThreads_;
+    std::vector<std::thread> threads_;
+    std::unique_ptr<Queue[]> queues_;
+
+    std::mutex callMutex_;                // Serializes `parallelFor`
+    std::mutex mutex_;                    // Guards the fields below
+    std::condition_variable start_;
+    std::condition_variable done_;
+    std::uint64_t generation_ = 0;        // Incremented for every job
+    int active_ = 0;                      // Worker threads still running the job
+    bool stopping_ = false;
+    std::exception_ptr error_;
+
+    const Body* body_ = nullptr;
+    std::size_t n_ = 0;
+    std::size_t grain_ = 1;
+    std::atomic<bool> failed_{false};
+    std::atomic<std::size_t> steals_{0};
+};
+
+#endif
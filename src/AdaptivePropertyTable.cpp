@@ -0,0 +1,356 @@
+#ifndef ADAPTIVEPROPERTYTABLE
+#define ADAPTIVEPROPERTYTABLE
+
+#include "PTFlash.cpp"
+#include "PropertyTable.cpp"
+#include "../include/ThreadPool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Phase state of a leaf of an `AdaptivePropertyTable`
+enum class CellState : std::uint8_t {
+    SINGLE_PHASE,  // Every sample has one phase, the interpolation holds
+    TWO_PHASE,     // Every sample splits, the properties are those of the single-phase root
+    BOUNDARY       // A phase boundary crosses the cell at the deepest level
+};
+
+/*
+Struct to store the build options of an `AdaptivePropertyTable`.
+
+Fields:
+- `minPressure`, `maxPressure`: Pressure range (in Pa);
+- `minTemperature`, `maxTemperature`: Temperature range (in K);
+- `tolerance`: Largest interpolation error of Z in a single-phase leaf;
+- `minDepth`: Depth down to which every cell is split;
+- `maxDepth`: Deepest level, the finest cells span 2^-maxDepth of each axis;
+- `nThreads`: Worker threads of the build, 0 for one per hardware thread.
+*/
+struct AdaptivePropertyTableOptions {
+    double minPressure = 1e5;
+    double maxPressure = 100e5;
+    double minTemperature = 200.0;
+    double maxTemperature = 400.0;
+    double tolerance = 1e-5;
+    int minDepth = 2;
+    int maxDepth = 10;
+    int nThreads = 0;
+};
+
+/*
+Properties of one mixture at a fixed composition on a quadtree over
+(ln P, T), refined where a uniform `PropertyTable` would be inaccurate.
+
+A cell is split in four while the error estimate of the bicubic Hermite
+interpolation of Z from its corners, twice the largest sampled deviation
+from the EoS as for the bounds of `PropertyTable`, exceeds `tolerance`, and
+while the PT flash finds different numbers of phases at its corners, center
+and edge midpoints, down to `maxDepth`. Steps of the EoS, where the stable
+root changes, stop the refinement at `maxDepth` with estimates above the
+tolerance, see `errorEstimate`. A leaf is then marked `SINGLE_PHASE`,
+`TWO_PHASE` or, where a phase boundary crosses it at the deepest level,
+`BOUNDARY`. Only single-phase leaves are interpolated to the tolerance: the
+others hold the properties of the single-phase root, and a caller needing
+the equilibrium flashes there. The estimates are sampled, see `PropertyTable`
+about the limits of that. Across leaves of different sizes the interpolant
+is continuous to within the tolerance only.
+
+Nodes are shared between the leaves and hold the properties of
+`PropertyTable`, as {f, f_x, f_y, f_xy} each. The tree is stored flat in
+breadth-first order, the four children of a cell being contiguous, so a
+lookup descends the levels in O(log n) steps over an array of 8-byte
+entries, then reads the four corner nodes of its leaf.
+
+The build runs level by level: the new nodes of a level, then the
+decisions on its cells, are spread over the `nThreads` threads of a
+`ThreadPool`, each with its own EoS and flash workspaces. The table does not depend on the number of
+threads.
+*/
+class AdaptivePropertyTable {
+public:
+    // Entry of the flattened tree: a cell with four children from `firstChild`, or a leaf
+    struct QuadNode {
+        std::int32_t firstChild;
+        std::int32_t leaf;
+    };
+
+    // Leaf of the tree, its corner nodes in the order of `PropertyTable::interpolate`
+    struct Leaf {
+        std::uint32_t corners[4];
+        CellState state;
+        double error;  // Estimated interpolation error of Z, see `errorEstimate`
+    };
+
+    /*
+    Function to build the table of a mixture.
+
+    Arguments:
+    - `eos`: Equation of state of the mixture;
+    - `moleFractions`: Composition, fixed for the whole table;
+    - `options`: Range, tolerance, depths and threads.
+
+    Throws `std::invalid_argument` if the range is empty or the depths are
+    not 0 <= minDepth <= maxDepth <= 20.
+    */
+    static AdaptivePropertyTable generate(
+        const PengRobinsonEOS& eos,
+        const std::vector<double>& moleFractions,
+        const AdaptivePropertyTableOptions& options) {
+        if (!(options.minPressure > 0.0) || !(options.maxPressure > options.minPressure)
+            || !(options.minTemperature > 0.0) || !(options.maxTemperature > options.minTemperature)) {
+            throw std::invalid_argument("The table needs increasing pressure and temperature ranges.");
+        }
+        if (options.minDepth < 0 || options.minDepth > options.maxDepth || options.maxDepth > 20) {
+            throw std::invalid_argument("The table depths must satisfy 0 <= minDepth <= maxDepth <= 20.");
+        }
+
+        AdaptivePropertyTable table;
+        table.nProperties = PropertyTable::LN_PHI + moleFractions.size();
+        table.minLnP = log(options.minPressure);
+        table.maxLnP = log(options.maxPressure);
+        table.minTemperature = options.minTemperature;
+        table.maxTemperature = options.maxTemperature;
+
+        ThreadPool pool(options.nThreads);
+        PTFlash flash(eos);
+
+        std::vector<Worker> workers;
+        workers.reserve(pool.size());
+        for (int t = 0; t < pool.size(); t++) {
+            workers.emplace_back(eos, moleFractions, flash, table.nProperties);
+        }
+
+        // Nodes are keyed by their position on the lattice of the deepest level
+        const int depth = options.maxDepth;
+        const std::uint64_t side = (std::uint64_t(1) << depth) + 1;
+        std::unordered_map<std::uint64_t, std::uint32_t> nodeIndex;
+        std::vector<std::uint8_t> nodePhases;
+        std::vector<std::uint64_t> newNodes;
+
+        std::vector<Cell> frontier = {{0, 0, 0, 0, {0, 0, 0, 0}, false, CellState::SINGLE_PHASE, 0.0}};
+        std::vector<Cell> next;
+        table.tree.push_back({-1, -1});
+
+        while (!frontier.empty()) {
+            newNodes.clear();
+            for (Cell& cell : frontier) {
+                std::uint64_t span = std::uint64_t(1) << (depth - cell.depth);
+                for (int corner = 0; corner < 4; corner++) {
+                    std::uint64_t key = (cell.a + corner / 2) * span * side + (cell.b + corner % 2) * span;
+                    auto inserted = nodeIndex.emplace(key, std::uint32_t(nodeIndex.size()));
+                    if (inserted.second) newNodes.push_back(key);
+                    cell.corners[corner] = inserted.first->second;
+                }
+            }
+
+            std::size_t first = nodePhases.size();
+            table.nodes.resize((first + newNodes.size()) * table.nProperties * 4);
+            nodePhases.resize(first + newNodes.size());
+
+            pool.parallelFor(newNodes.size(), 1, [&](std::size_t k, std::size_t, int thread) {
+                double x = table.minLnP + double(newNodes[k] / side) / (side - 1) * (table.maxLnP - table.minLnP);
+                double T = table.minTemperature + double(newNodes[k] % side) / (side - 1) * (table.maxTemperature - table.minTemperature);
+
+                Worker& worker = workers[thread];
+                worker.sampler.node(x, T, &table.nodes[(first + k) * table.nProperties * 4]);
+                nodePhases[first + k] = worker.phases(exp(x), T);
+            });
+
+            pool.parallelFor(frontier.size(), 1, [&](std::size_t k, std::size_t, int thread) {
+                table.classify(frontier[k], options, nodePhases, workers[thread]);
+            });
+
+            // Children are appended in order, which keeps the tree breadth-first
+            next.clear();
+            for (const Cell& cell : frontier) {
+                if (cell.split) {
+                    table.tree[cell.tree].firstChild = table.tree.size();
+                    for (int child = 0; child < 4; child++) {
+                        std::uint32_t a = 2 * cell.a + child / 2, b = 2 * cell.b + child % 2;
+                        next.push_back({std::uint32_t(table.tree.size()), cell.depth + 1, a, b, {0, 0, 0, 0}, false, CellState::SINGLE_PHASE, 0.0});
+                        table.tree.push_back({-1, -1});
+                    }
+                } else {
+                    table.tree[cell.tree].leaf = table.leaves.size();
+                    Leaf leaf = {{cell.corners[0], cell.corners[1], cell.corners[2], cell.corners[3]}, cell.state, cell.error};
+                    table.leaves.push_back(leaf);
+                    table.depth = std::max(table.depth, cell.depth);
+                }
+            }
+            frontier.swap(next);
+        }
+
+        return table;
+    }
+
+    int propertyCount() const { return nProperties; }
+    std::size_t nodeCount() const { return nodes.size() / (nProperties * 4); }
+    std::size_t leafCount() const { return leaves.size(); }
+    int maxDepth() const { return depth; }
+
+    // Bytes of the nodes, tree and leaves
+    std::size_t memoryUsage() const {
+        return nodes.size() * sizeof(double) + tree.size() * sizeof(QuadNode) + leaves.size() * sizeof(Leaf);
+    }
+
+    /*
+    Interpolate every property at (P, T), and optionally their derivatives in
+    T at constant P and in P at constant T, see `PropertyTable::evaluate`.
+    Returns the state of the leaf holding the point.
+    */
+    CellState evaluate(double pressure, double temperature, double* values, double* dT = nullptr, double* dP = nullptr) const {
+        Location location = locate(log(pressure), temperature);
+        const Leaf& leaf = leaves[location.leaf];
+
+        const double* corners[4];
+        for (int corner = 0; corner < 4; corner++) {
+            corners[corner] = nodes.data() + std::size_t(leaf.corners[corner]) * nProperties * 4;
+        }
+
+        PropertyTable::interpolate(corners, nProperties, location.u, location.v, location.hx, location.hy, values, dP, dT);
+        if (dP) {
+            for (std::size_t p = 0; p < nProperties; p++) dP[p] /= pressure;
+        }
+
+        return leaf.state;
+    }
+
+    // State of the leaf holding (P, T)
+    CellState state(double pressure, double temperature) const {
+        return leaves[locate(log(pressure), temperature).leaf].state;
+    }
+
+    // Estimated interpolation error of Z in the leaf holding (P, T), above `tolerance` where refinement stopped at `maxDepth`
+    double errorEstimate(double pressure, double temperature) const {
+        return leaves[locate(log(pressure), temperature).leaf].error;
+    }
+
+    const std::vector<QuadNode>& getTree() const { return tree; }
+    const std::vector<Leaf>& getLeaves() const { return leaves; }
+
+private:
+    // Per-thread samplers of the build
+    struct Worker {
+        PropertyTable::Sampler sampler;
+        const PTFlash& flash;
+        PTFlash::Workspace flashWs;
+        FlashResult flashResult;
+        const std::vector<double>& z;
+        std::vector<double> values;
+
+        Worker(const PengRobinsonEOS& eos, const std::vector<double>& z, const PTFlash& flash, std::size_t nProperties)
+            : sampler(eos, z), flash(flash), flashWs(flash.createWorkspace()), z(z), values(nProperties) {}
+
+        int phases(double pressure, double temperature) {
+            // Not from the trial phase of the sample before, which depends on the thread
+            flashWs.stability.hasCache = false;
+            flash.flash(pressure, temperature, z, flashResult, flashWs);
+            return flashResult.nPhases;
+        }
+    };
+
+    // Cell of the level being built, (a, b) on the grid of its depth, and the decision on it
+    struct Cell {
+        std::uint32_t tree;
+        int depth;
+        std::uint32_t a;
+        std::uint32_t b;
+        std::uint32_t corners[4];
+        bool split;
+        CellState state;
+        double error;
+    };
+
+    // Leaf holding a point, the point in the unit cell and the cell widths
+    struct Location {
+        std::size_t leaf;
+        double u;
+        double v;
+        double hx;
+        double hy;
+    };
+
+    AdaptivePropertyTable() = default;
+
+    /*
+    Decide whether to split a cell. The error of Z is estimated as in
+    `PropertyTable`, from the lattice inside the cell and the edge midpoints
+    with the same safety factor, and the number of phases is taken at the
+    corners, the center and the edge midpoints.
+    */
+    void classify(Cell& cell, const AdaptivePropertyTableOptions& options, const std::vector<std::uint8_t>& nodePhases, Worker& worker) const {
+        const std::vector<std::pair<double, double>>& samples = PropertyTable::errorSamples();
+        const std::size_t nPhaseSamples = 5;
+
+        double scale = 1.0 / double(std::uint64_t(1) << cell.depth);
+        double hx = (maxLnP - minLnP) * scale, hy = (maxTemperature - minTemperature) * scale;
+
+        bool single = false, twoPhase = false;
+        for (int corner = 0; corner < 4; corner++) {
+            (nodePhases[cell.corners[corner]] == 1 ? single : twoPhase) = true;
+        }
+
+        const double* corners[4];
+        for (int corner = 0; corner < 4; corner++) {
+            corners[corner] = nodes.data() + std::size_t(cell.corners[corner]) * nProperties * 4 + PropertyTable::Z * 4;
+        }
+
+        cell.error = 0.0;
+        for (std::size_t k = 0; k < samples.size(); k++) {
+            double u = samples[k].first, v = samples[k].second;
+            double P = exp(minLnP + (cell.a + u) * hx);
+            double T = minTemperature + (cell.b + v) * hy;
+
+            if (k < nPhaseSamples) (worker.phases(P, T) == 1 ? single : twoPhase) = true;
+
+            double Z;
+            worker.sampler.sample(P, T, worker.values.data(), nullptr, nullptr);
+            PropertyTable::interpolate(corners, 1, u, v, hx, hy, &Z, nullptr, nullptr);
+            cell.error = std::max(cell.error, PropertyTable::errorFactor * std::abs(Z - worker.values[PropertyTable::Z]));
+        }
+
+        bool deepest = cell.depth >= options.maxDepth;
+        if (single && twoPhase) {
+            cell.state = CellState::BOUNDARY;
+            cell.split = !deepest;
+        } else {
+            cell.state = twoPhase ? CellState::TWO_PHASE : CellState::SINGLE_PHASE;
+            cell.split = !deepest && (cell.depth < options.minDepth || (single && cell.error > options.tolerance));
+        }
+    }
+
+    // Descend from the root, points outside the range fall in the nearest leaf
+    Location locate(double x, double y) const {
+        double x0 = minLnP, y0 = minTemperature, hx = maxLnP - minLnP, hy = maxTemperature - minTemperature;
+        double cx = std::clamp(x, minLnP, maxLnP), cy = std::clamp(y, minTemperature, maxTemperature);
+
+        std::size_t k = 0;
+        while (tree[k].firstChild >= 0) {
+            hx *= 0.5;
+            hy *= 0.5;
+            int a = cx >= x0 + hx, b = cy >= y0 + hy;
+            x0 += a * hx;
+            y0 += b * hy;
+            k = tree[k].firstChild + 2 * a + b;
+        }
+
+        return {std::size_t(tree[k].leaf), (x - x0) / hx, (y - y0) / hy, hx, hy};
+    }
+
+    std::size_t nProperties = 0;
+    double minLnP = 0.0;
+    double maxLnP = 0.0;
+    double minTemperature = 0.0;
+    double maxTemperature = 0.0;
+    int depth = 0;
+
+    std::vector<double> nodes;
+    std::vector<QuadNode> tree;
+    std::vector<Leaf> leaves;
+};
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef BATCHEVALUATOR
+#define BATCHEVALUATOR
+
+#include "PTFlash.cpp"
+#include "../include/ThreadPool.hpp"
+#include <stdexcept>
+#include <vector>
+
+/*
+Evaluation of arrays of (P, T) states of one feed, split across the threads
+of a `ThreadPool`.
+
+Each thread has its own `PTFlash::Workspace`, the EoS workspace included,
+and each state is written to its own slot of the output, so the results are
+the same, bit for bit, for any number of threads. The trial phase cached by
+the stability analysis is dropped before each flash, so no state starts from
+the one run before it on the same thread, which depends on work stealing.
+This holds as long as `flash.stability.reuseTrialPhases` stays off, for the
+same reason.
+
+The EoS is only read and may be shared with other evaluators. Calls to one
+evaluator from several threads are serialized by its pool.
+*/
+class BatchEvaluator {
+public:
+    PTFlash flash;             // Options of the flashes
+    std::size_t grain = 16;    // States per chunk of work
+
+    explicit BatchEvaluator(const PengRobinsonEOS& eos, int nThreads = 0) : flash(eos), eos(eos), pool(nThreads) {
+        for (int t = 0; t < pool.size(); t++) {
+            workspaces.push_back(flash.createWorkspace());
+        }
+    }
+
+    int threadCount() const { return pool.size(); }
+    const ThreadPool& getPool() const { return pool; }
+
+    // Compressibility factors of the stable roots at every (pressures[k], temperatures[k])
+    void compressibilityFactors(
+        const std::vector<double>& pressures,
+        const std::vector<double>& temperatures,
+        const std::vector<double>& z,
+        std::vector<double>& Z) {
+        checkSizes(pressures, temperatures);
+        Z.resize(pressures.size());
+
+        pool.parallelFor(pressures.size(), grain, [&](std::size_t begin, std::size_t end, int thread) {
+            PengRobinsonEOS::Workspace& ws = workspaces[thread].eos;
+            for (std::size_t k = begin; k < end; k++) {
+                Z[k] = eos.compressibilityFactor(pressures[k], temperatures[k], z, ws);
+            }
+        });
+    }
+
+    // Residual properties of the `root` phase at every state, see `PengRobinsonEOS::residualProperties`
+    void residualProperties(
+        const std::vector<double>& pressures,
+        const std::vector<double>& temperatures,
+        const std::vector<double>& z,
+        std::vector<PengRobinsonEOS::ResidualProperties>& properties,
+        PhaseRoot root = PhaseRoot::STABLE) {
+        checkSizes(pressures, temperatures);
+        properties.resize(pressures.size());
+
+        pool.parallelFor(pressures.size(), grain, [&](std::size_t begin, std::size_t end, int thread) {
+            PengRobinsonEOS::Workspace& ws = workspaces[thread].eos;
+            for (std::size_t k = begin; k < end; k++) {
+                eos.residualProperties(pressures[k], temperatures[k], z, properties[k], ws, root);
+            }
+        });
+    }
+
+    // PT flash of the feed at every state. Reused results do not allocate once sized
+    void flashes(
+        const std::vector<double>& pressures,
+        const std::vector<double>& temperatures,
+        const std::vector<double>& z,
+        std::vector<FlashResult>& results) {
+        checkSizes(pressures, temperatures);
+        results.resize(pressures.size());
+
+        pool.parallelFor(pressures.size(), grain, [&](std::size_t begin, std::size_t end, int thread) {
+            PTFlash::Workspace& ws = workspaces[thread];
+            for (std::size_t k = begin; k < end; k++) {
+                ws.stability.hasCache = false;
+                flash.flash(pressures[k], temperatures[k], z, results[k], ws);
+            }
+        });
+    }
+
+private:
+    const PengRobinsonEOS& eos;
+    ThreadPool pool;
+    std::vector<PTFlash::Workspace> workspaces;    // One per thread of the pool
+
+    static void checkSizes(const std::vector<double>& pressures, const std::vector<double>& temperatures) {
+        if (temperatures.size() != pressures.size()) {
+            throw std::invalid_argument("The pressures and temperatures must have the same size.");
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,276 @@
+#include "../include/ComponentRegistry.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    // Common shorthand used in process simulators, mapped to ChemSep names
+    const std::pair<const char*, const char*> ALIASES[] = {
+        {"N2", "Nitrogen"},
+        {"O2", "Oxygen"},
+        {"H2", "Hydrogen"},
+        {"He", "Helium-4"},
+        {"Ar", "Argon"},
+        {"CO", "Carbon monoxide"},
+        {"CO2", "Carbon dioxide"},
+        {"H2S", "Hydrogen sulfide"},
+        {"H2O", "Water"},
+        {"SO2", "Sulfur dioxide"},
+        {"C1", "Methane"},
+        {"C2", "Ethane"},
+        {"C3", "Propane"},
+        {"iC4", "Isobutane"},
+        {"nC4", "N-butane"},
+        {"neoC5", "Neopentane"},
+        {"iC5", "Isopentane"},
+        {"nC5", "N-pentane"},
+        {"nC6", "N-hexane"},
+        {"nC7", "N-heptane"},
+        {"nC8", "N-octane"},
+        {"nC9", "N-nonane"},
+        {"nC10", "N-decane"}
+    };
+
+    char foldCase(char c) {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    // FNV-1a over the case-folded characters
+    std::uint64_t hashKey(std::string_view key) {
+        std::uint64_t hash = 14695981039346656037ull;
+        for (char c : key) {
+            hash ^= static_cast<unsigned char>(foldCase(c));
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // Order-independent key of a pair of components
+    std::uint64_t pairKey(ComponentId id_1, ComponentId id_2) {
+        if (id_1 > id_2) std::swap(id_1, id_2);
+        return (std::uint64_t(id_1) << 32) | id_2;
+    }
+
+    // splitmix64 finalizer, spreads the packed ids over the table
+    std::uint64_t hashPair(std::uint64_t key) {
+        key ^= key >> 30;
+        key *= 0xbf58476d1ce4e5b9ull;
+        key ^= key >> 27;
+        key *= 0x94d049bb133111ebull;
+        key ^= key >> 31;
+        return key;
+    }
+
+    bool equalsFolded(std::string_view folded, std::string_view key) {
+        if (folded.size() != key.size()) return false;
+        for (std::size_t i = 0; i < key.size(); i++) {
+            if (folded[i] != foldCase(key[i])) return false;
+        }
+        return true;
+    }
+
+}
+
+ComponentRegistry::ComponentRegistry(const std::string& snapshotPath, const std::string& chemsepPath, const std::string& pripPath)
+    : gases_(Snapshot::loadGasProperties(snapshotPath, chemsepPath)),
+      gasesIPs_(Snapshot::loadInteractionParameters(snapshotPath, pripPath)) {
+    buildIndex();
+    buildPairIndex();
+}
+
+const ComponentRegistry& ComponentRegistry::instance() {
+    static const ComponentRegistry registry;
+    return registry;
+}
+
+void ComponentRegistry::buildIndex() {
+    std::size_t capacity = 16;
+    while (capacity < 4 * gases_.size()) capacity *= 2;
+    index_.assign(capacity, IndexSlot{0, 0, 0});
+
+    // Names and CASN numbers first, so they take precedence over the aliases
+    for (ComponentId id = 0; id < gases_.size(); id++) {
+        addKey(gases_[id].name, id);
+        if (!gases_[id].CASN.empty()) addKey(gases_[id].CASN, id);
+    }
+
+    for (const auto& alias : ALIASES) {
+        std::optional<ComponentId> id = findComponent(alias.second);
+        if (id) addKey(alias.first, *id);
+    }
+}
+
+void ComponentRegistry::addKey(std::string_view key, ComponentId id) {
+    if (findComponent(key)) return;
+
+    // Keep the load factor at or below 1/2
+    if (2 * (keys_.size() + 1) > index_.size()) {
+        std::vector<IndexSlot> old;
+        old.swap(index_);
+        index_.assign(2 * old.size(), IndexSlot{0, 0, 0});
+        std::size_t mask = index_.size() - 1;
+        for (const auto& slot : old) {
+            if (slot.key == 0) continue;
+            std::size_t i = slot.hash & mask;
+            while (index_[i].key != 0) i = (i + 1) & mask;
+            index_[i] = slot;
+        }
+    }
+
+    std::string folded(key);
+    for (char& c : folded) c = foldCase(c);
+    keys_.push_back(folded);
+
+    std::uint64_t hash = hashKey(key);
+    std::size_t mask = index_.size() - 1;
+    std::size_t i = hash & mask;
+    while (index_[i].key != 0) i = (i + 1) & mask;
+    index_[i] = IndexSlot{hash, static_cast<std::uint32_t>(keys_.size()), id};
+}
+
+std::optional<ComponentId> ComponentRegistry::findComponent(std::string_view identifier) const {
+    if (index_.empty()) return std::nullopt;
+
+    std::uint64_t hash = hashKey(identifier);
+    std::size_t mask = index_.size() - 1;
+
+    for (std::size_t i = hash & mask; index_[i].key != 0; i = (i + 1) & mask) {
+        if (index_[i].hash == hash && equalsFolded(keys_[index_[i].key - 1], identifier)) {
+            return index_[i].id;
+        }
+    }
+
+    return std::nullopt;
+}
+
+ComponentId ComponentRegistry::componentId(const std::string& identifier) const {
+    std::optional<ComponentId> id = findComponent(identifier);
+
+    if (!id) {
+        throw std::invalid_argument("Could not find a gas with the identifier " + identifier);
+    }
+
+    return *id;
+}
+
+const GasConstants::GasProperties& ComponentRegistry::getGasProperties(const std::string& identifier) const {
+    return gases_[componentId(identifier)];
+}
+
+void ComponentRegistry::buildPairIndex() {
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> entries;
+
+    for (std::uint32_t k = 0; k < gasesIPs_.size(); k++) {
+        const auto& item = gasesIPs_[k];
+        std::optional<ComponentId> id_1 = findComponent(item.CASN_1);
+        std::optional<ComponentId> id_2 = findComponent(item.CASN_2);
+
+        if (!id_1) id_1 = findComponent(item.Name_1);
+        if (!id_2) id_2 = findComponent(item.Name_2);
+        if (!id_1 || !id_2) continue;
+
+        entries.emplace_back(pairKey(*id_1, *id_2), k);
+    }
+
+    // Sorting on (pair, database position) groups duplicated pairs and keeps
+    // their records in database order, so the resolution does not depend on
+    // the hash table layout
+    std::sort(entries.begin(), entries.end());
+
+    std::size_t nPairs = 0;
+    for (std::size_t k = 0; k < entries.size(); k++) {
+        if (k == 0 || entries[k].first != entries[k - 1].first) nPairs++;
+    }
+
+    std::size_t capacity = 16;
+    while (capacity < 2 * nPairs) capacity *= 2;
+    pairIndex_.assign(capacity, PairSlot{0, 0, 0, -1});
+    pairEntries_.clear();
+    kijTables_.clear();
+    pairEntries_.reserve(entries.size());
+
+    std::size_t mask = capacity - 1;
+    for (std::size_t k = 0; k < entries.size(); k++) {
+        std::uint64_t key = entries[k].first;
+        pairEntries_.push_back(entries[k].second);
+
+        if (k > 0 && key == entries[k - 1].first) continue;
+
+        std::uint32_t count = 0;
+        while (k + count < entries.size() && entries[k + count].first == key) count++;
+
+        std::int32_t table = -1;
+        if (count > 1) {
+            std::vector<const BinaryIPs::InteractionParameter*> records;
+            bool ranged = false;
+
+            for (std::uint32_t m = 0; m < count; m++) {
+                records.push_back(&gasesIPs_[entries[k + m].second]);
+                ranged = ranged || !std::isnan(records.back()->minTemperature);
+            }
+
+            if (ranged) {
+                table = static_cast<std::int32_t>(kijTables_.size());
+                kijTables_.push_back(BinaryIPs::buildKijTable(records));
+            }
+        }
+
+        std::size_t i = hashPair(key) & mask;
+        while (pairIndex_[i].key != 0) i = (i + 1) & mask;
+        pairIndex_[i] = PairSlot{key + 1, static_cast<std::uint32_t>(k), count, table};
+    }
+}
+
+const ComponentRegistry::PairSlot* ComponentRegistry::findPair(ComponentId id_1, ComponentId id_2) const {
+    if (pairIndex_.empty()) return nullptr;
+
+    std::uint64_t key = pairKey(id_1, id_2);
+    std::size_t mask = pairIndex_.size() - 1;
+
+    for (std::size_t i = hashPair(key) & mask; pairIndex_[i].key != 0; i = (i + 1) & mask) {
+        if (pairIndex_[i].key == key + 1) return &pairIndex_[i];
+    }
+
+    return nullptr;
+}
+
+const BinaryIPs::InteractionParameter* ComponentRegistry::findInteractionParameters(ComponentId id_1, ComponentId id_2) const {
+    const PairSlot* slot = findPair(id_1, id_2);
+    return slot ? &gasesIPs_[pairEntries_[slot->begin]] : nullptr;
+}
+
+std::size_t ComponentRegistry::interactionParameterCount(ComponentId id_1, ComponentId id_2) const {
+    const PairSlot* slot = findPair(id_1, id_2);
+    return slot ? slot->count : 0;
+}
+
+const BinaryIPs::InteractionParameter& ComponentRegistry::interactionParameter(ComponentId id_1, ComponentId id_2, std::size_t k) const {
+    const PairSlot* slot = findPair(id_1, id_2);
+
+    if (!slot || k >= slot->count) {
+        throw std::out_of_range("Interaction parameter record out of range.");
+    }
+
+    return gasesIPs_[pairEntries_[slot->begin + k]];
+}
+
+const BinaryIPs::KijTable* ComponentRegistry::findKijTable(ComponentId id_1, ComponentId id_2) const {
+    const PairSlot* slot = findPair(id_1, id_2);
+    return (slot && slot->table >= 0) ? &kijTables_[slot->table] : nullptr;
+}
+
+const BinaryIPs::InteractionParameter& ComponentRegistry::getInteractionParameters(const std::string& id_1, const std::string& id_2) const {
+    std::optional<ComponentId> gas_1 = findComponent(id_1);
+    std::optional<ComponentId> gas_2 = findComponent(id_2);
+    const BinaryIPs::InteractionParameter* item = (gas_1 && gas_2) ? findInteractionParameters(*gas_1, *gas_2) : nullptr;
+
+    if (!item) {
+        throw std::invalid_argument("Could not find the BIPs for the pair " + id_1 + ", " + id_2 + ".");
+    }
+
+    return *item;
+}
@@ -0,0 +1,546 @@
+#ifndef CRITICALPOINT
+#define CRITICALPOINT
+
+#include "PengRobinson.cpp"
+#include "../include/LinearAlgebra.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/*
+Struct to store a mixture critical point.
+
+Fields:
+- `temperature`, `pressure`: Critical temperature (in K) and pressure (in Pa);
+- `volume`: Critical molar volume (in m3/mol), including the volume translation;
+- `iterations`: All iterations of the solve: the determinant evaluations of the initial
+    temperature search, the Newton iterations on ln T and the outer iterations on the volume;
+- `converged`: Whether the volume steps fell below the tolerance.
+*/
+struct CriticalPoint {
+    double temperature = 0.0;
+    double pressure = 0.0;
+    double volume = 0.0;
+    int iterations = 0;
+    bool converged = false;
+};
+
+
+/*
+Critical point of a mixture with the Peng-Robinson EoS, by the method of
+Heidemann and Khalil (1980) with the analytic derivatives of Michelsen and
+Heidemann (1981).
+
+At constant T and V, with the reduced Helmholtz energy
+A / RT = sum_i n_i ln n_i + F(n, T, V), the critical point satisfies
+    Q dn = 0,   Q_ij = d2(A / RT) / dn_i dn_j = delta_ij / n_i + F_ij,
+    C = sum_ijk d3(A / RT) / dn_i dn_j dn_k dn_i dn_j dn_k = 0.
+The first condition is written as lambda = 0 for the smallest eigenvalue of
+the scaled matrix sqrt(z_i z_j) Q_ij, and dn_i = sqrt(z_i) u_i for its unit
+eigenvector u. F_ij and the cubic form C are evaluated in closed form from
+a_ij, b_i and the derivatives of g(V, B) and f(V, B), in O(N^2) without
+forming the third derivative tensor:
+    C = -sum_i dn_i^3 / z_i^2 - 3 g_BB s beta^2 - g_BBB beta^3
+        - 3 f_BB / T beta^2 dD - D / T f_BBB beta^3 - 6 f_B / T beta a3,
+with s = sum_i dn_i, beta = sum_i b_i dn_i, dD = 2 sum_ij dn_i a_ij z_j
+and a3 = sum_ij dn_i dn_j a_ij.
+
+As in the original method, the temperature where det Q first vanishes is
+located at V = 4 b, and the solution is nested: Newton's method on ln T
+keeps lambda = 0 at each volume, and secant steps on ln V solve C = 0. The
+eigenvector comes from the Jacobi method once, then is followed by inverse
+iteration, so that it varies continuously and C keeps a consistent sign.
+The Newton slope is analytic: for the unit eigenvector u,
+    d lambda / dT = sum_ij dn_i dn_j dF_ij / dT,
+from the temperature derivatives of a_ij cached in the PR workspace.
+A mixture without a critical point on this branch returns unconverged.
+
+Up to `STACK_COMPONENTS` components, the N x N matrices live on the stack,
+and with a reused workspace a solve does not allocate.
+*/
+class CriticalPointSolver {
+public:
+    static constexpr int STACK_COMPONENTS = 30;
+
+    // PR parameter cache, and the scratch of mixtures above STACK_COMPONENTS. Must not be shared between threads
+    struct Workspace {
+        PengRobinsonEOS::Workspace eos;
+        std::vector<double> heap;
+        std::vector<int> pivots;
+    };
+
+    double tolerance = 1e-10;  // On the steps in ln T and ln V
+    int maxIterations = 30;    // For both the volume and the temperature iterations
+
+    explicit CriticalPointSolver(const PengRobinsonEOS& eos) : eos(eos) {}
+
+    Workspace createWorkspace() const {
+        Workspace ws;
+        ws.eos = eos.createWorkspace();
+        return ws;
+    }
+
+    CriticalPoint solve(const std::vector<double>& z) const {
+        Workspace ws = createWorkspace();
+        CriticalPoint result;
+        solve(z, result, ws);
+        return result;
+    }
+
+    void solve(const std::vector<double>& z, CriticalPoint& result, Workspace& ws) const {
+        int n = z.size();
+        const PengRobinsonEOS::ComponentParameters& parameters = eos.getComponentParameters();
+
+        double stack[scratchSize(STACK_COMPONENTS)];
+        int pivotStack[STACK_COMPONENTS];
+        Scratch scratch;
+        double* memory = stack;
+        scratch.pivots = pivotStack;
+        if (n > STACK_COMPONENTS) {
+            ws.heap.resize(scratchSize(n));
+            ws.pivots.resize(n);
+            memory = ws.heap.data();
+            scratch.pivots = ws.pivots.data();
+        }
+        scratch.Q = memory;
+        scratch.work = scratch.Q + n * n;
+        scratch.values = scratch.work + n * n;
+        scratch.aSum = scratch.values + n;
+        scratch.dn = scratch.aSum + n;
+        scratch.reference = scratch.dn + n;
+
+        result.iterations = 0;
+        result.converged = false;
+
+        double Bm = 0.0, Tpc = 0.0;
+        for (int i = 0; i < n; i++) {
+            Bm += z[i] * parameters.b[i];
+            Tpc += z[i] * parameters.Tc[i];
+        }
+
+        double lnV = log(4.0 * Bm);
+        double lnT;
+        if (!initialTemperature(z, exp(lnV), Tpc, scratch, ws, lnT, result.iterations)) return;
+
+        // Secant iterations on C(ln V) along lambda = 0, regula falsi once the root is bracketed
+        double C;
+        if (!temperature(z, lnV, false, scratch, ws, lnT, C, result.iterations)) return;
+
+        double lnPrev = lnV, CPrev = C;
+        lnV += C < 0.0 ? -0.05 : 0.05;
+
+        bool bracketed = false;
+        double lnA = 0.0, CA = 0.0, lnB = 0.0, CB = 0.0;
+
+        for (int k = 0; k < maxIterations; k++) {
+            if (!temperature(z, lnV, true, scratch, ws, lnT, C, result.iterations)) return;
+            result.iterations++;
+
+            if (!bracketed && C * CPrev < 0.0) {
+                bracketed = true;
+                lnA = lnPrev;
+                CA = CPrev;
+                lnB = lnV;
+                CB = C;
+            } else if (bracketed) {
+                // Illinois: halve the retained end when the same end moves twice
+                if (C * CB > 0.0) {
+                    CA *= 0.5;
+                } else {
+                    lnA = lnB;
+                    CA = CB;
+                }
+                lnB = lnV;
+                CB = C;
+            }
+
+            double next;
+            if (bracketed) {
+                next = (lnA * CB - lnB * CA) / (CB - CA);
+            } else {
+                next = lnV - C * (lnV - lnPrev) / (C - CPrev);
+                if (!std::isfinite(next)) return;
+                next = std::min(std::max(next, lnV - 0.2), lnV + 0.2);
+            }
+            next = std::max(next, log(1.05 * Bm));
+
+            lnPrev = lnV;
+            CPrev = C;
+            double step = next - lnV;
+            lnV = next;
+
+            if (C == 0.0 || std::abs(step) < tolerance) {
+                result.converged = temperature(z, lnV, true, scratch, ws, lnT, C, result.iterations);
+                break;
+            }
+        }
+        double T = exp(lnT), V = exp(lnV);
+        result.temperature = T;
+        result.pressure = pressure(z, T, V, ws);
+        result.volume = V;
+
+        if (eos.hasVolumeTranslation()) {
+            for (int i = 0; i < n; i++) result.volume -= z[i] * parameters.c[i];
+        }
+    }
+
+private:
+    static constexpr double R = 8.3145;
+
+    const PengRobinsonEOS& eos;
+
+    // Views into the stack or heap scratch of one solve
+    struct Scratch {
+        double* Q;          // Scaled sqrt(z_i z_j) Q_ij
+        double* work;       // Eigenvectors, or LU factors
+        double* values;     // Eigenvalues, or the inverse iteration vector
+        double* aSum;       // sum_j a_ij z_j
+        double* dn;         // Critical direction
+        double* reference;  // Critical direction at the unperturbed point
+        int* pivots;
+    };
+
+    // Scalars of the mixture entering the cubic form
+    struct Mixture {
+        double D;
+        double g_BB, g_BBB;
+        double f, f_B, f_BB, f_BBB;
+    };
+
+    static constexpr int scratchSize(int n) { return 2 * n * n + 4 * n; }
+
+    // PR pressure at the untranslated molar volume V
+    double pressure(const std::vector<double>& z, double T, double V, Workspace& ws) const {
+        const double delta1 = 1.0 + std::sqrt(2.0), delta2 = 1.0 - std::sqrt(2.0);
+        int n = z.size();
+        int stride = eos.getComponentParameters().Tc.size();
+        const double* b = eos.getComponentParameters().b.data();
+
+        eos.prepare(T, ws.eos);
+        const double* aij = ws.eos.aij.data();
+
+        double D = 0.0, Bm = 0.0;
+        for (int i = 0; i < n; i++) {
+            double sum = 0.0;
+            for (int j = 0; j < n; j++) sum += z[j] * aij[i * stride + j];
+            D += z[i] * sum;
+            Bm += z[i] * b[i];
+        }
+
+        return R * T / (V - Bm) - D / ((V + delta1 * Bm) * (V + delta2 * Bm));
+    }
+
+    /*
+    Temperature where lambda vanishes at the molar volume exp(lnV), by
+    Newton's method on ln T from the current `lnT`. With `follow`, the
+    critical direction continues from the one left in the scratch, which
+    keeps the sign of C consistent between volumes. The zero eigenvalue must
+    also be the smallest one, which a Cholesky factorization confirms.
+    `iterations` is incremented once per Newton iteration.
+    */
+    bool temperature(const std::vector<double>& z, double lnV, bool follow, Scratch& scratch, Workspace& ws, double& lnT, double& C, int& iterations) const {
+        int n = z.size();
+        double V = exp(lnV);
+
+        double lambda, lambdaT;
+        for (int k = 0; k < maxIterations; k++) {
+            double T = exp(lnT);
+            evaluate(z, T, V, scratch, follow || k > 0, ws, lambda, C, lambdaT);
+            std::copy(scratch.dn, scratch.dn + n, scratch.reference);
+            iterations++;
+
+            double derivative = T * lambdaT;
+            if (derivative == 0.0 || !std::isfinite(derivative)) return false;
+
+            double step = std::min(std::max(-lambda / derivative, -0.2), 0.2);
+            lnT += step;
+
+            if (std::abs(step) < tolerance) {
+                evaluate(z, exp(lnT), V, scratch, true, ws, lambda, C, lambdaT);
+                std::copy(scratch.dn, scratch.dn + n, scratch.reference);
+                return std::abs(lambda) < 1e-8 && positiveDefinite(scratch, n, 1e-7);
+            }
+        }
+
+        return false;
+    }
+
+    // Whether the scaled Q plus `shift` times the identity has a Cholesky factorization
+    static bool positiveDefinite(Scratch& scratch, int n, double shift) {
+        double* L = scratch.work;
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j <= i; j++) {
+                double sum = scratch.Q[i * n + j] + (i == j ? shift : 0.0);
+                for (int k = 0; k < j; k++) sum -= L[i * n + k] * L[j * n + k];
+
+                if (i == j) {
+                    if (sum <= 0.0) return false;
+                    L[i * n + i] = sqrt(sum);
+                } else {
+                    L[i * n + j] = sum / L[j * n + j];
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // Temperature where det Q first vanishes from above at the molar volume V, by the Illinois method on ln T.
+    // `iterations` is incremented once per determinant
+    bool initialTemperature(const std::vector<double>& z, double V, double Tpc, Scratch& scratch, Workspace& ws, double& lnT, int& iterations) const {
+        int n = z.size();
+        auto determinant = [&](double lnT) {
+            iterations++;
+            assemble(z, exp(lnT), V, scratch, ws);
+            std::copy(scratch.Q, scratch.Q + n * n, scratch.work);
+            return LinearAlgebra::determinant(scratch.work, n, scratch.pivots);
+        };
+
+        double lnHi = log(1.5 * Tpc);
+        double detHi = determinant(lnHi);
+        for (int k = 0; k < 10 && detHi <= 0.0; k++) {
+            lnHi += log(1.5);
+            detHi = determinant(lnHi);
+        }
+
+        double lnLo = lnHi, detLo = detHi;
+        for (int k = 0; k < 30 && detLo > 0.0; k++) {
+            lnHi = lnLo;
+            detHi = detLo;
+            lnLo -= 0.2;
+            detLo = determinant(lnLo);
+        }
+        if (detHi <= 0.0 || detLo > 0.0) return false;
+
+        int side = 0;
+        lnT = lnHi;
+        for (int k = 0; k < 100 && lnHi - lnLo > 1e-6; k++) {
+            lnT = (lnLo * detHi - lnHi * detLo) / (detHi - detLo);
+            double det = determinant(lnT);
+
+            if (det > 0.0) {
+                lnHi = lnT;
+                detHi = det;
+                if (side == 1) detLo *= 0.5;
+                side = 1;
+            } else {
+                lnLo = lnT;
+                detLo = det;
+                if (side == -1) detHi *= 0.5;
+                side = -1;
+            }
+        }
+
+        return true;
+    }
+
+    // Scaled second derivative matrix at (T, V) for one mole of feed, and the scalars of the cubic form
+    Mixture assemble(const std::vector<double>& z, double T, double V, Scratch& scratch, Workspace& ws) const {
+        const double delta1 = 1.0 + std::sqrt(2.0), delta2 = 1.0 - std::sqrt(2.0);
+
+        int n = z.size();
+        int stride = eos.getComponentParameters().Tc.size();
+        const double* b = eos.getComponentParameters().b.data();
+
+        eos.prepare(T, ws.eos);
+        const double* aij = ws.eos.aij.data();
+
+        double D = 0.0, Bm = 0.0;
+        for (int i = 0; i < n; i++) {
+            double sum = 0.0;
+            for (int j = 0; j < n; j++) sum += z[j] * aij[i * stride + j];
+            scratch.aSum[i] = sum;
+            D += z[i] * sum;
+            Bm += z[i] * b[i];
+        }
+
+        // Derivatives of g(V, B) = ln(1 - B / V) and f(V, B) = ln((V + d1 B) / (V + d2 B)) / (R B (d1 - d2))
+        // in B at constant V, the mixed ones from the homogeneity of f
+        double VmB = V - Bm, d1V = V + delta1 * Bm, d2V = V + delta2 * Bm;
+
+        Mixture mixture;
+        mixture.D = D;
+
+        double g_B = -1.0 / VmB;
+        mixture.g_BB = -1.0 / (VmB * VmB);
+        mixture.g_BBB = -2.0 / (VmB * VmB * VmB);
+
+        double scale = 1.0 / (R * Bm * (delta1 - delta2));
+        double f = log(d1V / d2V) * scale;
+        mixture.f = f;
+        double f_V = -1.0 / (R * d1V * d2V);
+        double f_VV = (1.0 / (d2V * d2V) - 1.0 / (d1V * d1V)) * scale;
+        double f_VVV = -2.0 * (1.0 / (d2V * d2V * d2V) - 1.0 / (d1V * d1V * d1V)) * scale;
+        double f_BV = -(2.0 * f_V + V * f_VV) / Bm;
+        double f_BVV = -(3.0 * f_VV + V * f_VVV) / Bm;
+        double f_BBV = -(3.0 * f_BV + V * f_BVV) / Bm;
+        mixture.f_B = -(f + V * f_V) / Bm;
+        mixture.f_BB = -(2.0 * mixture.f_B + V * f_BV) / Bm;
+        mixture.f_BBB = -(3.0 * mixture.f_BB + V * f_BBV) / Bm;
+
+        double F_nB = -g_B;
+        double F_BD = -mixture.f_B / T;
+        double F_BB = -mixture.g_BB - D / T * mixture.f_BB;
+        double F_D = -f / T;
+
+        double* Q = scratch.Q;
+        const double* aSum = scratch.aSum;
+        for (int i = 0; i < n; i++) {
+            double si = sqrt(z[i]);
+            for (int j = i; j < n; j++) {
+                double F_ij = F_nB * (b[i] + b[j])
+                    + F_BD * 2.0 * (b[i] * aSum[j] + b[j] * aSum[i])
+                    + F_BB * b[i] * b[j]
+                    + F_D * 2.0 * aij[i * stride + j];
+                Q[i * n + j] = si * sqrt(z[j]) * F_ij + (i == j ? 1.0 : 0.0);
+                Q[j * n + i] = Q[i * n + j];
+            }
+        }
+
+        return mixture;
+    }
+
+    /*
+    Smallest eigenvalue `lambda` of the scaled Q, its temperature derivative
+    `lambdaT` at constant V and cubic form `C` along its eigenvector, at (T, V)
+    for one mole of feed. Without `follow`, the eigenpair comes from the Jacobi
+    method and the largest |dn_i| is made positive; with it, inverse iteration
+    refines the reference direction. The direction dn is left in the scratch.
+
+    With l_i = d ln a_i / dT, d a_ij / dT = a_ij (l_i + l_j) / 2 plus the k_ij(T)
+    term of the temperature-dependent pairs, and only F_BD = -f_B / T,
+    F_BB = -g_BB - D / T f_BB and F_D = -f / T, D and a_ij depend on T in F_ij.
+    */
+    void evaluate(const std::vector<double>& z, double T, double V, Scratch& scratch, bool follow, Workspace& ws, double& lambda, double& C, double& lambdaT) const {
+        int n = z.size();
+        int stride = eos.getComponentParameters().Tc.size();
+        const double* b = eos.getComponentParameters().b.data();
+
+        Mixture mixture = assemble(z, T, V, scratch, ws);
+        const double* aij = ws.eos.aij.data();
+        const double* aSum = scratch.aSum;
+        double* dn = scratch.dn;
+
+        if (!follow || !inverseIteration(z, scratch, lambda)) {
+            LinearAlgebra::symmetricEigen(scratch.Q, n, scratch.values, scratch.work);
+
+            int k = std::min_element(scratch.values, scratch.values + n) - scratch.values;
+            lambda = scratch.values[k];
+
+            int largest = 0;
+            double dot = 0.0;
+            for (int i = 0; i < n; i++) {
+                dn[i] = sqrt(z[i]) * scratch.work[i * n + k];
+                if (std::abs(dn[i]) > std::abs(dn[largest])) largest = i;
+                if (follow && z[i] > 0.0) dot += dn[i] * scratch.reference[i] / z[i];
+            }
+            if (follow ? dot < 0.0 : dn[largest] < 0.0) {
+                for (int i = 0; i < n; i++) dn[i] = -dn[i];
+            }
+        }
+
+        eos.prepareDerivatives(T, ws.eos);
+        const double* dlnadT = ws.eos.dlnadT.data();
+
+        // dDT = 2 sum_ij dn_i d a_ij / dT z_j, a3T = sum_ij dn_i dn_j d a_ij / dT and DT = d D / dT
+        double ideal = 0.0, s = 0.0, beta = 0.0, dD = 0.0, a3 = 0.0;
+        double dDT = 0.0, a3T = 0.0, DT = 0.0;
+        for (int i = 0; i < n; i++) {
+            if (z[i] > 0.0) ideal += dn[i] * dn[i] * dn[i] / (z[i] * z[i]);
+            s += dn[i];
+            beta += b[i] * dn[i];
+            dD += 2.0 * dn[i] * aSum[i];
+
+            double sum = 0.0;
+            for (int j = 0; j < n; j++) sum += aij[i * stride + j] * dn[j];
+            a3 += dn[i] * sum;
+
+            dDT += dlnadT[i] * (dn[i] * aSum[i] + z[i] * sum);
+            a3T += dlnadT[i] * dn[i] * sum;
+            DT += dlnadT[i] * z[i] * aSum[i];
+        }
+
+        const auto& pairs = eos.getTemperatureDependentKij();
+        for (std::size_t k = 0; k < pairs.size(); k++) {
+            int i = pairs[k].i, j = pairs[k].j;
+            if (i >= n || j >= n) continue;
+            double daij = ws.eos.daijdT[k];
+            dDT += 2.0 * daij * (dn[i] * z[j] + dn[j] * z[i]);
+            a3T += 2.0 * daij * dn[i] * dn[j];
+            DT += 2.0 * daij * z[i] * z[j];
+        }
+
+        double beta2 = beta * beta, beta3 = beta2 * beta;
+        C = -ideal - 3.0 * mixture.g_BB * s * beta2 - mixture.g_BBB * beta3
+            - 3.0 * mixture.f_BB / T * beta2 * dD - mixture.D / T * mixture.f_BBB * beta3
+            - 6.0 * mixture.f_B / T * beta * a3;
+
+        double T2 = T * T;
+        lambdaT = 2.0 * mixture.f_B / T2 * beta * dD - 2.0 * mixture.f_B / T * beta * dDT
+            - (DT / T - mixture.D / T2) * mixture.f_BB * beta2
+            + 2.0 * mixture.f / T2 * a3 - 2.0 * mixture.f / T * a3T;
+    }
+
+    // Inverse iteration on the scaled Q from the reference direction, with the Rayleigh quotient as eigenvalue
+    bool inverseIteration(const std::vector<double>& z, Scratch& scratch, double& lambda) const {
+        int n = z.size();
+        const double* Q = scratch.Q;
+        double* u = scratch.values;
+        double* dn = scratch.dn;
+
+        double norm = 0.0;
+        for (int i = 0; i < n; i++) {
+            u[i] = z[i] > 0.0 ? scratch.reference[i] / sqrt(z[i]) : 0.0;
+            norm += u[i] * u[i];
+        }
+
+        std::copy(Q, Q + n * n, scratch.work);
+        if (LinearAlgebra::factorize(scratch.work, n, scratch.pivots) == 0) return false;
+
+        bool converged = false;
+        for (int k = 0; k < 20 && !converged; k++) {
+            norm = sqrt(norm);
+            for (int i = 0; i < n; i++) dn[i] = u[i] / norm;
+
+            std::copy(dn, dn + n, u);
+            LinearAlgebra::substitute(scratch.work, u, n, scratch.pivots);
+
+            double dot = 0.0;
+            norm = 0.0;
+            for (int i = 0; i < n; i++) {
+                dot += u[i] * dn[i];
+                norm += u[i] * u[i];
+            }
+            if (!std::isfinite(norm) || norm == 0.0) return false;
+
+            // Converged once the new direction matches the previous one
+            double sign = dot < 0.0 ? -1.0 : 1.0;
+            double change = 0.0;
+            for (int i = 0; i < n; i++) {
+                change = std::max(change, std::abs(sign * u[i] / sqrt(norm) - dn[i]));
+            }
+            converged = change < 1e-12;
+        }
+        if (!converged) return false;
+
+        norm = sqrt(norm);
+        double sign = 0.0;
+        for (int i = 0; i < n; i++) {
+            u[i] /= norm;
+            if (z[i] > 0.0) sign += u[i] * scratch.reference[i] / sqrt(z[i]);
+        }
+        sign = sign < 0.0 ? -1.0 : 1.0;
+
+        lambda = 0.0;
+        for (int i = 0; i < n; i++) {
+            double sum = 0.0;
+            for (int j = 0; j < n; j++) sum += Q[i * n + j] * u[j];
+            lambda += u[i] * sum;
+            dn[i] = sign * sqrt(z[i]) * u[i];
+        }
+
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef FIXEDMIXTURE
+#define FIXEDMIXTURE
+
+#include "PengRobinson.cpp"
+#include "../include/ComponentRegistry.hpp"
+#include "../include/RootFinding.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*
+Peng-Robinson EoS specialized for a mixture of exactly N components. The
+parameters live in `std::array`s and every loop has a compile-time trip count,
+so the compiler can fully unroll and vectorize the a_mix quadratic form. Use
+`PengRobinsonEOS` for mixtures whose size is only known at run time.
+
+The object is immutable once built and `compressibilityFactor` only uses the
+stack, so it can be shared between threads.
+*/
+template <std::size_t N>
+class FixedMixture {
+private:
+    static constexpr double R = 8.3145;
+
+    bool volumeTranslation;
+    std::array<double, N> Tc;
+    std::array<double, N> kappa;
+    std::array<double, N> sqrtAc; // sqrt(0.45724 R^2 Tc^2 / Pc)
+    std::array<double, N> b;
+    std::array<double, N> c;
+    std::array<double, N * N> oneMinusKij; // Row-major 1 - k_ij
+    std::vector<PengRobinsonEOS::TemperatureDependentKij> temperatureDependentKij;
+
+public:
+    // Copy the parameters of a PR EoS built for the same N components
+    explicit FixedMixture(const PengRobinsonEOS& eos) : volumeTranslation(eos.hasVolumeTranslation()) {
+        const PengRobinsonEOS::ComponentParameters& parameters = eos.getComponentParameters();
+        const std::vector<double>& kij = eos.getKijMatrix();
+
+        if (parameters.Tc.size() != N) {
+            throw std::invalid_argument("The EoS has " + std::to_string(parameters.Tc.size()) + " components, expected " + std::to_string(N) + ".");
+        }
+
+        for (std::size_t i = 0; i < N; i++) {
+            Tc[i] = parameters.Tc[i];
+            kappa[i] = parameters.kappa[i];
+            sqrtAc[i] = std::sqrt(parameters.ac[i]);
+            b[i] = parameters.b[i];
+            c[i] = parameters.c[i];
+        }
+
+        for (std::size_t k = 0; k < N * N; k++) {
+            oneMinusKij[k] = 1.0 - kij[k];
+        }
+
+        temperatureDependentKij = eos.getTemperatureDependentKij();
+    }
+
+    FixedMixture(
+        const std::vector<std::string>& gasNames,
+        const bool withVolumeTranslation = true,
+        const ComponentRegistry& registry = ComponentRegistry::instance())
+        : FixedMixture(PengRobinsonEOS(gasNames, withVolumeTranslation, registry)) {}
+
+    // Compute the attraction parameter a_mix(T) of the mixing rule
+    double attractionParameter(double temperature, const std::array<double, N>& moleFractions) const {
+        std::array<double, N> y; // x_i sqrt(a_i(T))
+
+        for (std::size_t i = 0; i < N; i++) {
+            double sqrtAlpha = 1.0 + kappa[i] * (1.0 - std::sqrt(temperature / Tc[i]));
+            y[i] = moleFractions[i] * sqrtAc[i] * sqrtAlpha;
+        }
+
+        // k_ij is symmetric: a_mix = sum_i y_i (y_i + 2 sum_{j > i} (1 - k_ij) y_j)
+        double a_mix = 0.0;
+        for (std::size_t i = 0; i < N; i++) {
+            double sum = 0.0;
+            for (std::size_t j = i + 1; j < N; j++) {
+                sum += oneMinusKij[i * N + j] * y[j];
+            }
+            a_mix += y[i] * (y[i] + 2.0 * sum);
+        }
+
+        for (const auto& item : temperatureDependentKij) {
+            a_mix += 2.0 * y[item.i] * y[item.j] * (1.0 - item.table.kij(temperature) - oneMinusKij[item.i * N + item.j]);
+        }
+
+        return a_mix;
+    }
+
+    // Compute the compressibility factor Z, as `PengRobinsonEOS::compressibilityFactor`
+    double compressibilityFactor(double pressure, double temperature, const std::array<double, N>& moleFractions) const {
+        double a_mix = attractionParameter(temperature, moleFractions);
+        double b_mix = 0.0, c_mix = 0.0;
+
+        for (std::size_t i = 0; i < N; i++) {
+            b_mix += moleFractions[i] * b[i];
+            c_mix += moleFractions[i] * c[i];
+        }
+
+        double A = a_mix * pressure / (R * R * temperature * temperature);
+        double B = b_mix * pressure / (R * temperature);
+
+        double z_roots[3];
+        int nRoots = RootFind::cubicRoots(-A * B + B * B + B * B * B, A - 3.0 * B * B - 2.0 * B, B - 1.0, z_roots);
+
+        double Z = std::max(0.0, z_roots[nRoots - 1]);
+
+        if (volumeTranslation) {
+            Z -= c_mix / R / temperature * pressure;
+        }
+
+        return Z;
+    }
+};
+
+#endif
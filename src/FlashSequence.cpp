@@ -0,0 +1,135 @@
+#ifndef FLASHSEQUENCE
+#define FLASHSEQUENCE
+
+#include "PTFlash.cpp"
+#include <cmath>
+#include <vector>
+
+/*
+Flash of one stream marched through close (P, T) states, as along a
+pipeline or a well profile.
+
+Each state starts from the solution of the previous one. After a two-phase
+state, ln K and the vapor fraction are extrapolated along the last step and
+Newton may start at the first iteration. After a single-phase state, the stability analysis
+starts from its previous stationary points. The cold path of
+`PTFlash::flash` only runs when the number of phases changes.
+*/
+class FlashSequence {
+public:
+    PTFlash flash;        // Options of the underlying flash
+    int warmStarts = 0;   // States solved from the previous one
+    int coldStarts = 0;   // States where the number of phases changed, or the first one
+
+    explicit FlashSequence(const PengRobinsonEOS& eos) : flash(eos) {
+        flash.stability.reuseTrialPhases = true;
+        ws = flash.createWorkspace();
+    }
+
+    // Flash the next state, the returned result is overwritten by the next call
+    const FlashResult& next(double pressure, double temperature, const std::vector<double>& z) {
+        if (hasPrevious && result.nPhases == 2) {
+            predict(pressure, temperature);
+            flash.solveFromK(pressure, temperature, z, result, ws, true);
+
+            if (result.nPhases == 2) {
+                record(pressure, temperature, true);
+                warmStarts++;
+                return result;
+            }
+
+            // Stationary points from before the two-phase stretch are stale
+            ws.stability.hasVaporLnW = false;
+            ws.stability.hasLiquidLnW = false;
+        } else if (hasPrevious) {
+            flash.flash(pressure, temperature, z, result, ws);
+            record(pressure, temperature, false);
+
+            if (result.nPhases == 1) {
+                warmStarts++;
+            } else {
+                coldStarts++;
+            }
+            return result;
+        }
+
+        flash.flash(pressure, temperature, z, result, ws);
+        record(pressure, temperature, false);
+        coldStarts++;
+        hasPrevious = true;
+
+        return result;
+    }
+
+    // Forget the previous state, before marching a different stream
+    void reset() {
+        hasPrevious = false;
+        hasStep = false;
+        ws.stability.hasCache = false;
+        ws.stability.hasVaporLnW = false;
+        ws.stability.hasLiquidLnW = false;
+    }
+
+private:
+    PTFlash::Workspace ws;
+    FlashResult result;
+    bool hasPrevious = false;
+
+    // Last two-phase state and the step that led to it, relative in P and T
+    double lastPressure = 0.0;
+    double lastTemperature = 0.0;
+    double lastBeta = 0.0;
+    std::vector<double> lastLnK;
+    bool hasStep = false;
+    double stepPressure = 0.0;
+    double stepTemperature = 0.0;
+    double stepBeta = 0.0;
+    std::vector<double> stepLnK;
+
+    void record(double pressure, double temperature, bool continued) {
+        if (result.nPhases != 2) {
+            hasStep = false;
+            return;
+        }
+
+        int n = result.K.size();
+        lastLnK.resize(n);
+        stepLnK.resize(n);
+
+        for (int i = 0; i < n; i++) {
+            double lnK = log(result.K[i]);
+            stepLnK[i] = lnK - lastLnK[i];
+            lastLnK[i] = lnK;
+        }
+        stepPressure = pressure / lastPressure - 1.0;
+        stepTemperature = temperature / lastTemperature - 1.0;
+        stepBeta = result.vaporFraction - lastBeta;
+        hasStep = continued;
+
+        lastPressure = pressure;
+        lastTemperature = temperature;
+        lastBeta = result.vaporFraction;
+    }
+
+    // Extrapolate ln K and the vapor fraction along the last step, when the new state
+    // lies ahead on the same direction. Otherwise `result` keeps the last solution
+    void predict(double pressure, double temperature) {
+        if (!hasStep) return;
+
+        double norm = stepPressure * stepPressure + stepTemperature * stepTemperature;
+        if (norm <= 0.0) return;
+
+        double ratio = ((pressure / lastPressure - 1.0) * stepPressure + (temperature / lastTemperature - 1.0) * stepTemperature) / norm;
+        if (ratio <= 0.0 || ratio > 2.0) return;
+
+        int n = result.K.size();
+        for (int i = 0; i < n; i++) {
+            result.K[i] = exp(lastLnK[i] + ratio * stepLnK[i]);
+        }
+
+        double beta = lastBeta + ratio * stepBeta;
+        if (beta > 0.0 && beta < 1.0) result.vaporFraction = beta;
+    }
+};
+
+#endif
@@ -56,12 +56,7 @@ namespace GasConstants {
                 D = 0.0;
             }
 
-            gas.idealGasHeatCapacityPolyCoeffs = {
-                {"A", A},
-                {"B", B},
-                {"C", C},
-                {"D", D}
-            };
+            gas.idealGasHeatCapacityPolyCoeffs = {A, B, C, D};
 
             gases.push_back(gas);
         }
@@ -81,4 +76,9 @@ namespace GasConstants {
         throw std::invalid_argument("Could not find a gas with the identifier " + identifier);
     }
 
+    double idealGasHeatCapacityIntegral(const std::array<double, 4>& coeffs, double temperature) {
+        double T = temperature;
+        return T * (coeffs[0] + T * (coeffs[1] / 2.0 + T * (coeffs[2] / 3.0 + T * coeffs[3] / 4.0)));
+    }
+
 }
\ No newline at end of file
@@ -1,42 +1,59 @@
 #ifndef IDEALGASEOS
 #define IDEALGASEOS
 
+#include "../include/ComponentRegistry.hpp"
 #include "../include/EquationOfState.hpp"
 #include "../include/GasProperties.hpp"
+#include <array>
 #include <iostream>
-#include <filesystem>
 #include <string>
 #include <vector>
 
 class IdealGasEOS : public EquationOfState {
     private:
         double R = 8.3145;
-        std::vector<GasConstants::GasProperties> gasesProperties;
+        std::vector<ComponentId> componentIds;
+        std::vector<const GasConstants::GasProperties*> gasesProperties;
 
-        void loadGasProperties(const std::vector<std::string>& gasNames) {
-            std::filesystem::path filePath = "utils/databases/chemsepdb.json";
-            auto gases = GasConstants::parseGasProperties(filePath.string());
-            GasConstants::GasProperties gas;
-            
+        // Reference temperature of the enthalpy (in K)
+        static constexpr double T0 = 298.15;
+
+        // Integrated heat capacity coefficients {A, B/2, C/3, D/4} and their
+        // integral at T0, so that Hid(T) = sum_k coeffs[k] T^(k+1) - integral(T0)
+        std::vector<std::array<double, 4>> enthalpyCoeffs;
+        std::vector<double> referenceEnthalpy;
+
+        void loadGasProperties(const std::vector<std::string>& gasNames, const ComponentRegistry& registry) {
             for (const std::string& gasName : gasNames) {
-                gas = GasConstants::getGasProperties(gases, gasName);
-                gasesProperties.push_back(gas);
+                ComponentId id = registry.componentId(gasName);
+                componentIds.push_back(id);
+                gasesProperties.push_back(&registry.gas(id));
+
+                const auto& cp = registry.gas(id).idealGasHeatCapacityPolyCoeffs;
+                enthalpyCoeffs.push_back({cp[0], cp[1] / 2.0, cp[2] / 3.0, cp[3] / 4.0});
+                referenceEnthalpy.push_back(GasConstants::idealGasHeatCapacityIntegral(cp, T0));
             }
         }
 
     public:
-        IdealGasEOS(const std::vector<std::string>& gasNames) {
-            loadGasProperties(gasNames);
+        IdealGasEOS(const std::vector<std::string>& gasNames, const ComponentRegistry& registry = ComponentRegistry::instance()) {
+            loadGasProperties(gasNames, registry);
         }
 
-        std::vector<GasConstants::GasProperties> getGasesProperties() { return gasesProperties; }
+        std::vector<ComponentId> getComponentIds() { return componentIds; }
+
+        std::vector<GasConstants::GasProperties> getGasesProperties() {
+            std::vector<GasConstants::GasProperties> gases;
+            for (const auto* gas : gasesProperties) gases.push_back(*gas);
+            return gases;
+        }
 
         double averageMolarWeight(const std::vector<double>& moleFractions) const override {
             double mW = 0.0;
             int nComponents = moleFractions.size();
 
             for (int i = 0; i < nComponents; i++) {
-                mW += moleFractions[i] * gasesProperties[i].molecularWeight;
+                mW += moleFractions[i] * gasesProperties[i]->molecularWeight;
             }
 
             return mW;
@@ -67,22 +84,17 @@ class IdealGasEOS : public EquationOfState {
 
         double enthalpy(double pressure, double temperature, const std::vector<double>& moleFractions, UnitBase unit) const override {
             int nComponents = moleFractions.size();
-            float MW = averageMolarWeight(moleFractions);
-            std::vector<double> A(nComponents), B(nComponents), C(nComponents), D(nComponents), Hid(nComponents);
-            double T0 = 298.15, Hm = 0.0;
+            double MW = averageMolarWeight(moleFractions);
+            double T = temperature, T2 = T * T, T3 = T2 * T, T4 = T3 * T, Hm = 0.0;
 
             for (int i = 0; i < nComponents; i++) {
-                A[i] = gasesProperties[i].idealGasHeatCapacityPolyCoeffs.at("A");
-                B[i] = gasesProperties[i].idealGasHeatCapacityPolyCoeffs.at("B");
-                C[i] = gasesProperties[i].idealGasHeatCapacityPolyCoeffs.at("C");
-                D[i] = gasesProperties[i].idealGasHeatCapacityPolyCoeffs.at("D");
-
-                Hid[i] = A[i] * temperature + B[i] * temperature * temperature / 2.0 + C[i] * temperature * temperature * temperature / 3.0 + D[i] * temperature * temperature * temperature * temperature / 4.0;
-                Hid[i] -= A[i] * T0 + B[i] * T0 * T0 / 2.0 + C[i] * T0 * T0 * T0 / 3.0 + D[i] * T0 * T0 * T0 * T0 / 4.0;
-                Hid[i] /= MW;
+                const auto& c = enthalpyCoeffs[i];
+                double Hid = c[0] * T + c[1] * T2 + c[2] * T3 + c[3] * T4 - referenceEnthalpy[i];
 
-                Hm += Hid[i] * (moleFractions[i] * gasesProperties[i].molecularWeight / MW);
+                Hm += Hid * moleFractions[i] * gasesProperties[i]->molecularWeight;
             }
+            Hm /= MW * MW;
+
             return Hm;
             // if (unit == UnitBase::MOLAR) {
             //     return Hm;
@@ -1,6 +1,11 @@
 #include "../include/InteractionParameters.hpp"
 #include "../include/json.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
 #include <fstream>
+#include <limits>
 #include <iostream>
 #include <stdexcept>
 #include <string>
@@ -28,6 +33,8 @@ namespace BinaryIPs {
             auxIP.Name_1 = item.value("Name_1", "");
             auxIP.Name_2 = item.value("Name_2", "");
             auxIP.k12 = std::stod(item.value("k12", "0.0"));
+            auxIP.Comments = item.value("Comments", "");
+            parseTemperatureRange(auxIP.Comments, auxIP.minTemperature, auxIP.maxTemperature);
 
             gasesIPs.push_back(auxIP);
         }
@@ -53,4 +60,229 @@ namespace BinaryIPs {
         throw std::invalid_argument("Could not find the BIPs for the pair " + id_1 + ", " + id_2 + ".");
     }
 
+    bool parseTemperatureRange(const std::string& comments, double& minTemperature, double& maxTemperature) {
+        minTemperature = std::numeric_limits<double>::quiet_NaN();
+        maxTemperature = std::numeric_limits<double>::quiet_NaN();
+
+        std::size_t pos = comments.find("T=");
+        while (pos != std::string::npos && pos > 0 && std::isupper(static_cast<unsigned char>(comments[pos - 1]))) {
+            pos = comments.find("T=", pos + 2);
+        }
+        if (pos == std::string::npos) return false;
+
+        // Values are separated by '-' (range) or ',' (list of data temperatures)
+        const char* begin = comments.c_str() + pos + 2;
+        const char* end = begin;
+        double low = std::numeric_limits<double>::infinity();
+        double high = -std::numeric_limits<double>::infinity();
+
+        while (true) {
+            char* next;
+            double value = std::strtod(end, &next);
+            if (next == end || *end == '-' || *end == '+') break;
+
+            low = std::min(low, value);
+            high = std::max(high, value);
+            end = next;
+
+            if (*end != '-' && *end != ',') break;
+            end++;
+        }
+
+        if (low > high) return false;
+
+        while (*end == ' ') end++;
+        if (*end == 'F' && (end[1] == '\0' || end[1] == ' ' || end[1] == ',')) {
+            low = (low - 32.0) * 5.0 / 9.0 + 273.15;
+            high = (high - 32.0) * 5.0 / 9.0 + 273.15;
+        }
+
+        minTemperature = low;
+        maxTemperature = high;
+
+        return true;
+    }
+
+    double KijTable::kij(double temperature) const {
+        double value, first, second;
+        evaluate(temperature, value, first, second);
+
+        return value;
+    }
+
+    double KijTable::slope(double temperature) const {
+        double value, first, second;
+        evaluate(temperature, value, first, second);
+
+        return first;
+    }
+
+    double KijTable::curvature(double temperature) const {
+        double value, first, second;
+        evaluate(temperature, value, first, second);
+
+        return second;
+    }
+
+    void KijTable::evaluate(double temperature, double& value, double& first, double& second) const {
+        first = 0.0;
+        second = 0.0;
+
+        if (temperatures.empty() || temperature <= temperatures.front() - KIJ_SMOOTHING) {
+            value = below;
+            return;
+        }
+        if (temperature >= temperatures.back() + KIJ_SMOOTHING) {
+            value = above;
+            return;
+        }
+
+        // Segment between the last knot at or below the temperature, after the step of a repeated knot, and the next one
+        std::size_t hi = std::upper_bound(temperatures.begin(), temperatures.end(), temperature) - temperatures.begin();
+        double start, end, width, u;
+
+        if (hi == 0) {
+            start = below;
+            end = values.front();
+            width = KIJ_SMOOTHING;
+            u = temperature - (temperatures.front() - KIJ_SMOOTHING);
+        } else if (hi == temperatures.size()) {
+            start = values.back();
+            end = above;
+            width = KIJ_SMOOTHING;
+            u = temperature - temperatures.back();
+        } else {
+            start = values[hi - 1];
+            end = values[hi];
+            width = temperatures[hi] - temperatures[hi - 1];
+            u = temperature - temperatures[hi - 1];
+        }
+
+        // Cubic with zero slope at both ends, constant inside a range
+        double s = u / width;
+        double jump = end - start;
+        value = start + jump * s * s * (3.0 - 2.0 * s);
+        first = 6.0 * jump * s * (1.0 - s) / width;
+        second = 6.0 * jump * (1.0 - 2.0 * s) / (width * width);
+
+        // Triangular kernel over the steps at both ends of the segment, the kernels of adjacent steps never overlap
+        if (hi >= 2 && temperatures[hi - 2] == temperatures[hi - 1]) {
+            double w = stepWidth(hi - 2);
+            double x = temperature - temperatures[hi - 1];
+
+            if (x < w) {
+                double step = values[hi - 1] - values[hi - 2];
+                double r = (w - x) / w;
+                value -= 0.5 * step * r * r;
+                first += step * r / w;
+                second -= step / (w * w);
+            }
+        }
+        if (hi + 1 < temperatures.size() && temperatures[hi] == temperatures[hi + 1]) {
+            double w = stepWidth(hi);
+            double x = temperatures[hi] - temperature;
+
+            if (x < w) {
+                double step = values[hi + 1] - values[hi];
+                double r = (w - x) / w;
+                value += 0.5 * step * r * r;
+                first += step * r / w;
+                second += step / (w * w);
+            }
+        }
+    }
+
+    double KijTable::stepWidth(std::size_t k) const {
+        double width = KIJ_SMOOTHING;
+        if (k > 0) width = std::min(width, 0.5 * (temperatures[k] - temperatures[k - 1]));
+        if (k + 2 < temperatures.size()) width = std::min(width, 0.5 * (temperatures[k + 2] - temperatures[k + 1]));
+
+        return width;
+    }
+
+    KijTable buildKijTable(const std::vector<const InteractionParameter*>& records) {
+        std::vector<const InteractionParameter*> ranged;
+        const InteractionParameter* unranged = nullptr;
+        std::vector<double> endpoints;
+
+        for (const auto* item : records) {
+            if (std::isnan(item->minTemperature)) {
+                if (!unranged) unranged = item;
+            } else {
+                ranged.push_back(item);
+                endpoints.push_back(item->minTemperature);
+                endpoints.push_back(item->maxTemperature);
+            }
+        }
+
+        std::sort(endpoints.begin(), endpoints.end());
+        endpoints.erase(std::unique(endpoints.begin(), endpoints.end()), endpoints.end());
+
+        // Knots of the elementary intervals covered by at least one range
+        std::vector<std::pair<double, double>> knots;
+        for (std::size_t a = 0; a + 1 < endpoints.size(); a++) {
+            const InteractionParameter* best = nullptr;
+
+            for (const auto* item : ranged) {
+                if (item->minTemperature <= endpoints[a] && item->maxTemperature >= endpoints[a + 1]) {
+                    if (!best || item->maxTemperature - item->minTemperature < best->maxTemperature - best->minTemperature) {
+                        best = item;
+                    }
+                }
+            }
+
+            if (best) {
+                knots.emplace_back(endpoints[a], best->k12);
+                knots.emplace_back(endpoints[a + 1], best->k12);
+            }
+        }
+
+        // Single temperature fits only matter outside the wider ranges, the first one wins at a temperature
+        for (std::size_t k = 0; k < ranged.size(); k++) {
+            const auto* item = ranged[k];
+            if (item->minTemperature != item->maxTemperature) continue;
+
+            bool covered = false;
+            for (std::size_t m = 0; m < ranged.size(); m++) {
+                const auto* other = ranged[m];
+                if ((other->minTemperature < other->maxTemperature || m < k)
+                    && other->minTemperature <= item->minTemperature
+                    && other->maxTemperature >= item->minTemperature) {
+                    covered = true;
+                }
+            }
+
+            if (!covered) knots.emplace_back(item->minTemperature, item->k12);
+        }
+
+        std::stable_sort(knots.begin(), knots.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+        knots.erase(std::unique(knots.begin(), knots.end()), knots.end());
+
+        // A knot inside a run of equal values would narrow the blends of the steps next to it
+        KijTable table;
+        for (std::size_t k = 0; k < knots.size(); k++) {
+            if (k > 0 && k + 1 < knots.size()
+                && knots[k - 1].second == knots[k].second && knots[k + 1].second == knots[k].second
+                && knots[k - 1].first < knots[k].first && knots[k].first < knots[k + 1].first) {
+                continue;
+            }
+
+            table.temperatures.push_back(knots[k].first);
+            table.values.push_back(knots[k].second);
+        }
+
+        if (unranged) {
+            table.below = unranged->k12;
+            table.above = unranged->k12;
+        } else if (!knots.empty()) {
+            table.below = knots.front().second;
+            table.above = knots.back().second;
+        } else {
+            table.below = records.empty() ? 0.0 : records.front()->k12;
+            table.above = table.below;
+        }
+
+        return table;
+    }
+
 }
\ No newline at end of file
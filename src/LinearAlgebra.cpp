@@ -0,0 +1,172 @@
+// LinearAlgebra.cpp
+// Implementation of the dense linear solvers
+#include "../include/LinearAlgebra.hpp"
+#include <cmath>
+#include <utility>
+
+namespace LinearAlgebra {
+
+    int factorize(double* A, int n, int* pivots) {
+        int sign = 1;
+
+        for (int k = 0; k < n; k++) {
+            int p = k;
+            for (int i = k + 1; i < n; i++) {
+                if (std::abs(A[i * n + k]) > std::abs(A[p * n + k])) p = i;
+            }
+
+            pivots[k] = p;
+            if (A[p * n + k] == 0.0) return 0;
+
+            if (p != k) {
+                for (int j = 0; j < n; j++) std::swap(A[k * n + j], A[p * n + j]);
+                sign = -sign;
+            }
+
+            double inverse = 1.0 / A[k * n + k];
+            for (int i = k + 1; i < n; i++) {
+                double factor = A[i * n + k] * inverse;
+                A[i * n + k] = factor;
+                for (int j = k + 1; j < n; j++) {
+                    A[i * n + j] -= factor * A[k * n + j];
+                }
+            }
+        }
+
+        return sign;
+    }
+
+    void substitute(const double* A, double* b, int n, const int* pivots) {
+        for (int k = 0; k < n; k++) {
+            std::swap(b[k], b[pivots[k]]);
+        }
+
+        for (int i = 1; i < n; i++) {
+            double sum = b[i];
+            for (int j = 0; j < i; j++) {
+                sum -= A[i * n + j] * b[j];
+            }
+            b[i] = sum;
+        }
+
+        for (int i = n - 1; i >= 0; i--) {
+            double sum = b[i];
+            for (int j = i + 1; j < n; j++) {
+                sum -= A[i * n + j] * b[j];
+            }
+            b[i] = sum / A[i * n + i];
+        }
+    }
+
+    bool solve(double* A, double* b, int n, int* pivots) {
+        if (factorize(A, n, pivots) == 0) return false;
+
+        substitute(A, b, n, pivots);
+        return true;
+    }
+
+    bool solveSymmetric(double* A, double* b, int n) {
+        // Cholesky factor L, row by row: every inner product runs over two contiguous rows.
+        // The diagonal keeps 1 / L_ii, which turns the divisions into multiplications
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j <= i; j++) {
+                double sum = A[i * n + j];
+                for (int k = 0; k < j; k++) {
+                    sum -= A[i * n + k] * A[j * n + k];
+                }
+
+                if (i == j) {
+                    if (!(sum > 0.0)) return false;
+                    A[i * n + i] = 1.0 / std::sqrt(sum);
+                } else {
+                    A[i * n + j] = sum * A[j * n + j];
+                }
+            }
+        }
+
+        for (int i = 0; i < n; i++) {
+            double sum = b[i];
+            for (int j = 0; j < i; j++) {
+                sum -= A[i * n + j] * b[j];
+            }
+            b[i] = sum * A[i * n + i];
+        }
+
+        for (int i = n - 1; i >= 0; i--) {
+            b[i] *= A[i * n + i];
+            for (int j = 0; j < i; j++) {
+                b[j] -= A[i * n + j] * b[i];
+            }
+        }
+
+        return true;
+    }
+
+    double determinant(double* A, int n, int* pivots) {
+        int sign = factorize(A, n, pivots);
+        double det = sign;
+
+        for (int k = 0; sign != 0 && k < n; k++) {
+            det *= A[k * n + k];
+        }
+
+        return sign == 0 ? 0.0 : det;
+    }
+
+    bool symmetricEigen(double* A, int n, double* values, double* vectors, int maxSweeps) {
+        double norm = 0.0;
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                vectors[i * n + j] = i == j ? 1.0 : 0.0;
+                norm += A[i * n + j] * A[i * n + j];
+            }
+        }
+
+        bool converged = false;
+        for (int sweep = 0; sweep < maxSweeps; sweep++) {
+            double off = 0.0;
+            for (int i = 0; i < n; i++) {
+                for (int j = i + 1; j < n; j++) off += A[i * n + j] * A[i * n + j];
+            }
+            if (off <= 1e-30 * norm) {
+                converged = true;
+                break;
+            }
+
+            for (int p = 0; p < n; p++) {
+                for (int q = p + 1; q < n; q++) {
+                    double apq = A[p * n + q];
+                    if (apq == 0.0) continue;
+
+                    // Rotation by the smaller root t of t^2 + 2 theta t - 1 = 0, which zeroes A_pq
+                    double theta = (A[q * n + q] - A[p * n + p]) / (2.0 * apq);
+                    double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+                    double c = 1.0 / std::sqrt(t * t + 1.0), s = t * c;
+
+                    for (int k = 0; k < n; k++) {
+                        double akp = A[k * n + p], akq = A[k * n + q];
+                        A[k * n + p] = c * akp - s * akq;
+                        A[k * n + q] = s * akp + c * akq;
+                    }
+                    for (int k = 0; k < n; k++) {
+                        double apk = A[p * n + k], aqk = A[q * n + k];
+                        A[p * n + k] = c * apk - s * aqk;
+                        A[q * n + k] = s * apk + c * aqk;
+                    }
+                    for (int k = 0; k < n; k++) {
+                        double vkp = vectors[k * n + p], vkq = vectors[k * n + q];
+                        vectors[k * n + p] = c * vkp - s * vkq;
+                        vectors[k * n + q] = s * vkp + c * vkq;
+                    }
+                }
+            }
+        }
+
+        for (int i = 0; i < n; i++) {
+            values[i] = A[i * n + i];
+        }
+
+        return converged;
+    }
+
+}
@@ -0,0 +1,496 @@
+#ifndef MULTIPHASEFLASH
+#define MULTIPHASEFLASH
+
+#include "Stability.cpp"
+#include "../include/LinearAlgebra.hpp"
+#include "../include/RachfordRice.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+/*
+Struct to store the result of a multiphase flash.
+
+Fields:
+- `nPhases`: Number of phases present;
+- `phaseFractions`: Molar fraction of each phase;
+- `compositions`: Mole fractions of each phase, `compositions[k][i]` for the component i of the phase k;
+- `Z`: Compressibility factor of each phase;
+- `iterations`: Successive substitution plus Newton iterations, over all the numbers of phases tried;
+- `stabilityTests`: Stability analyses run;
+- `converged`: Whether the fugacity residual reached the tolerance and the last phase split is stable.
+
+Only the first `nPhases` entries are meaningful. Phases come by decreasing Z:
+a vapor first and the densest liquid, the aqueous one with free water, last.
+*/
+struct MultiphaseFlashResult {
+    int nPhases = 1;
+    std::vector<double> phaseFractions;
+    std::vector<std::vector<double>> compositions;
+    std::vector<double> Z;
+    int iterations = 0;
+    int stabilityTests = 0;
+    bool converged = false;
+};
+
+/*
+Isothermal flash into any number of phases, up to `maxPhases`, with the
+Peng-Robinson EoS.
+
+Phases are added one at a time. Once a split into M phases has converged,
+the stability analysis tests one of them, which tests them all since their
+fugacities are equal; an unstable trial phase becomes phase M + 1. A split
+found unstable with `maxPhases` phases already is returned unconverged. The
+analysis tries a nearly pure water phase after the Wilson ones, when
+`stability.waterIndex` names the water component.
+
+For a given number of phases, the K-values K_ij = phi_i0 / phi_ij relative to
+the largest phase are refined by successive substitution. The phase
+fractions solve the multiphase Rachford-Rice equations of Okuno, Johns and
+Sepehrnoori, see `RachfordRice::multiphase`, and a phase whose fraction
+turns negative is removed. Once the fugacity residual falls below
+`newtonSwitch`, the Gibbs energy is minimized by Newton's method on the mole
+numbers n_ij of the phases j > 0, whose gradient is
+    g_ij = ln f_ij - ln f_i0
+and Hessian, with A_j = (diag(1 / x_j) - 1 + n_T dlnphi_j/dn) / beta_j,
+    H = blockdiag(A_1, ..., A_M-1) + A_0 in every block.
+
+A feed with free water starts from three phases instead of one: a vapor, a
+hydrocarbon liquid with the Wilson K-values and an aqueous phase with the
+free-water K-values, K_w = P / P_sat,w from Wilson and 1e-6 for the other
+components. Phases that do not form are removed by the Rachford-Rice step.
+
+The workspace holds one set of buffers per possible phase, sized for all the
+components of the EoS. With a reused `Workspace` and `MultiphaseFlashResult`,
+a flash does not allocate.
+*/
+class MultiphaseFlash {
+public:
+    // Buffers of one phase
+    struct Phase {
+        std::vector<double> x;
+        std::vector<double> lnPhi;
+        PengRobinsonEOS::FugacityDerivatives derivatives;
+        double beta = 0.0;
+        double Z = 0.0;
+    };
+
+    // Scratch buffers of `flash`, must not be shared between threads. A workspace
+    // holds `maxPhases` phases, as set when it was created
+    struct Workspace {
+        PengRobinsonEOS::Workspace eos;
+        StabilityAnalysis::Workspace stability;
+        StabilityResult stabilityResult;
+        std::vector<Phase> phases;
+        std::vector<double> K;
+        std::vector<double> beta;
+        std::vector<double> g;
+        std::vector<double> hessian;
+        std::vector<double> moles;
+        std::vector<double> dn;
+        std::vector<int> pivots;
+        std::vector<int> order;
+    };
+
+    double tolerance = 1e-10;     // On max |ln f_ij - ln f_i0|
+    double newtonSwitch = 1e-2;   // Residual below which Newton takes over
+    int maxIterations = 300;      // Over all the numbers of phases tried
+    int maxPhases = 3;
+    StabilityAnalysis stability;  // Its `waterIndex` also enables the free-water start
+
+    explicit MultiphaseFlash(const PengRobinsonEOS& eos) : stability(eos), eos(eos) {}
+
+    Workspace createWorkspace() const {
+        int n = eos.getComponentParameters().Tc.size();
+        int m = std::max(1, maxPhases - 1);
+
+        Workspace ws;
+        ws.eos = eos.createWorkspace();
+        ws.stability = stability.createWorkspace();
+        ws.stabilityResult.K.reserve(n);
+        ws.stabilityResult.w.reserve(n);
+        ws.phases.resize(maxPhases);
+        for (Phase& phase : ws.phases) {
+            phase.x.reserve(n);
+            phase.lnPhi.reserve(n);
+            phase.derivatives.withTemperature = false;
+            phase.derivatives.dn.reserve(n * n);
+            phase.derivatives.dP.reserve(n);
+        }
+        ws.K.reserve(n * m);
+        ws.beta.reserve(m);
+        ws.g.reserve(n * m);
+        ws.hessian.reserve(n * m * n * m);
+        ws.moles.reserve(n * m);
+        ws.dn.reserve(n * m);
+        ws.pivots.reserve(n * m);
+        ws.order.reserve(maxPhases);
+        return ws;
+    }
+
+    MultiphaseFlashResult flash(double pressure, double temperature, const std::vector<double>& z) const {
+        Workspace ws = createWorkspace();
+        MultiphaseFlashResult result;
+        flash(pressure, temperature, z, result, ws);
+        return result;
+    }
+
+    void flash(double pressure, double temperature, const std::vector<double>& z, MultiphaseFlashResult& result, Workspace& ws) const {
+        int n = z.size();
+        int capacity = std::min<int>(maxPhases, ws.phases.size());
+
+        for (Phase& phase : ws.phases) {
+            phase.x.resize(n);
+            phase.lnPhi.resize(n);
+        }
+        ws.K.resize(n * std::max(1, capacity - 1));
+        ws.g.resize(n * std::max(1, capacity - 1));
+
+        result.iterations = 0;
+        result.stabilityTests = 0;
+        result.converged = false;
+
+        int M = seed(pressure, temperature, z, capacity, ws);
+
+        // Every phase added must lower the Gibbs energy, the limit only guards against cycling
+        for (int additions = 0; additions <= 2 * capacity; additions++) {
+            bool split = this->split(pressure, temperature, z, M, ws, result.iterations);
+            if (!split) break;
+
+            stability.analyze(pressure, temperature, ws.phases[0].x, ws.stabilityResult, ws.stability, ws.eos);
+            result.stabilityTests++;
+            if (ws.stabilityResult.stable) {
+                result.converged = true;
+                break;
+            }
+
+            // No room for the trial phase: the split is kept, but it is not the equilibrium
+            if (M >= capacity) break;
+
+            // The trial phase enters with a zero fraction, the Rachford-Rice step sizes it
+            Phase& phase = ws.phases[M];
+            std::copy(ws.stabilityResult.w.begin(), ws.stabilityResult.w.end(), phase.x.begin());
+            phase.beta = 0.0;
+            M++;
+        }
+
+        store(M, result, ws);
+    }
+
+private:
+    const PengRobinsonEOS& eos;
+
+    // Wilson correlation, K_i = Pc_i / P exp(5.373 (1 + w_i) (1 - Tc_i / T))
+    double wilsonK(double pressure, double temperature, int i) const {
+        const PengRobinsonEOS::ComponentParameters& parameters = eos.getComponentParameters();
+        return parameters.Pc[i] / pressure * exp(5.373 * (1.0 + parameters.omega[i]) * (1.0 - parameters.Tc[i] / temperature));
+    }
+
+    // Initial phases: the feed alone, or vapor, hydrocarbon liquid and free water. Returns their number
+    int seed(double pressure, double temperature, const std::vector<double>& z, int capacity, Workspace& ws) const {
+        int n = z.size();
+        ws.phases[0].beta = 1.0;
+        std::copy(z.begin(), z.end(), ws.phases[0].x.begin());
+
+        int water = stability.waterIndex;
+        if (water < 0 || water >= n || z[water] <= 0.0 || capacity < 3) return 1;
+
+        // K relative to the vapor: x_i / y_i = 1 / K_i in the hydrocarbon liquid, where water
+        // follows the vapor, and free water with x_w / y_w = P / P_sat,w
+        double* K = ws.K.data();
+        for (int i = 0; i < n; i++) {
+            double wilson = wilsonK(pressure, temperature, i);
+            K[i * 2] = i == water ? 1.0 : 1.0 / wilson;
+            K[i * 2 + 1] = i == water ? 1.0 / wilson : 1e-6;
+        }
+
+        ws.beta.assign(2, 0.0);
+        if (!RachfordRice::multiphase(z.data(), K, n, 2, ws.beta.data())) return 1;
+
+        compositions(z, 3, ws);
+        return 3;
+    }
+
+    // x_i0 = z_i / t_i and x_ij = K_ij x_i0, with t_i = 1 + sum_j beta_j (K_ij - 1), from ws.K and ws.beta
+    static void compositions(const std::vector<double>& z, int M, Workspace& ws) {
+        int n = z.size(), m = M - 1;
+        const double* K = ws.K.data();
+
+        double beta0 = 1.0;
+        for (int j = 0; j < m; j++) {
+            ws.phases[j + 1].beta = ws.beta[j];
+            beta0 -= ws.beta[j];
+        }
+        ws.phases[0].beta = beta0;
+
+        for (int i = 0; i < n; i++) {
+            double t = 1.0;
+            for (int j = 0; j < m; j++) t += ws.beta[j] * (K[i * m + j] - 1.0);
+
+            double x0 = z[i] / t;
+            ws.phases[0].x[i] = x0;
+            for (int j = 0; j < m; j++) {
+                ws.phases[j + 1].x[i] = K[i * m + j] * x0;
+            }
+        }
+    }
+
+    // Move phase k to the end of the M phases, which then count one less
+    static void removePhase(int k, int& M, Workspace& ws) {
+        for (int j = k; j < M - 1; j++) {
+            std::swap(ws.phases[j], ws.phases[j + 1]);
+        }
+        M--;
+    }
+
+    // Fill ln(phi) of every phase and g_ij = ln f_ij - ln f_i0, return max |g_ij|
+    double residual(double pressure, double temperature, const std::vector<double>& z, int M, Workspace& ws, bool withDerivatives) const {
+        int n = z.size();
+
+        for (int k = 0; k < M; k++) {
+            Phase& phase = ws.phases[k];
+            phase.Z = eos.lnPhi(pressure, temperature, phase.x, phase.lnPhi, ws.eos, PhaseRoot::STABLE, withDerivatives ? &phase.derivatives : nullptr);
+        }
+
+        double error = 0.0;
+        const Phase& reference = ws.phases[0];
+        for (int j = 1; j < M; j++) {
+            const Phase& phase = ws.phases[j];
+            for (int i = 0; i < n; i++) {
+                double g = 0.0;
+                if (z[i] > 0.0) {
+                    g = log(phase.x[i] / reference.x[i]) + phase.lnPhi[i] - reference.lnPhi[i];
+                }
+                ws.g[(j - 1) * n + i] = g;
+                error = std::max(error, std::abs(g));
+            }
+        }
+
+        return error;
+    }
+
+    /*
+    Converge the split into the M phases of the workspace, see the class
+    description. M decreases when a phase vanishes or two phases merge.
+    Returns false if the iteration budget ran out.
+    */
+    bool split(double pressure, double temperature, const std::vector<double>& z, int& M, Workspace& ws, int& iterations) const {
+        int n = z.size();
+        double error = std::numeric_limits<double>::infinity();
+        bool allowNewton = true;
+
+        while (iterations < maxIterations) {
+            if (M == 1) {
+                std::copy(z.begin(), z.end(), ws.phases[0].x.begin());
+                ws.phases[0].beta = 1.0;
+                ws.phases[0].Z = eos.lnPhi(pressure, temperature, z, ws.phases[0].lnPhi, ws.eos);
+                return true;
+            }
+
+            // The largest phase is the reference of the Rachford-Rice step
+            int largest = 0;
+            for (int k = 1; k < M; k++) {
+                if (ws.phases[k].beta > ws.phases[largest].beta) largest = k;
+            }
+            std::swap(ws.phases[0], ws.phases[largest]);
+
+            bool nearSolution = allowNewton && error < newtonSwitch;
+            error = residual(pressure, temperature, z, M, ws, nearSolution);
+            iterations++;
+
+            if (error < tolerance) return true;
+
+            if (nearSolution) {
+                if (newton(pressure, temperature, z, M, ws, iterations)) return true;
+                allowNewton = false;
+            }
+
+            // Successive substitution, ln K_ij = ln(phi_i0) - ln(phi_ij)
+            int m = M - 1;
+            ws.K.resize(n * m);
+            ws.beta.resize(m);
+            for (int j = 0; j < m; j++) {
+                const Phase& phase = ws.phases[j + 1];
+                for (int i = 0; i < n; i++) {
+                    ws.K[i * m + j] = exp(ws.phases[0].lnPhi[i] - phase.lnPhi[i]);
+                }
+                ws.beta[j] = phase.beta;
+            }
+
+            if (!RachfordRice::multiphase(z.data(), ws.K.data(), n, m, ws.beta.data())) return false;
+
+            // The phase with the most negative fraction leaves, the others keep their compositions
+            double beta0 = 1.0, lowest = 0.0;
+            int leaving = -1;
+            for (int j = 0; j < m; j++) {
+                beta0 -= ws.beta[j];
+                if (ws.beta[j] < lowest) {
+                    lowest = ws.beta[j];
+                    leaving = j + 1;
+                }
+            }
+            if (beta0 < lowest) leaving = 0;
+
+            if (leaving >= 0) {
+                for (int j = 0; j < m; j++) ws.phases[j + 1].beta = std::max(ws.beta[j], 0.0);
+                ws.phases[0].beta = std::max(beta0, 0.0);
+                removePhase(leaving, M, ws);
+                error = std::numeric_limits<double>::infinity();
+                continue;
+            }
+
+            compositions(z, M, ws);
+
+            // Two phases on the same composition merge
+            for (int j = 0; j < M; j++) {
+                for (int k = j + 1; k < M; k++) {
+                    double distance = 0.0;
+                    for (int i = 0; i < n; i++) {
+                        double d = ws.phases[j].x[i] - ws.phases[k].x[i];
+                        distance += d * d;
+                    }
+                    if (distance < 1e-10) {
+                        ws.phases[j].beta += ws.phases[k].beta;
+                        removePhase(k, M, ws);
+                        k--;
+                        error = std::numeric_limits<double>::infinity();
+                    }
+                }
+            }
+        }
+
+        return false;
+    }
+
+    /*
+    Newton's method on the mole numbers n_ij = beta_j x_ij of the phases j > 0,
+    for one mole of feed, see the class description. Returns true once
+    converged, false to fall back to successive substitution.
+
+    Expects `residual` to have been evaluated with derivatives.
+    */
+    bool newton(double pressure, double temperature, const std::vector<double>& z, int M, Workspace& ws, int& iterations) const {
+        int n = z.size(), m = M - 1, size = n * m;
+
+        ws.hessian.resize(size * size);
+        ws.moles.resize(size);
+        ws.dn.resize(size);
+        ws.pivots.resize(size);
+
+        for (int j = 0; j < m; j++) {
+            const Phase& phase = ws.phases[j + 1];
+            for (int i = 0; i < n; i++) {
+                ws.moles[j * n + i] = phase.beta * phase.x[i];
+            }
+        }
+
+        while (iterations < maxIterations) {
+            double* H = ws.hessian.data();
+            const Phase& reference = ws.phases[0];
+            const double* dn0 = reference.derivatives.dn.data();
+
+            // A_0 in every block, plus A_j on the diagonal blocks
+            for (int j = 0; j < m; j++) {
+                const Phase& phase = ws.phases[j + 1];
+                const double* dnj = phase.derivatives.dn.data();
+
+                for (int i = 0; i < n; i++) {
+                    double* row = H + (j * n + i) * size;
+
+                    // Components absent from the feed keep n_ij = 0
+                    if (z[i] <= 0.0) {
+                        std::fill(row, row + size, 0.0);
+                        row[j * n + i] = 1.0;
+                        ws.dn[j * n + i] = 0.0;
+                        continue;
+                    }
+
+                    for (int l = 0; l < m; l++) {
+                        for (int k = 0; k < n; k++) {
+                            double a0 = (dn0[i * n + k] - 1.0 + (i == k ? 1.0 / reference.x[i] : 0.0)) / reference.beta;
+                            if (z[k] <= 0.0) a0 = 0.0;
+                            row[l * n + k] = a0;
+                        }
+                    }
+                    for (int k = 0; k < n; k++) {
+                        if (z[k] <= 0.0) continue;
+                        row[j * n + k] += (dnj[i * n + k] - 1.0 + (i == k ? 1.0 / phase.x[i] : 0.0)) / phase.beta;
+                    }
+
+                    ws.dn[j * n + i] = -ws.g[j * n + i];
+                }
+            }
+
+            if (!LinearAlgebra::solve(H, ws.dn.data(), size, ws.pivots.data())) return false;
+
+            // Damp the step so that every n_ij and n_i0 = z_i - sum_j n_ij stays positive
+            double alpha = 1.0;
+            for (int i = 0; i < n; i++) {
+                if (z[i] <= 0.0) continue;
+
+                double n0 = z[i], dn0i = 0.0;
+                for (int j = 0; j < m; j++) {
+                    double nij = ws.moles[j * n + i], step = ws.dn[j * n + i];
+                    n0 -= nij;
+                    dn0i -= step;
+                    if (nij + step <= 0.0) alpha = std::min(alpha, -0.9 * nij / step);
+                }
+                if (n0 + dn0i <= 0.0) alpha = std::min(alpha, -0.9 * n0 / dn0i);
+            }
+
+            double beta0 = 1.0;
+            for (int j = 0; j < m; j++) {
+                double beta = 0.0;
+                for (int i = 0; i < n; i++) {
+                    ws.moles[j * n + i] += alpha * ws.dn[j * n + i];
+                    beta += ws.moles[j * n + i];
+                }
+                ws.phases[j + 1].beta = beta;
+                beta0 -= beta;
+                if (!(beta > 0.0)) return false;
+            }
+            ws.phases[0].beta = beta0;
+            if (!(beta0 > 0.0)) return false;
+
+            for (int i = 0; i < n; i++) {
+                double n0 = z[i];
+                for (int j = 0; j < m; j++) {
+                    double nij = ws.moles[j * n + i];
+                    ws.phases[j + 1].x[i] = nij / ws.phases[j + 1].beta;
+                    n0 -= nij;
+                }
+                ws.phases[0].x[i] = n0 / beta0;
+            }
+
+            double error = residual(pressure, temperature, z, M, ws, true);
+            iterations++;
+
+            if (error < tolerance) return true;
+        }
+
+        return false;
+    }
+
+    // Copy the M phases to the result, by decreasing Z
+    void store(int M, MultiphaseFlashResult& result, Workspace& ws) const {
+        ws.order.resize(M);
+        for (int k = 0; k < M; k++) ws.order[k] = k;
+        std::sort(ws.order.begin(), ws.order.end(), [&](int a, int b) { return ws.phases[a].Z > ws.phases[b].Z; });
+
+        result.nPhases = M;
+        result.phaseFractions.resize(std::max<std::size_t>(M, result.phaseFractions.size()));
+        result.Z.resize(std::max<std::size_t>(M, result.Z.size()));
+        if ((int)result.compositions.size() < M) result.compositions.resize(M);
+
+        for (int k = 0; k < M; k++) {
+            const Phase& phase = ws.phases[ws.order[k]];
+            result.phaseFractions[k] = phase.beta;
+            result.Z[k] = phase.Z;
+            result.compositions[k].assign(phase.x.begin(), phase.x.end());
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,426 @@
+#ifndef PHFLASH
+#define PHFLASH
+
+#include "PTFlash.cpp"
+#include "../include/LinearAlgebra.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+// State function specified together with the pressure
+enum class FlashSpecification {
+    ENTHALPY,
+    ENTROPY
+};
+
+/*
+Struct to store the result of a PH or PS flash.
+
+Fields:
+- `temperature`: Temperature where the feed meets the specification (in K);
+- `phases`: Phase split at `temperature`, as returned by `PTFlash`;
+- `iterations`: Temperature updates of the nested loop plus Newton iterations
+    of the direct method;
+- `flashes`: PT flashes run, the one at the initial temperature included;
+- `converged`: Whether the specification and the fugacity residual reached the tolerance.
+*/
+struct PHFlashResult {
+    double temperature = 0.0;
+    FlashResult phases;
+    int iterations = 0;
+    int flashes = 0;
+    bool converged = false;
+};
+
+/*
+Flash at specified pressure and enthalpy (PH) or entropy (PS), with the
+Peng-Robinson EoS. Enthalpies are in J/mol and entropies in J/mol/K, on the
+ideal gas reference of `PengRobinsonEOS::T0` and `PengRobinsonEOS::P0`, as
+returned by `value`.
+
+The nested method wraps a full PT flash in a loop on ln T. The update is a
+Newton step with the analytic dH/dT = Cp or dS/dT = Cp / T of the phases at
+frozen composition, exact for a single phase. Across a phase split the
+frozen slope misses the latent heat, so the step is kept inside the bracket
+of the previous temperatures by false position with the Illinois
+modification.
+
+The direct method of Michelsen solves the fugacity equations and the
+specification together. Two-phase states run Newton's method on the vapor
+mole numbers v_i and ln T, with the residuals of `PTFlash` plus
+    r = (H - H_spec) / RT    or    r = (S - S_spec) / R.
+From the partial molar properties of ln(phi), the new row of the Jacobian is
+    dr/dv_j = -T (dlnphi_j^V/dT - dlnphi_j^L/dT)    (enthalpy),
+    dr/dv_j = -g_j - T (dlnphi_j^V/dT - dlnphi_j^L/dT)    (entropy),
+    dr/dln T = Cp / R,
+and the new column is dg_i/dln T = T (dlnphi_i^V/dT - dlnphi_i^L/dT). A
+single phase only solves r = 0 in ln T, without PT flash, and is tested for
+stability once converged. When a phase vanishes during Newton, or the
+number of phases keeps changing, the direct method hands over to the nested
+one.
+
+The PR parameters cached per temperature in the workspace are shared by the
+PT flashes, the stability analysis and the residual properties, and the
+ideal gas heat capacity integrals start from the constants stored at
+construction. With a reused `Workspace` and `PHFlashResult`, a flash does
+not allocate.
+*/
+class PHFlash {
+public:
+    // Scratch buffers of `solve`, must not be shared between threads
+    struct Workspace {
+        PTFlash::Workspace flash;
+        PengRobinsonEOS::ResidualProperties residual;
+        PengRobinsonEOS::FugacityDerivatives liquidDerivatives;
+        PengRobinsonEOS::FugacityDerivatives vaporDerivatives;
+        std::vector<double> lnPhiL;
+        std::vector<double> lnPhiV;
+        std::vector<double> g;
+        std::vector<double> jacobian;
+        std::vector<double> dX;
+        std::vector<double> v;
+        std::vector<int> pivots;
+    };
+
+    double tolerance = 1e-10;      // On |r| and max |ln f_i^V - ln f_i^L|
+    int maxIterations = 50;
+    double maxStep = 0.2;          // On |delta ln T| per iteration
+    bool direct = true;            // Direct method, the nested one otherwise
+    int maxPhaseChanges = 3;       // Of the direct method, before the nested one takes over
+    PTFlash flash;                 // Options of the PT flashes
+
+    explicit PHFlash(const PengRobinsonEOS& eos) : flash(eos), eos(eos) {}
+
+    Workspace createWorkspace() const {
+        Workspace ws;
+        ws.flash = flash.createWorkspace();
+        return ws;
+    }
+
+    // Flash at the pressure P (in Pa) and the specified enthalpy or entropy, from `initialTemperature` (in K)
+    PHFlashResult solve(FlashSpecification specification, double pressure, double value, const std::vector<double>& z, double initialTemperature) const {
+        Workspace ws = createWorkspace();
+        PHFlashResult result;
+        solve(specification, pressure, value, z, initialTemperature, result, ws);
+        return result;
+    }
+
+    void solve(
+        FlashSpecification specification,
+        double pressure,
+        double value,
+        const std::vector<double>& z,
+        double initialTemperature,
+        PHFlashResult& result,
+        Workspace& ws) const {
+        result.temperature = initialTemperature;
+        result.iterations = 0;
+        result.flashes = 1;
+        flash.flash(pressure, initialTemperature, z, result.phases, ws.flash);
+
+        if (direct) {
+            result.converged = directSolve(specification, pressure, value, z, result, ws);
+        } else {
+            result.converged = nestedSolve(specification, pressure, value, z, result, ws, true);
+        }
+    }
+
+    /*
+    Compute the molar enthalpy (in J/mol) or entropy (in J/mol/K) of the
+    phase split `phases` at P and T, and its temperature derivative at frozen
+    phase amounts and compositions, the heat capacity Cp or Cp / T.
+    */
+    double value(
+        FlashSpecification specification,
+        double pressure,
+        double temperature,
+        const FlashResult& phases,
+        Workspace& ws,
+        double& derivative) const {
+        double beta = phases.vaporFraction, total = 0.0, phaseDerivative;
+        derivative = 0.0;
+
+        if (beta > 0.0) {
+            total += beta * phaseValue(specification, pressure, temperature, phases.y, ws, phaseDerivative);
+            derivative += beta * phaseDerivative;
+        }
+        if (beta < 1.0) {
+            total += (1.0 - beta) * phaseValue(specification, pressure, temperature, phases.x, ws, phaseDerivative);
+            derivative += (1.0 - beta) * phaseDerivative;
+        }
+
+        return total;
+    }
+
+private:
+    const PengRobinsonEOS& eos;
+    static constexpr double R = 8.3145;
+
+    double phaseValue(FlashSpecification specification, double pressure, double temperature, const std::vector<double>& x, Workspace& ws, double& derivative) const {
+        eos.residualProperties(pressure, temperature, x, ws.residual, ws.flash.eos);
+        double Cp = eos.idealGasHeatCapacity(temperature, x) + ws.residual.heatCapacity;
+
+        if (specification == FlashSpecification::ENTHALPY) {
+            derivative = Cp;
+            return eos.idealGasEnthalpy(temperature, x) + ws.residual.enthalpy;
+        }
+
+        derivative = Cp / temperature;
+        return eos.idealGasEntropy(pressure, temperature, x) + ws.residual.entropy;
+    }
+
+    // Scale of r: RT for an enthalpy, R for an entropy
+    static double scale(FlashSpecification specification, double temperature) {
+        return specification == FlashSpecification::ENTHALPY ? R * temperature : R;
+    }
+
+    /*
+    Loop on ln T from `result.temperature`, where `result.phases` must hold
+    the phase split. With `withFlash` every temperature gets a PT flash, and
+    the slope of a two-phase split follows the equilibrium,
+    dr/dln T = 1 / (J^-1 e_N+1)_N+1 with the Jacobian of `newton`. Without
+    it the phases are kept as they are, which is the single-phase Newton of
+    the direct method.
+    */
+    bool nestedSolve(
+        FlashSpecification specification,
+        double pressure,
+        double value,
+        const std::vector<double>& z,
+        PHFlashResult& result,
+        Workspace& ws,
+        bool withFlash) const {
+        const double infinity = std::numeric_limits<double>::infinity();
+        int n = z.size();
+        double lnT = log(result.temperature);
+
+        // Bracket of ln T, r(low) < 0 < r(high), and the side updated last
+        double low = -infinity, high = infinity, rLow = 0.0, rHigh = 0.0;
+        int side = 0;
+
+        while (result.iterations < maxIterations) {
+            double T = result.temperature, r, slope, derivative;
+
+            if (withFlash && result.phases.nPhases == 2) {
+                system(specification, pressure, value, z, result, ws, r, derivative);
+                slope = T * derivative / scale(specification, T);
+
+                std::fill(ws.dX.begin(), ws.dX.end(), 0.0);
+                ws.dX[n] = 1.0;
+                if (LinearAlgebra::solve(ws.jacobian.data(), ws.dX.data(), n + 1, ws.pivots.data()) && ws.dX[n] > 0.0) {
+                    slope = 1.0 / ws.dX[n];
+                }
+            } else {
+                r = (this->value(specification, pressure, T, result.phases, ws, derivative) - value) / scale(specification, T);
+                slope = T * derivative / scale(specification, T);
+            }
+            if (std::abs(r) < tolerance) return true;
+
+            // The Illinois modification halves the residual of an end kept twice
+            if (r < 0.0) {
+                if (side < 0) rHigh *= 0.5;
+                low = lnT;
+                rLow = r;
+                side = -1;
+            } else {
+                if (side > 0) rLow *= 0.5;
+                high = lnT;
+                rHigh = r;
+                side = 1;
+            }
+
+            // H and S grow with T overall, a slope of the wrong sign only comes from the k_ij blends
+            double step = slope > 0.0 ? std::max(-maxStep, std::min(maxStep, -r / slope)) : (r > 0.0 ? -maxStep : maxStep);
+            double next = lnT + step;
+
+            if (!(next > low && next < high) && low > -infinity && high < infinity) {
+                next = low - rLow * (high - low) / (rHigh - rLow);
+            }
+
+            if (std::abs(next - lnT) < 1e-14) return true;
+
+            lnT = next;
+            result.temperature = exp(lnT);
+            result.iterations++;
+
+            if (withFlash) {
+                flash.flash(pressure, result.temperature, z, result.phases, ws.flash);
+                result.flashes++;
+            }
+        }
+
+        return false;
+    }
+
+    bool directSolve(FlashSpecification specification, double pressure, double value, const std::vector<double>& z, PHFlashResult& result, Workspace& ws) const {
+        for (int changes = 0; changes <= maxPhaseChanges; changes++) {
+            if (result.phases.nPhases == 2) {
+                if (newton(specification, pressure, value, z, result, ws)) return true;
+
+                // A phase vanished, label the feed at the last temperature
+                flash.flash(pressure, result.temperature, z, result.phases, ws.flash);
+                result.flashes++;
+                if (result.phases.nPhases == 2) break;
+            }
+
+            if (!nestedSolve(specification, pressure, value, z, result, ws, false)) break;
+
+            // The single-phase solution only stands if the feed is stable there
+            flash.flash(pressure, result.temperature, z, result.phases, ws.flash);
+            result.flashes++;
+            if (result.phases.nPhases == 1) return true;
+        }
+
+        flash.flash(pressure, result.temperature, z, result.phases, ws.flash);
+        result.flashes++;
+        return nestedSolve(specification, pressure, value, z, result, ws, true);
+    }
+
+    /*
+    Evaluate g_i, r and the (N + 1) x (N + 1) Jacobian of (g, r) in
+    (v, ln T) for the two-phase split in `result` at `result.temperature`,
+    see the class description. `derivative` receives the frozen dH/dT or
+    dS/dT. Returns max(|g_i|, |r|).
+    */
+    double system(
+        FlashSpecification specification,
+        double pressure,
+        double value,
+        const std::vector<double>& z,
+        PHFlashResult& result,
+        Workspace& ws,
+        double& r,
+        double& derivative) const {
+        int n = z.size(), m = n + 1;
+        FlashResult& phases = result.phases;
+        const double* x = phases.x.data();
+        const double* y = phases.y.data();
+        double T = result.temperature, beta = phases.vaporFraction;
+
+        ws.g.resize(n);
+        ws.dX.resize(m);
+        ws.jacobian.resize(m * m);
+        ws.pivots.resize(m);
+
+        phases.ZL = eos.lnPhi(pressure, T, phases.x, ws.lnPhiL, ws.flash.eos, PhaseRoot::STABLE, &ws.liquidDerivatives);
+        phases.ZV = eos.lnPhi(pressure, T, phases.y, ws.lnPhiV, ws.flash.eos, PhaseRoot::STABLE, &ws.vaporDerivatives);
+
+        double error = 0.0;
+        for (int i = 0; i < n; i++) {
+            ws.g[i] = z[i] > 0.0 ? log(y[i] / x[i]) + ws.lnPhiV[i] - ws.lnPhiL[i] : 0.0;
+            error = std::max(error, std::abs(ws.g[i]));
+        }
+
+        double s = scale(specification, T);
+        r = (this->value(specification, pressure, T, phases, ws, derivative) - value) / s;
+        error = std::max(error, std::abs(r));
+
+        const double* dnL = ws.liquidDerivatives.dn.data();
+        const double* dnV = ws.vaporDerivatives.dn.data();
+        const double* dTL = ws.liquidDerivatives.dT.data();
+        const double* dTV = ws.vaporDerivatives.dT.data();
+        double phaseScale = 1.0 / (beta * (1.0 - beta));
+        double* J = ws.jacobian.data();
+
+        for (int i = 0; i < n; i++) {
+            if (z[i] > 0.0) {
+                for (int j = 0; j < n; j++) {
+                    J[i * m + j] = dnV[i * n + j] / beta + dnL[i * n + j] / (1.0 - beta) - phaseScale;
+                }
+                J[i * m + i] += phaseScale * z[i] / (x[i] * y[i]);
+                J[i * m + n] = T * (dTV[i] - dTL[i]);
+            } else {
+                // Components absent from the feed keep v_i = 0
+                for (int j = 0; j < m; j++) J[i * m + j] = 0.0;
+                J[i * m + i] = 1.0;
+            }
+        }
+
+        for (int j = 0; j < n; j++) {
+            double latent = z[j] > 0.0 ? -T * (dTV[j] - dTL[j]) : 0.0;
+            J[n * m + j] = specification == FlashSpecification::ENTHALPY ? latent : latent - ws.g[j];
+        }
+        J[n * m + n] = T * derivative / s;
+
+        return error;
+    }
+
+    /*
+    Newton's method on (v_1, ..., v_N, ln T) from the two-phase split in
+    `result`. Returns false when a full step takes the vapor fraction out of
+    (0, 1), as a phase vanishes, when the Jacobian is singular, or when two
+    iterations do not reduce the error.
+    */
+    bool newton(FlashSpecification specification, double pressure, double value, const std::vector<double>& z, PHFlashResult& result, Workspace& ws) const {
+        int n = z.size();
+        FlashResult& phases = result.phases;
+        double* x = phases.x.data();
+        double* y = phases.y.data();
+        double beta = phases.vaporFraction;
+
+        ws.v.resize(n);
+        for (int i = 0; i < n; i++) {
+            ws.v[i] = beta * y[i];
+        }
+
+        // Errors of the last two iterations, a cycle around a fold of H(T) or S(T) stops reducing them
+        double previous = std::numeric_limits<double>::infinity(), beforePrevious = previous;
+
+        while (result.iterations < maxIterations) {
+            double r, derivative;
+            double error = system(specification, pressure, value, z, result, ws, r, derivative);
+
+            if (error > 0.9 * beforePrevious) return false;
+            beforePrevious = previous;
+            previous = error;
+
+            if (error < tolerance) {
+                for (int i = 0; i < n; i++) {
+                    if (z[i] > 0.0) phases.K[i] = y[i] / x[i];
+                }
+                phases.nPhases = 2;
+                phases.converged = true;
+                return true;
+            }
+
+            for (int i = 0; i < n; i++) {
+                ws.dX[i] = -ws.g[i];
+            }
+            ws.dX[n] = -r;
+
+            if (!LinearAlgebra::solve(ws.jacobian.data(), ws.dX.data(), n + 1, ws.pivots.data())) return false;
+
+            // Damp the step so that 0 < v_i < z_i and |delta ln T| <= maxStep
+            double alpha = 1.0, fullBeta = 0.0;
+            for (int i = 0; i < n; i++) {
+                double next = ws.v[i] + ws.dX[i];
+                fullBeta += next;
+                if (z[i] > 0.0 && (next <= 0.0 || next >= z[i])) {
+                    double limit = ws.dX[i] < 0.0 ? -0.9 * ws.v[i] / ws.dX[i] : 0.9 * (z[i] - ws.v[i]) / ws.dX[i];
+                    alpha = std::min(alpha, limit);
+                }
+            }
+            if (!(fullBeta > 0.0 && fullBeta < 1.0)) return false;
+            if (std::abs(ws.dX[n]) > maxStep) alpha = std::min(alpha, maxStep / std::abs(ws.dX[n]));
+
+            beta = 0.0;
+            for (int i = 0; i < n; i++) {
+                ws.v[i] += alpha * ws.dX[i];
+                beta += ws.v[i];
+            }
+            result.temperature *= exp(alpha * ws.dX[n]);
+            result.iterations++;
+
+            for (int i = 0; i < n; i++) {
+                x[i] = (z[i] - ws.v[i]) / (1.0 - beta);
+                y[i] = ws.v[i] / beta;
+            }
+            phases.vaporFraction = beta;
+        }
+
+        return false;
+    }
+};
+
+#endif
@@ -0,0 +1,416 @@
+#ifndef PTFLASH
+#define PTFLASH
+
+#include "Stability.cpp"
+#include "../include/LinearAlgebra.hpp"
+#include "../include/RachfordRice.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+/*
+Struct to store the result of a flash calculation.
+
+Fields:
+- `nPhases`: 1 or 2;
+- `vaporFraction`: Molar vapor fraction, 0 or 1 for a single liquid or vapor phase;
+- `x`, `y`: Liquid and vapor mole fractions, both equal to the feed for a single phase;
+- `K`: Equilibrium ratios y_i / x_i;
+- `ZL`, `ZV`: Compressibility factors of the liquid and vapor phases;
+- `iterations`: Successive substitution plus Newton iterations;
+- `converged`: Whether the fugacity residual reached the tolerance.
+*/
+struct FlashResult {
+    int nPhases = 1;
+    double vaporFraction = 0.0;
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> K;
+    double ZL = 0.0;
+    double ZV = 0.0;
+    int iterations = 0;
+    bool converged = false;
+};
+
+/*
+Isothermal two-phase flash with the Peng-Robinson EoS.
+
+K-values start from the Wilson correlation. They are refined by successive
+substitution, with the Rachford-Rice equation solved in the window of
+Leibovici and Neoschil. Once the fugacity residual falls below
+`newtonSwitch`, the flash switches to Newton's method on the vapor mole
+numbers, with the Jacobian built from the analytic derivatives of ln(phi).
+It is the Hessian of the Gibbs energy, symmetric positive definite near a
+stable split, so each step is a Cholesky solve.
+
+When the Wilson K-values split the feed, the flash runs first: a converged
+split that lowers the Gibbs energy of the feed proves it unstable, and no
+stability analysis is needed. Otherwise the analysis decides, and a stable
+feed is returned as a single phase. When the K-values collapse onto the
+feed although the analysis proved it unstable, as for some liquid-liquid
+splits, the flash restarts from the stationary point of the trial phase
+that proved it, see `StabilityAnalysis::converge`.
+
+With a reused `Workspace` and `FlashResult`, a flash does not allocate.
+*/
+class PTFlash {
+public:
+    // Scratch buffers of `flash`, must not be shared between threads
+    struct Workspace {
+        PengRobinsonEOS::Workspace eos;
+        StabilityAnalysis::Workspace stability;
+        StabilityResult stabilityResult;
+        PengRobinsonEOS::FugacityDerivatives liquidDerivatives;
+        PengRobinsonEOS::FugacityDerivatives vaporDerivatives;
+        std::vector<double> lnPhiL;
+        std::vector<double> lnPhiV;
+        std::vector<double> lnPhiFeed;
+        std::vector<double> lnK;
+        std::vector<double> g;
+        std::vector<double> jacobian;
+        std::vector<double> v;
+        std::vector<double> dv;
+    };
+
+    double tolerance = 1e-10;     // On max |ln f_i^V - ln f_i^L|
+    double newtonSwitch = 1e-2;   // Residual below which Newton takes over
+    int maxIterations = 200;
+    bool stabilityTest = true;    // Check the stability of the feed with `stability`
+    StabilityAnalysis stability;
+
+    explicit PTFlash(const PengRobinsonEOS& eos) : stability(eos), eos(eos) {}
+
+    Workspace createWorkspace() const {
+        Workspace ws;
+        ws.eos = eos.createWorkspace();
+        ws.stability = stability.createWorkspace();
+        ws.liquidDerivatives.withTemperature = false;
+        ws.vaporDerivatives.withTemperature = false;
+
+        // A flash that skips the stability analysis does not size its buffers
+        int nComponents = eos.getComponentParameters().Tc.size();
+        ws.stabilityResult.K.reserve(nComponents);
+        ws.stabilityResult.w.reserve(nComponents);
+        return ws;
+    }
+
+    // Wilson correlation, K_i = Pc_i / P exp(5.373 (1 + w_i) (1 - Tc_i / T))
+    void wilsonK(double pressure, double temperature, int nComponents, double* K) const {
+        const PengRobinsonEOS::ComponentParameters& parameters = eos.getComponentParameters();
+
+        for (int i = 0; i < nComponents; i++) {
+            K[i] = parameters.Pc[i] / pressure * exp(5.373 * (1.0 + parameters.omega[i]) * (1.0 - parameters.Tc[i] / temperature));
+        }
+    }
+
+    FlashResult flash(double pressure, double temperature, const std::vector<double>& z) const {
+        Workspace ws = createWorkspace();
+        FlashResult result;
+        flash(pressure, temperature, z, result, ws);
+        return result;
+    }
+
+    void flash(double pressure, double temperature, const std::vector<double>& z, FlashResult& result, Workspace& ws) const {
+        int n = z.size();
+        result.K.resize(n);
+        wilsonK(pressure, temperature, n, result.K.data());
+
+        // When the Wilson K-values split the feed, a converged split below its Gibbs energy proves
+        // it unstable on its own, and the stability analysis is skipped
+        bool solved = false;
+        if (stabilityTest) {
+            // The Rachford-Rice residual changes sign between beta = 0 and 1
+            if (RachfordRice::residual(z.data(), result.K.data(), n, 0.0) > 0.0 && RachfordRice::residual(z.data(), result.K.data(), n, 1.0) < 0.0) {
+                solveFromK(pressure, temperature, z, result, ws);
+                if (result.nPhases == 2 && gibbsEnergyChange(pressure, temperature, z, result, ws) < 0.0) return;
+                solved = true;
+            }
+        }
+
+        if (stabilityTest) {
+            // The stability analysis shares the PR parameters cached in ws.eos
+            stability.analyze(pressure, temperature, z, ws.stabilityResult, ws.stability, ws.eos);
+
+            if (ws.stabilityResult.stable) {
+                result.x.resize(n);
+                result.y.resize(n);
+                wilsonK(pressure, temperature, n, result.K.data());
+                double beta = RachfordRice::solve(z.data(), result.K.data(), n);
+
+                int iterations = solved ? result.iterations : 0;
+                singlePhase(pressure, temperature, z, beta, result, ws);
+                result.iterations = iterations;
+                result.converged = true;
+                return;
+            }
+        }
+
+        if (!solved) solveFromK(pressure, temperature, z, result, ws);
+
+        // A single phase contradicts the unstable verdict
+        if (stabilityTest && result.nPhases == 1 && stability.converge(pressure, temperature, z, ws.stabilityResult, ws.stability, ws.eos)) {
+            int iterations = result.iterations;
+            std::copy(ws.stabilityResult.K.begin(), ws.stabilityResult.K.end(), result.K.begin());
+            solveFromK(pressure, temperature, z, result, ws);
+            result.iterations += iterations;
+        }
+    }
+
+    // Same as `flash`, starting from the K-values already stored in `result.K`. With `warmStart`,
+    // they and `result.vaporFraction` are taken as close to the solution, so Newton may start at once
+    void solveFromK(double pressure, double temperature, const std::vector<double>& z, FlashResult& result, Workspace& ws, bool warmStart = false) const {
+        int n = z.size();
+
+        result.x.resize(n);
+        result.y.resize(n);
+        result.K.resize(n);
+        ws.lnK.resize(n);
+        ws.g.resize(n);
+
+        double* K = result.K.data();
+        double* x = result.x.data();
+        double* y = result.y.data();
+
+        for (int i = 0; i < n; i++) {
+            ws.lnK[i] = log(K[i]);
+        }
+
+        result.iterations = 0;
+        result.converged = false;
+
+        double beta = 0.5, error = std::numeric_limits<double>::infinity();
+        if (warmStart) {
+            error = 0.0;
+            if (result.vaporFraction > 0.0 && result.vaporFraction < 1.0) beta = result.vaporFraction;
+        }
+        bool trivial = false, allowNewton = true;
+
+        while (result.iterations < maxIterations) {
+            beta = RachfordRice::solve(z.data(), K, n, beta);
+            compositions(z, K, beta, x, y);
+
+            // The fugacity derivatives are only evaluated once Newton is about to take over
+            bool nearSolution = allowNewton && error < newtonSwitch && beta > 0.0 && beta < 1.0;
+            error = residual(pressure, temperature, result, ws, nearSolution);
+            result.iterations++;
+
+            if (error < tolerance) {
+                result.converged = true;
+                break;
+            }
+
+            if (nearSolution) {
+                if (newton(pressure, temperature, z, beta, error, result, ws, allowNewton)) break;
+            }
+
+            // Successive substitution, ln K_i = ln(phi_i^L) - ln(phi_i^V)
+            double sumLnK2 = 0.0;
+            for (int i = 0; i < n; i++) {
+                ws.lnK[i] = ws.lnPhiL[i] - ws.lnPhiV[i];
+                K[i] = exp(ws.lnK[i]);
+                sumLnK2 += ws.lnK[i] * ws.lnK[i];
+            }
+
+            // Both phases collapse onto the feed
+            if (sumLnK2 < 1e-8) {
+                trivial = true;
+                break;
+            }
+        }
+
+        // Converged onto the feed, as from K-values close to 1
+        if (result.converged) {
+            double sumLnK2 = 0.0;
+            for (int i = 0; i < n; i++) sumLnK2 += ws.lnK[i] * ws.lnK[i];
+            trivial = sumLnK2 < 1e-8;
+        }
+
+        if (result.converged && !trivial && beta > 0.0 && beta < 1.0) {
+            result.nPhases = 2;
+            result.vaporFraction = beta;
+            return;
+        }
+
+        bool converged = result.converged || trivial;
+        singlePhase(pressure, temperature, z, beta, result, ws);
+        result.converged = converged;
+    }
+
+private:
+    const PengRobinsonEOS& eos;
+
+    static void compositions(const std::vector<double>& z, const double* K, double beta, double* x, double* y) {
+        int n = z.size();
+
+        for (int i = 0; i < n; i++) {
+            x[i] = z[i] / (1.0 + beta * (K[i] - 1.0));
+            y[i] = K[i] * x[i];
+        }
+    }
+
+    // Gibbs energy of the converged split in `result` minus that of the feed, over RT. The phases
+    // share the fugacities ln x_i + ln(phi_i^L) left in ws.lnPhiL by the last residual
+    double gibbsEnergyChange(double pressure, double temperature, const std::vector<double>& z, const FlashResult& result, Workspace& ws) const {
+        int n = z.size();
+        eos.lnPhi(pressure, temperature, z, ws.lnPhiFeed, ws.eos, PhaseRoot::STABLE);
+
+        double change = 0.0;
+        for (int i = 0; i < n; i++) {
+            if (z[i] > 0.0) change += z[i] * (log(result.x[i] / z[i]) + ws.lnPhiL[i] - ws.lnPhiFeed[i]);
+        }
+
+        return change;
+    }
+
+    // Fill ln(phi) of both phases and g_i = ln K_i + ln(phi_i^V) - ln(phi_i^L), return max |g_i|
+    double residual(double pressure, double temperature, FlashResult& result, Workspace& ws, bool withDerivatives) const {
+        int n = result.x.size();
+
+        result.ZL = eos.lnPhi(pressure, temperature, result.x, ws.lnPhiL, ws.eos, PhaseRoot::STABLE, withDerivatives ? &ws.liquidDerivatives : nullptr);
+        result.ZV = eos.lnPhi(pressure, temperature, result.y, ws.lnPhiV, ws.eos, PhaseRoot::STABLE, withDerivatives ? &ws.vaporDerivatives : nullptr);
+
+        double error = 0.0;
+        for (int i = 0; i < n; i++) {
+            ws.g[i] = result.x[i] > 0.0 ? ws.lnK[i] + ws.lnPhiV[i] - ws.lnPhiL[i] : 0.0;
+            error = std::max(error, std::abs(ws.g[i]));
+        }
+
+        return error;
+    }
+
+    /*
+    Newton's method on the vapor mole numbers v_i, for one mole of feed. The
+    Jacobian of g is
+        dg_i/dv_j = (z_i delta_ij / (x_i y_i) - 1) / (beta (1 - beta))
+                    + dlnphi_i^V/dn_j / beta + dlnphi_i^L/dn_j / (1 - beta)
+    Returns true once converged, false to continue with successive substitution.
+    `allowNewton` is cleared when Newton failed; it stays set when a step predicted
+    to be the last one fell short, so that the substitution step taken from its
+    residual hands over to Newton again instead of re-evaluating it with derivatives.
+
+    Expects `residual` to have been evaluated with derivatives at the current
+    compositions, with max |g_i| = `error`.
+    */
+    bool newton(double pressure, double temperature, const std::vector<double>& z, double& beta, double error, FlashResult& result, Workspace& ws, bool& allowNewton) const {
+        int n = z.size();
+        double* x = result.x.data();
+        double* y = result.y.data();
+
+        ws.v.resize(n);
+        ws.dv.resize(n);
+        ws.jacobian.resize(n * n);
+
+        for (int i = 0; i < n; i++) {
+            ws.v[i] = beta * y[i];
+        }
+
+        while (result.iterations < maxIterations) {
+            const double* dnL = ws.liquidDerivatives.dn.data();
+            const double* dnV = ws.vaporDerivatives.dn.data();
+            double inverseV = 1.0 / beta, inverseL = 1.0 / (1.0 - beta), scale = inverseV * inverseL;
+
+            // The Jacobian is symmetric, only its lower triangle is built
+            for (int i = 0; i < n; i++) {
+                for (int j = 0; j <= i; j++) {
+                    ws.jacobian[i * n + j] = dnV[i * n + j] * inverseV + dnL[i * n + j] * inverseL - scale;
+                }
+
+                // Components absent from the feed keep v_i = 0
+                if (z[i] > 0.0) {
+                    ws.jacobian[i * n + i] += scale * z[i] / (x[i] * y[i]);
+                    for (int j = 0; j < i; j++) {
+                        if (!(z[j] > 0.0)) ws.jacobian[i * n + j] = 0.0;
+                    }
+                } else {
+                    for (int j = 0; j < i; j++) ws.jacobian[i * n + j] = 0.0;
+                    ws.jacobian[i * n + i] = 1.0;
+                }
+                ws.dv[i] = -ws.g[i];
+            }
+
+            if (!LinearAlgebra::solveSymmetric(ws.jacobian.data(), ws.dv.data(), n)) {
+                allowNewton = false;
+                return false;
+            }
+
+            // Damp the step so that 0 < v_i < z_i
+            double alpha = 1.0;
+            for (int i = 0; i < n; i++) {
+                double next = ws.v[i] + ws.dv[i];
+                if (z[i] > 0.0 && (next <= 0.0 || next >= z[i])) {
+                    double limit = ws.dv[i] < 0.0 ? -0.9 * ws.v[i] / ws.dv[i] : 0.9 * (z[i] - ws.v[i]) / ws.dv[i];
+                    alpha = std::min(alpha, limit);
+                }
+            }
+
+            beta = 0.0;
+            for (int i = 0; i < n; i++) {
+                ws.v[i] += alpha * ws.dv[i];
+                beta += ws.v[i];
+            }
+
+            if (!(beta > 0.0 && beta < 1.0)) {
+                allowNewton = false;
+                return false;
+            }
+
+            for (int i = 0; i < n; i++) {
+                x[i] = (z[i] - ws.v[i]) / (1.0 - beta);
+                y[i] = ws.v[i] / beta;
+                if (z[i] > 0.0) {
+                    result.K[i] = y[i] / x[i];
+                    ws.lnK[i] = log(result.K[i]);
+                }
+            }
+
+            // With quadratic convergence a full step from error e lands near e^2:
+            // skip the derivatives when this should be the last evaluation
+            bool last = alpha == 1.0 && error * error < tolerance;
+            error = residual(pressure, temperature, result, ws, !last);
+            result.iterations++;
+
+            if (error < tolerance) {
+                result.converged = true;
+                return true;
+            }
+
+            if (last) return false;
+        }
+
+        allowNewton = false;
+        return false;
+    }
+
+    // Label a feed that did not split. The Rachford-Rice side is used when it is
+    // decisive, Kay's pseudo-critical temperature otherwise
+    void singlePhase(double pressure, double temperature, const std::vector<double>& z, double beta, FlashResult& result, Workspace& ws) const {
+        int n = z.size();
+        const PengRobinsonEOS::ComponentParameters& parameters = eos.getComponentParameters();
+
+        bool vapor;
+        if (beta >= 1.0) {
+            vapor = true;
+        } else if (beta <= 0.0) {
+            vapor = false;
+        } else {
+            double Tpc = 0.0;
+            for (int i = 0; i < n; i++) Tpc += z[i] * parameters.Tc[i];
+            vapor = temperature >= Tpc;
+        }
+
+        for (int i = 0; i < n; i++) {
+            result.x[i] = z[i];
+            result.y[i] = z[i];
+        }
+
+        double Z = eos.lnPhi(pressure, temperature, z, ws.lnPhiL, ws.eos, PhaseRoot::STABLE);
+
+        result.nPhases = 1;
+        result.vaporFraction = vapor ? 1.0 : 0.0;
+        result.ZL = Z;
+        result.ZV = Z;
+    }
+};
+
+#endif
@@ -1,14 +1,20 @@
 #ifndef PENGROBINSONEOS
 #define PENGROBINSONEOS
 
+#include "../include/ComponentRegistry.hpp"
 #include "../include/EquationOfState.hpp"
 #include "../include/GasProperties.hpp"
 #include "../include/InteractionParameters.hpp"
 #include "../include/RootFinding.hpp"
+#include "../include/Simd.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cmath>
 #include <complex>
+#include <cstdint>
 #include <iostream>
-#include <filesystem>
+#include <limits>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -31,142 +37,935 @@ private:
         {"N-hexane", -0.008},
         {"N-heptane", 0.0033}
     };
-    std::vector<GasConstants::GasProperties> gasesProperties;
-    std::vector<std::vector<double>> kij;
+    std::vector<ComponentId> componentIds;
+    std::vector<const GasConstants::GasProperties*> gasesProperties;
+    std::vector<double> kij; // Row-major N x N
 
-    void loadInteractionParameters(const std::vector<std::string>& gasNames){
-        std::filesystem::path filePath = "utils/databases/pripdb.json";
-        auto gasesIPs = BinaryIPs::parseInteractionParameters(filePath.string());
+    // Key of the workspace caches, unique per constructed EoS so that an address reused by a new EoS never hits
+    std::uint64_t instanceId = nextInstanceId++;
+    static inline std::atomic<std::uint64_t> nextInstanceId{1};
+
+public:
+    // Pair whose k12 was fitted over several temperature ranges, with i < j
+    struct TemperatureDependentKij {
+        int i;
+        int j;
+        BinaryIPs::KijTable table;
+    };
+
+private:
+    std::vector<TemperatureDependentKij> temperatureDependentKij;
+
+public:
+    /*
+    Struct to store the per-component PR parameters as contiguous arrays, so the
+    hot loops only stream over the values they use.
+
+    Fields:
+    - `Tc`: Critical temperatures (in K);
+    - `Pc`: Critical pressures (in Pa);
+    - `omega`: Acentric factors;
+    - `kappa`: Slopes of the alpha function, 0.37464 + 1.54226 w - 0.26992 w^2;
+    - `ac`: Attraction parameters at the critical point, 0.45724 R^2 Tc^2 / Pc;
+    - `b`: Covolumes, 0.0778 R Tc / Pc;
+    - `c`: Peneloux volume translations (in m3/mol), 0 for components
+        without a coefficient;
+    - `cp`: Ideal gas heat capacity coefficients {A, B, C, D} of
+        C(T) = A + BT + CT^2 + DT^3 (in J/mol/K);
+    - `hReference`, `sReference`: Integrals A T + B T^2 / 2 + C T^3 / 3 + D T^4 / 4
+        and A ln T + B T + C T^2 / 2 + D T^3 / 3 at `T0`, the ideal gas enthalpy
+        and entropy origins.
+    */
+    struct ComponentParameters {
+        std::vector<double> Tc;
+        std::vector<double> Pc;
+        std::vector<double> omega;
+        std::vector<double> kappa;
+        std::vector<double> ac;
+        std::vector<double> b;
+        std::vector<double> c;
+        std::vector<std::array<double, 4>> cp;
+        std::vector<double> hReference;
+        std::vector<double> sReference;
+    };
+
+    // Reference state of the ideal gas enthalpy and entropy (in K and Pa)
+    static constexpr double T0 = 298.15;
+    static constexpr double P0 = 1e5;
+
+private:
+    ComponentParameters parameters;
+
+    void buildComponentParameters(const std::vector<std::string>& gasNames) {
+        int nComponents = gasesProperties.size();
+        double omega, Pc, Tc, vtc;
+
+        for (int i = 0; i < nComponents; i++) {
+            omega = gasesProperties[i]->acentricFactor;
+            Pc = gasesProperties[i]->criticalPressure;
+            Tc = gasesProperties[i]->criticalTemperature;
+
+            auto it = volumeTranslationCoeffs.find(gasesProperties[i]->name);
+            if (it != volumeTranslationCoeffs.end()) {
+                vtc = it->second;
+            } else {
+                if (volumeTranslation) {
+                    std::cerr << "WARNING: No volume translation coefficient for " << gasNames[i] << ". Returning 0.0 instead." << std::endl;
+                }
+                vtc = 0.0;
+            }
+
+            parameters.Tc.push_back(Tc);
+            parameters.Pc.push_back(Pc);
+            parameters.omega.push_back(omega);
+            parameters.kappa.push_back(0.37464 + 1.54226 * omega - 0.26992 * omega * omega);
+            parameters.ac.push_back(0.45724 * R * R * Tc * Tc / Pc);
+            parameters.b.push_back(0.0778 * R * Tc / Pc);
+            parameters.c.push_back(vtc * 0.0778 * 8.314 * Tc / Pc);
+
+            // The database gives C(T) in J/kmol/K
+            const auto& coeffs = gasesProperties[i]->idealGasHeatCapacityPolyCoeffs;
+            std::array<double, 4> cp = {coeffs[0] * 1e-3, coeffs[1] * 1e-3, coeffs[2] * 1e-3, coeffs[3] * 1e-3};
+            parameters.cp.push_back(cp);
+            parameters.hReference.push_back(T0 * (cp[0] + T0 * (cp[1] / 2.0 + T0 * (cp[2] / 3.0 + T0 * cp[3] / 4.0))));
+            parameters.sReference.push_back(cp[0] * log(T0) + T0 * (cp[1] + T0 * (cp[2] / 2.0 + T0 * cp[3] / 3.0)));
+        }
+    }
+
+    void loadInteractionParameters(const std::vector<std::string>& gasNames, const ComponentRegistry& registry){
+        int nComponents = componentIds.size();
         double k12;
-        std::vector<double> aux;
         
-        for (const std::string& gasName1 : gasNames) {
-            for (const std::string& gasName2 : gasNames) {
-                if (gasName1 == gasName2) {
+        for (int i = 0; i < nComponents; i++) {
+            for (int j = 0; j < nComponents; j++) {
+                if (componentIds[i] == componentIds[j]) {
                     k12 = 0.0;
+                } else if (const auto* dataIP = registry.findInteractionParameters(componentIds[i], componentIds[j])) {
+                    k12 = dataIP->k12;
                 } else {
-                    try {
-                        auto dataIP = BinaryIPs::getInteractionParameters(gasesIPs, gasName1, gasName2);
-                        k12 = dataIP.k12;
-                    }
-                    catch (const std::invalid_argument& e) {
-                        std::cerr << "WARNING: " << e.what() << " Returning 0.0 instead." << std::endl;
-                        k12 = 0.0;
+                    std::cerr << "WARNING: Could not find the BIPs for the pair " << gasNames[i] << ", " << gasNames[j] << ". Returning 0.0 instead." << std::endl;
+                    k12 = 0.0;
+                }
+                kij.push_back(k12);
+
+                if (i < j && componentIds[i] != componentIds[j]) {
+                    if (const auto* table = registry.findKijTable(componentIds[i], componentIds[j])) {
+                        temperatureDependentKij.push_back({i, j, *table});
                     }
                 }
-                aux.push_back(k12);
             }
-            kij.push_back(aux);
-            aux.clear();
         }
     }
 
-    void loadGasProperties(const std::vector<std::string>& gasNames) {
-        std::filesystem::path filePath = "utils/databases/chemsepdb.json";
-        auto gases = GasConstants::parseGasProperties(filePath.string());
-        GasConstants::GasProperties gas;
-        
+    void loadGasProperties(const std::vector<std::string>& gasNames, const ComponentRegistry& registry) {
         for (const std::string& gasName : gasNames) {
-            gas = GasConstants::getGasProperties(gases, gasName);
-            gasesProperties.push_back(gas);
+            ComponentId id = registry.componentId(gasName);
+            componentIds.push_back(id);
+            gasesProperties.push_back(&registry.gas(id));
         }
     }
 
 public:
-    PengRobinsonEOS(const std::vector<std::string>& gasNames, const bool withVolumeTranslation = true) : volumeTranslation(withVolumeTranslation) {
-        loadGasProperties(gasNames);
-        loadInteractionParameters(gasNames);
+    PengRobinsonEOS(
+        const std::vector<std::string>& gasNames,
+        const bool withVolumeTranslation = true,
+        const ComponentRegistry& registry = ComponentRegistry::instance()) : volumeTranslation(withVolumeTranslation) {
+        loadGasProperties(gasNames, registry);
+        loadInteractionParameters(gasNames, registry);
+        buildComponentParameters(gasNames);
     }
 
-    std::vector<std::vector<double>> getKIJ() { return kij; }
+    const ComponentParameters& getComponentParameters() const { return parameters; }
+
+    std::vector<std::vector<double>> getKIJ() {
+        int nComponents = componentIds.size();
+        std::vector<std::vector<double>> matrix(nComponents);
+        for (int i = 0; i < nComponents; i++) {
+            matrix[i].assign(kij.begin() + i * nComponents, kij.begin() + (i + 1) * nComponents);
+        }
+        return matrix;
+    }
+
+    // Row-major N x N matrix of the temperature-independent k_ij
+    const std::vector<double>& getKijMatrix() const { return kij; }
+
+    const std::vector<TemperatureDependentKij>& getTemperatureDependentKij() const { return temperatureDependentKij; }
+
+    bool hasVolumeTranslation() const { return volumeTranslation; }
 
-    std::vector<GasConstants::GasProperties> getGasesProperties() { return gasesProperties; }
+    std::vector<ComponentId> getComponentIds() { return componentIds; }
+
+    std::vector<GasConstants::GasProperties> getGasesProperties() {
+        std::vector<GasConstants::GasProperties> gases;
+        for (const auto* gas : gasesProperties) gases.push_back(*gas);
+        return gases;
+    }
 
     double averageMolarWeight(const std::vector<double>& moleFractions) const override {
         double mW = 0.0;
         int nComponents = moleFractions.size();
 
         for (int i = 0; i < nComponents; i++) {
-            mW += moleFractions[i] * gasesProperties[i].molecularWeight;
+            mW += moleFractions[i] * gasesProperties[i]->molecularWeight;
         }
 
         return mW;
     }
 
-    double compressibilityFactor(double pressure, double temperature, const std::vector<double>& moleFractions) const override {
-        int nComponents = moleFractions.size();
-        double omega, Pc, Tc, A, B, a_mix = 0.0, b_mix = 0.0;
-        std::vector<double> alpha(nComponents, 0.0), a(nComponents, 0.0), b(nComponents, 0.0);
-        std::vector<std::complex<double>> coeffs(4, 0.0);
-        std::vector<std::vector<double>> aux_mix(nComponents, std::vector<double>(nComponents, 0.0));
+    /*
+    Struct to store the scratch buffers of `compressibilityFactor`. Reusing the
+    same workspace across calls avoids any heap allocation once the buffers are
+    sized. A workspace must not be shared between threads.
 
-        for (int i = 0; i < nComponents; i++) {
-            omega = gasesProperties[i].acentricFactor;
-            Pc = gasesProperties[i].criticalPressure;
-            Tc = gasesProperties[i].criticalTemperature;
+    The temperature-dependent parameters are cached: calls at the temperature of
+    the previous call skip the O(N^2) a_ij matrix build, so pressure and
+    composition sweeps at fixed T only evaluate the mixing rule and the cubic.
+
+    Fields:
+    - `a`, `sqrtA`: Attraction parameters a_i(T) and their square roots;
+    - `aij`: Mixing matrix sqrt(a_i a_j) (1 - k_ij), row-major;
+    - `aSum`, `aSumdT`: sum_j x_j a_ij and its temperature derivative, used by `lnPhi`;
+    - `dnTerms`: Per-component terms of d ln(phi_i) / d n_j, used by `lnPhi`;
+    - `dlnadT`: Temperature derivatives of ln a_i, used by `lnPhi`;
+    - `daijdT`: -sqrt(a_i a_j) d k_ij / dT of the temperature-dependent pairs, used by `lnPhi`;
+    - `d2aijdT2`: -sqrt(a_i a_j) d2 k_ij / dT2 of the same pairs, used by `residualProperties`;
+    - `temperature`: Temperature of `a` and `aij`, NaN before the first call;
+    - `derivativesTemperature`: Temperature of `dlnadT`, `daijdT` and `d2aijdT2`,
+        NaN until `lnPhi` is asked for derivatives;
+    - `owner`: Instance id of the EoS that filled the cache, 0 before the first call.
+    */
+    struct Workspace {
+        std::vector<double> a;
+        std::vector<double> sqrtA;
+        std::vector<double> aij;
+        std::vector<double> aSum;
+        std::vector<double> aSumdT;
+        std::vector<double> dnTerms;
+        std::vector<double> dlnadT;
+        std::vector<double> daijdT;
+        std::vector<double> d2aijdT2;
+        double temperature = std::numeric_limits<double>::quiet_NaN();
+        double derivativesTemperature = std::numeric_limits<double>::quiet_NaN();
+        std::uint64_t owner = 0;
+    };
+
+    // Create a workspace sized for this EoS
+    Workspace createWorkspace() const {
+        int nComponents = parameters.Tc.size();
+        Workspace ws;
+
+        ws.a.resize(nComponents);
+        ws.sqrtA.resize(nComponents);
+        ws.aij.resize(nComponents * nComponents);
+        ws.aSum.resize(nComponents);
+        ws.aSumdT.resize(nComponents);
+        ws.dlnadT.resize(nComponents);
+        ws.daijdT.resize(temperatureDependentKij.size());
+        ws.d2aijdT2.resize(temperatureDependentKij.size());
 
-            alpha[i] = (0.37464 + 1.54226 * omega - 0.26992 * omega * omega);
-            alpha[i] *= (1.0 - sqrt(temperature / Tc));
-            alpha[i] += 1.0;
-            alpha[i] *= alpha[i];
+        return ws;
+    }
+
+    // Fill the temperature-dependent parameters of the workspace, unless it already holds them
+    void prepare(double temperature, Workspace& ws) const {
+        if (ws.owner == instanceId && ws.temperature == temperature) return;
+
+        int nComponents = parameters.Tc.size();
+        double sqrtAlpha;
+
+        ws.a.resize(nComponents);
+        ws.sqrtA.resize(nComponents);
+        ws.aij.resize(nComponents * nComponents);
+
+        double* a = ws.a.data();
+        double* sqrtA = ws.sqrtA.data();
+        double* aij = ws.aij.data();
+        const double* Tc = parameters.Tc.data();
+        const double* kappa = parameters.kappa.data();
+        const double* ac = parameters.ac.data();
 
-            a[i] = 0.45724 * alpha[i] * R * R * Tc * Tc / Pc;
-            b[i] = 0.0778 * R * Tc / Pc;
+        for (int i = 0; i < nComponents; i++) {
+            sqrtAlpha = 1.0 + kappa[i] * (1.0 - sqrt(temperature / Tc[i]));
+            a[i] = ac[i] * sqrtAlpha * sqrtAlpha;
+            sqrtA[i] = sqrt(a[i]);
         }
 
+        // k_ij is symmetric, so is a_ij
         for (int i = 0; i < nComponents; i++) {
-            for (int j = 0; j < nComponents; j++) {
-                aux_mix[i][j] = sqrt(a[i] * a[j]) * (1.0 - kij[i][j]);
+            for (int j = i; j < nComponents; j++) {
+                aij[i * nComponents + j] = sqrtA[i] * sqrtA[j] * (1.0 - kij[i * nComponents + j]);
+                aij[j * nComponents + i] = aij[i * nComponents + j];
             }
         }
 
+        for (const auto& item : temperatureDependentKij) {
+            aij[item.i * nComponents + item.j] = sqrtA[item.i] * sqrtA[item.j] * (1.0 - item.table.kij(temperature));
+            aij[item.j * nComponents + item.i] = aij[item.i * nComponents + item.j];
+        }
+
+        ws.temperature = temperature;
+        ws.derivativesTemperature = std::numeric_limits<double>::quiet_NaN();
+        ws.owner = instanceId;
+    }
+
+    // Fill the cached d ln a_i / dT and the k_ij(T) terms of d a_ij / dT and d2 a_ij / dT2, unless the workspace already holds them.
+    // Expects `prepare` at the same temperature
+    void prepareDerivatives(double temperature, Workspace& ws) const {
+        if (ws.derivativesTemperature == temperature) return;
+
+        int stride = parameters.Tc.size();
+        ws.dlnadT.resize(stride);
+        ws.daijdT.resize(temperatureDependentKij.size());
+        ws.d2aijdT2.resize(temperatureDependentKij.size());
+
+        for (int i = 0; i < stride; i++) {
+            double sqrtAlpha = 1.0 + parameters.kappa[i] * (1.0 - sqrt(temperature / parameters.Tc[i]));
+            ws.dlnadT[i] = -parameters.kappa[i] / (sqrt(temperature * parameters.Tc[i]) * sqrtAlpha);
+        }
+
+        for (std::size_t k = 0; k < temperatureDependentKij.size(); k++) {
+            const auto& item = temperatureDependentKij[k];
+            ws.daijdT[k] = -ws.sqrtA[item.i] * ws.sqrtA[item.j] * item.table.slope(temperature);
+            ws.d2aijdT2[k] = -ws.sqrtA[item.i] * ws.sqrtA[item.j] * item.table.curvature(temperature);
+        }
+
+        ws.derivativesTemperature = temperature;
+    }
+
+    double compressibilityFactor(double pressure, double temperature, const std::vector<double>& moleFractions) const override {
+        Workspace ws = createWorkspace();
+        return compressibilityFactor(pressure, temperature, moleFractions, ws);
+    }
+
+    double compressibilityFactor(double pressure, double temperature, const std::vector<double>& moleFractions, Workspace& ws) const {
+        int nComponents = moleFractions.size();
+        int stride = parameters.Tc.size();
+        double A, B, a_mix = 0.0, b_mix = 0.0;
+
+        prepare(temperature, ws);
+
+        const double* aij = ws.aij.data();
+        const double* b = parameters.b.data();
+        const double* x = moleFractions.data();
+
         for (int i = 0; i < nComponents; i++) {
+            double sum = 0.0;
             for (int j = 0; j < nComponents; j++) {
-                a_mix += moleFractions[i] * moleFractions[j] * aux_mix[i][j];
+                sum += x[j] * aij[i * stride + j];
             }
+            a_mix += x[i] * sum;
         }
 
         for (int i = 0; i < nComponents; i++) {
-            b_mix += moleFractions[i] * b[i];
+            b_mix += x[i] * b[i];
         }
 
         A = a_mix * pressure / (R * R * temperature * temperature);
         B = b_mix * pressure / (R * temperature);
 
-        coeffs[0] = -A * B + B * B + B * B * B;
-        coeffs[1] = A - 3.0 * B * B - 2.0 * B;
-        coeffs[2] = B - 1.0;
-        coeffs[3] = 1.0;
+        double z_roots[3];
+        int nRoots = RootFind::cubicRoots(-A * B + B * B + B * B * B, A - 3.0 * B * B - 2.0 * B, B - 1.0, z_roots);
 
-        std::vector<std::complex<double>> z_roots = RootFind::roots(coeffs);
+        double Z = std::max(0.0, z_roots[nRoots - 1]);
 
+        if (volumeTranslation) {
+            const double* c = parameters.c.data();
+            double c_mix = 0.0;
+
+            for (int i = 0; i < nComponents; i++) {
+                c_mix += x[i] * c[i];
+            }
+
+            Z -= c_mix / R / temperature * pressure;
+        }
+        
+        return Z;
+    }
+
+    /*
+    Struct to store the derivatives of the fugacity coefficients, for one mole
+    of mixture.
+
+    Fields:
+    - `dn`: d ln(phi_i) / d n_j at constant T and P, row-major N x N;
+    - `dT`: d ln(phi_i) / d T at constant P and composition (in 1/K);
+    - `dP`: d ln(phi_i) / d P at constant T and composition (in 1/Pa);
+    - `withTemperature`: Set to false to skip `dT`, which costs an extra O(N^2) sum.
+    */
+    struct FugacityDerivatives {
+        std::vector<double> dn;
+        std::vector<double> dT;
+        std::vector<double> dP;
+        bool withTemperature = true;
+    };
+
+    // Compute the logarithms of the fugacity coefficients
+    std::vector<double> lnPhi(double pressure, double temperature, const std::vector<double>& moleFractions, PhaseRoot root = PhaseRoot::STABLE) const {
+        Workspace ws = createWorkspace();
+        std::vector<double> lnPhiValues;
+        lnPhi(pressure, temperature, moleFractions, lnPhiValues, ws, root);
+        return lnPhiValues;
+    }
+
+    /*
+    Compute the logarithms of the fugacity coefficients ln(phi_i), and
+    optionally their analytic derivatives, from the reduced residual Helmholtz
+    energy F(n, T, V) of Michelsen and Mollerup. The derivatives reuse the
+    a_ij matrix and the root of the cubic, so they cost O(N^2) on top of the
+    fugacities and no extra cubic solve.
+
+    Arguments:
+    - `pressure`, `temperature`, `moleFractions`: State of the phase;
+    - `lnPhiValues`: Output, resized to the number of components;
+    - `ws`: Workspace, see `compressibilityFactor`;
+    - `root`: Root of the cubic used for the phase;
+    - `derivatives`: If not null, filled with the derivatives of ln(phi_i).
+
+    Returns:
+        The compressibility factor of the selected root, including the volume translation.
+    */
+    double lnPhi(
+        double pressure,
+        double temperature,
+        const std::vector<double>& moleFractions,
+        std::vector<double>& lnPhiValues,
+        Workspace& ws,
+        PhaseRoot root = PhaseRoot::STABLE,
+        FugacityDerivatives* derivatives = nullptr) const {
+        const double delta1 = 1.0 + std::sqrt(2.0), delta2 = 1.0 - std::sqrt(2.0);
+
+        int nComponents = moleFractions.size();
+        int stride = parameters.Tc.size();
+        double RT = R * temperature;
+
+        prepare(temperature, ws);
+        ws.aSum.resize(stride);
+        lnPhiValues.resize(nComponents);
+
+        const double* aij = ws.aij.data();
+        const double* b = parameters.b.data();
+        const double* c = parameters.c.data();
+        const double* x = moleFractions.data();
+        double* aSum = ws.aSum.data();
+
+        // a_ij is symmetric: accumulate row j into every aSum_i, which leaves no dependency chain
+        std::fill(aSum, aSum + nComponents, 0.0);
+        for (int j = 0; j < nComponents; j++) {
+            const double* row = aij + j * stride;
+            for (int i = 0; i < nComponents; i++) {
+                aSum[i] += x[j] * row[i];
+            }
+        }
+
+        double D = 0.0, Bm = 0.0;
+        for (int i = 0; i < nComponents; i++) {
+            D += x[i] * aSum[i];
+            Bm += x[i] * b[i];
+        }
+
+        double Z = selectRoot(D * pressure / (RT * RT), Bm * pressure / RT, root);
+
+        // Reduced residual Helmholtz energy F = -n g(V, B) - D(T) / T f(V, B), for n = 1
+        double V = Z * RT / pressure;
+        double VmB = V - Bm, d1V = V + delta1 * Bm, d2V = V + delta2 * Bm;
+
+        double g_B = -1.0 / VmB;
+        double f = log(d1V / d2V) / (R * Bm * (delta1 - delta2));
+        double f_V = -1.0 / (R * d1V * d2V);
+        double f_B = -(f + V * f_V) / Bm;
+
+        double F_B = -g_B - D / temperature * f_B;
+        double F_D = -f / temperature;
+
+        // -g - ln Z = -ln(P (V - B) / RT), one logarithm for both
+        double lnZmB = log(pressure * VmB / RT);
+
+        for (int i = 0; i < nComponents; i++) {
+            lnPhiValues[i] = F_B * b[i] + F_D * 2.0 * aSum[i] - lnZmB;
+        }
+
+        if (volumeTranslation) {
+            for (int i = 0; i < nComponents; i++) {
+                lnPhiValues[i] -= c[i] * pressure / RT;
+            }
+        }
+
+        if (derivatives) {
+            fugacityDerivatives(pressure, temperature, moleFractions, ws, V, D, Bm, *derivatives);
+        }
+
+        if (volumeTranslation) {
+            double c_mix = 0.0;
+            for (int i = 0; i < nComponents; i++) {
+                c_mix += x[i] * c[i];
+            }
+            Z -= c_mix * pressure / RT;
+        }
+
+        return Z;
+    }
+
+    /*
+    Struct to store the residual properties of a phase, for one mole.
+
+    Fields:
+    - `Z`: Compressibility factor of the selected root, including the volume translation;
+    - `enthalpy`: Residual enthalpy H - H^ig at T and P (in J/mol);
+    - `entropy`: Residual entropy S - S^ig at T and P (in J/mol/K);
+    - `heatCapacity`: Residual isobaric heat capacity dH^R/dT at constant P and
+        composition (in J/mol/K). The temperature derivative of the residual
+        entropy is `heatCapacity` / T;
+    - `dVdT`, `dVdP`: Derivatives of the molar volume at constant P and at
+        constant T (in m3/mol/K and m3/mol/Pa).
+    */
+    struct ResidualProperties {
         double Z = 0.0;
-        for (const auto& z_root : z_roots) {
-            if (z_root.real() > Z) {
-                Z = z_root.real();
+        double enthalpy = 0.0;
+        double entropy = 0.0;
+        double heatCapacity = 0.0;
+        double dVdT = 0.0;
+        double dVdP = 0.0;
+    };
+
+    /*
+    Compute the residual enthalpy, entropy and heat capacity of a phase from
+    F(T, V) = -g(V, B) - D(T) / T f(V, B):
+        H^R = PV - RT + R (T D' - D) f,
+        S^R = R ln(P (V - B) / RT) + R D' f,
+    with the analytic D' and D'' of the mixing rule, and dV/dT at constant P
+    from the equation of state. The volume translation shifts H^R by -c P and
+    leaves S^R unchanged. The a_ij matrix and the per-component temperature
+    derivatives are the ones cached in the workspace, shared with `lnPhi`.
+
+    Returns:
+        The compressibility factor of the selected root, including the volume translation.
+    */
+    double residualProperties(
+        double pressure,
+        double temperature,
+        const std::vector<double>& moleFractions,
+        ResidualProperties& properties,
+        Workspace& ws,
+        PhaseRoot root = PhaseRoot::STABLE) const {
+        const double delta1 = 1.0 + std::sqrt(2.0), delta2 = 1.0 - std::sqrt(2.0);
+
+        int nComponents = moleFractions.size();
+        int stride = parameters.Tc.size();
+        double T = temperature, RT = R * temperature;
+
+        prepare(temperature, ws);
+        prepareDerivatives(temperature, ws);
+
+        const double* aij = ws.aij.data();
+        const double* b = parameters.b.data();
+        const double* x = moleFractions.data();
+
+        // With l_i = d ln sqrt(a_i) / dT and sqrt(a_i)'' = -l_i sqrt(a_i) / (2T),
+        // D' = sum_ij x_i x_j a_ij (l_i + l_j) and D'' = sum_ij x_i x_j a_ij (2 l_i l_j - (l_i + l_j) / 2T),
+        // plus the k_ij(T) terms of the temperature-dependent pairs
+        double D = 0.0, DT = 0.0, DTT = 0.0, Bm = 0.0;
+        for (int i = 0; i < nComponents; i++) {
+            double sum = 0.0, sumL = 0.0;
+            for (int j = 0; j < nComponents; j++) {
+                double term = x[j] * aij[i * stride + j];
+                sum += term;
+                sumL += term * ws.dlnadT[j];
             }
+            double li = 0.5 * ws.dlnadT[i];
+            D += x[i] * sum;
+            DT += 2.0 * x[i] * li * sum;
+            DTT += x[i] * li * (sumL - sum / T);
+            Bm += x[i] * b[i];
+        }
+
+        for (std::size_t k = 0; k < temperatureDependentKij.size(); k++) {
+            const auto& item = temperatureDependentKij[k];
+            if (item.j >= nComponents) continue;
+            double xx = x[item.i] * x[item.j];
+            DT += 2.0 * xx * ws.daijdT[k];
+            DTT += 2.0 * xx * (ws.daijdT[k] * (ws.dlnadT[item.i] + ws.dlnadT[item.j]) + ws.d2aijdT2[k]);
         }
 
+        double Z = selectRoot(D * pressure / (RT * RT), Bm * pressure / RT, root);
+        double V = Z * RT / pressure;
+        double VmB = V - Bm, d1V = V + delta1 * Bm, d2V = V + delta2 * Bm;
+
+        double f = log(d1V / d2V) / (R * Bm * (delta1 - delta2));
+        double f_V = -1.0 / (R * d1V * d2V);
+        double f_VV = (1.0 / (d2V * d2V) - 1.0 / (d1V * d1V)) / (R * Bm * (delta1 - delta2));
+
+        // P = RT / (V - B) + R D f_V
+        double dPdT = R / VmB + R * DT * f_V;
+        double dPdV = -RT / (VmB * VmB) + R * D * f_VV;
+        double dVdT = -dPdT / dPdV;
+
+        properties.enthalpy = pressure * V - RT + R * (T * DT - D) * f;
+        properties.entropy = R * log(pressure * VmB / RT) + R * DT * f;
+        properties.heatCapacity = pressure * dVdT - R + R * T * DTT * f + R * (T * DT - D) * f_V * dVdT;
+        properties.dVdT = dVdT;
+        properties.dVdP = 1.0 / dPdV;
+
         if (volumeTranslation) {
-            double vtc, aux = 0.0;
+            const double* c = parameters.c.data();
+            double c_mix = 0.0;
             for (int i = 0; i < nComponents; i++) {
-                try {
-                    vtc = volumeTranslationCoeffs.at(gasesProperties[i].name);
-                } catch (const std::invalid_argument& e) {
-                    std::cerr << "WARNING: " << e.what() << " Returning 0.0 instead." << std::endl;
-                    vtc = 0.0;
-                }
-                Pc = gasesProperties[i].criticalPressure;
-                Tc = gasesProperties[i].criticalTemperature;
-                aux += moleFractions[i] * vtc * 0.0778 * 8.314 * Tc / Pc; 
+                c_mix += x[i] * c[i];
             }
+            properties.enthalpy -= c_mix * pressure;
+            Z -= c_mix * pressure / RT;
+        }
 
-            Z -= aux / R / temperature * pressure;
+        properties.Z = Z;
+        return Z;
+    }
+
+    // Ideal gas molar enthalpy, from `T0` (in J/mol)
+    double idealGasEnthalpy(double temperature, const std::vector<double>& moleFractions) const {
+        int nComponents = moleFractions.size();
+        double T = temperature, H = 0.0;
+
+        for (int i = 0; i < nComponents; i++) {
+            const auto& cp = parameters.cp[i];
+            double Hi = T * (cp[0] + T * (cp[1] / 2.0 + T * (cp[2] / 3.0 + T * cp[3] / 4.0))) - parameters.hReference[i];
+            H += moleFractions[i] * Hi;
         }
-        
+
+        return H;
+    }
+
+    // Ideal gas molar entropy of the mixture, from `T0` and `P0` (in J/mol/K)
+    double idealGasEntropy(double pressure, double temperature, const std::vector<double>& moleFractions) const {
+        int nComponents = moleFractions.size();
+        double T = temperature, S = -R * log(pressure / P0);
+
+        for (int i = 0; i < nComponents; i++) {
+            if (moleFractions[i] <= 0.0) continue;
+            const auto& cp = parameters.cp[i];
+            double Si = cp[0] * log(T) + T * (cp[1] + T * (cp[2] / 2.0 + T * cp[3] / 3.0)) - parameters.sReference[i];
+            S += moleFractions[i] * (Si - R * log(moleFractions[i]));
+        }
+
+        return S;
+    }
+
+    // Ideal gas molar isobaric heat capacity (in J/mol/K)
+    double idealGasHeatCapacity(double temperature, const std::vector<double>& moleFractions) const {
+        int nComponents = moleFractions.size();
+        double T = temperature, Cp = 0.0;
+
+        for (int i = 0; i < nComponents; i++) {
+            const auto& cp = parameters.cp[i];
+            Cp += moleFractions[i] * (cp[0] + T * (cp[1] + T * (cp[2] + T * cp[3])));
+        }
+
+        return Cp;
+    }
+
+private:
+    // Root of the PR cubic in Z, without volume translation, for the reduced parameters A and B
+    static double selectRoot(double A, double B, PhaseRoot root) {
+        const double delta1 = 1.0 + std::sqrt(2.0), delta2 = 1.0 - std::sqrt(2.0);
+
+        double z_roots[3];
+        int nRoots = RootFind::cubicRoots(-A * B + B * B + B * B * B, A - 3.0 * B * B - 2.0 * B, B - 1.0, z_roots);
+
+        // Roots below the covolume have no physical meaning
+        double Z = z_roots[nRoots - 1];
+        double Z_L = Z;
+        for (int k = 0; k < nRoots; k++) {
+            if (z_roots[k] > B) {
+                Z_L = z_roots[k];
+                break;
+            }
+        }
+
+        if (root == PhaseRoot::LIQUID) {
+            Z = Z_L;
+        } else if (root == PhaseRoot::STABLE && Z_L < Z) {
+            // Pick the root with the lowest residual Gibbs energy, ln(phi) of the mixture
+            auto lnPhiMix = [&](double z) {
+                return z - 1.0 - log(z - B) - A / (B * (delta1 - delta2)) * log((z + delta1 * B) / (z + delta2 * B));
+            };
+            if (lnPhiMix(Z_L) < lnPhiMix(Z)) Z = Z_L;
+        }
+
         return Z;
     }
 
+    // Fill aSumdT = sum_j x_j d a_ij / dT and return d a_mix / dT, for `fugacityDerivatives`
+    double temperatureDerivatives(double temperature, const std::vector<double>& moleFractions, Workspace& ws) const {
+        int nComponents = moleFractions.size();
+        int stride = parameters.Tc.size();
+
+        const double* aij = ws.aij.data();
+        const double* aSum = ws.aSum.data();
+        const double* x = moleFractions.data();
+
+        ws.aSumdT.resize(stride);
+        double* aSumdT = ws.aSumdT.data();
+
+        // d a_ij / dT = a_ij (d ln a_i / dT + d ln a_j / dT) / 2 - sqrt(a_i a_j) d k_ij / dT,
+        // the per-component and per-pair terms only depend on T and are cached
+        prepareDerivatives(temperature, ws);
+
+        const double* dlnadT = ws.dlnadT.data();
+
+        for (int i = 0; i < nComponents; i++) {
+            double sum = 0.0;
+            for (int j = 0; j < nComponents; j++) {
+                sum += x[j] * aij[i * stride + j] * dlnadT[j];
+            }
+            aSumdT[i] = 0.5 * (dlnadT[i] * aSum[i] + sum);
+        }
+
+        for (std::size_t k = 0; k < temperatureDependentKij.size(); k++) {
+            const auto& item = temperatureDependentKij[k];
+            if (item.j >= nComponents) continue;
+            aSumdT[item.i] += x[item.j] * ws.daijdT[k];
+            aSumdT[item.j] += x[item.i] * ws.daijdT[k];
+        }
+
+        double DT = 0.0;
+        for (int i = 0; i < nComponents; i++) {
+            DT += x[i] * aSumdT[i];
+        }
+
+        return DT;
+    }
+
+    // Derivatives of ln(phi_i) at the molar volume V, with D = a_mix and Bm = b_mix
+    void fugacityDerivatives(
+        double pressure,
+        double temperature,
+        const std::vector<double>& moleFractions,
+        Workspace& ws,
+        double V,
+        double D,
+        double Bm,
+        FugacityDerivatives& derivatives) const {
+        const double delta1 = 1.0 + std::sqrt(2.0), delta2 = 1.0 - std::sqrt(2.0);
+
+        int nComponents = moleFractions.size();
+        int stride = parameters.Tc.size();
+        double RT = R * temperature;
+
+        derivatives.dn.resize(nComponents * nComponents);
+        derivatives.dP.resize(nComponents);
+
+        const double* aij = ws.aij.data();
+        const double* aSum = ws.aSum.data();
+        const double* b = parameters.b.data();
+        const double* c = parameters.c.data();
+
+        double DT = derivatives.withTemperature ? temperatureDerivatives(temperature, moleFractions, ws) : 0.0;
+
+        // Derivatives of g(V, B) = ln(1 - B / V) and f(V, B) = ln((V + d1 B) / (V + d2 B)) / (R B (d1 - d2))
+        double VmB = V - Bm, d1V = V + delta1 * Bm, d2V = V + delta2 * Bm;
+
+        double g_V = Bm / (V * VmB);
+        double g_B = -1.0 / VmB;
+        double g_VV = 1.0 / (V * V) - 1.0 / (VmB * VmB);
+        double g_BV = 1.0 / (VmB * VmB);
+        double g_BB = -1.0 / (VmB * VmB);
+
+        double f = log(d1V / d2V) / (R * Bm * (delta1 - delta2));
+        double f_V = -1.0 / (R * d1V * d2V);
+        double f_B = -(f + V * f_V) / Bm;
+        double f_VV = (1.0 / (d2V * d2V) - 1.0 / (d1V * d1V)) / (R * Bm * (delta1 - delta2));
+        double f_BV = -(2.0 * f_V + V * f_VV) / Bm;
+        double f_BB = -(2.0 * f_B + V * f_BV) / Bm;
+
+        // Derivatives of F, with D_i = 2 aSum_i and D_ij = 2 a_ij
+        double T = temperature;
+        double F_D = -f / T;
+        double F_VV = -g_VV - D / T * f_VV;
+        double F_BV = -g_BV - D / T * f_BV;
+        double F_DV = -f_V / T;
+        double F_nB = -g_B;
+        double F_BD = -f_B / T;
+        double F_BB = -g_BB - D / T * f_BB;
+        double F_BT = -(DT / T - D / (T * T)) * f_B;
+        double F_DT = f / (T * T);
+        double F_TV = -(DT / T - D / (T * T)) * f_V;
+
+        double dPdV = -RT * F_VV - RT / (V * V);
+        double dPdT = -RT * F_TV + pressure / T;
+        double inverse = 1.0 / (RT * dPdV);
+
+        // dP/dn_i, stored in dP until the partial molar volumes are known
+        for (int i = 0; i < nComponents; i++) {
+            double F_iV = -g_V + F_BV * b[i] + F_DV * 2.0 * aSum[i];
+            derivatives.dP[i] = -RT * F_iV + RT / V;
+        }
+
+        // F_ij = F_nB (b_i + b_j) + 2 F_BD (b_i aSum_j + b_j aSum_i) + F_BB b_i b_j + 2 F_D a_ij, grouped as
+        // b_i p_j + (p_i + F_BB b_i) b_j + 2 F_D a_ij with p_i = F_nB + 2 F_BD aSum_i, so that each row
+        // is a few multiply-adds over contiguous arrays
+        ws.dnTerms.resize(stride);
+        double* p = ws.dnTerms.data();
+        for (int i = 0; i < nComponents; i++) {
+            p[i] = F_nB + F_BD * 2.0 * aSum[i];
+        }
+
+        const double* dP = derivatives.dP.data();
+        for (int i = 0; i < nComponents; i++) {
+            const double* row = aij + i * stride;
+            double* dn = derivatives.dn.data() + i * nComponents;
+            double bi = b[i], ci = p[i] + F_BB * b[i], di = dP[i] * inverse;
+
+            for (int j = 0; j < nComponents; j++) {
+                dn[j] = bi * p[j] + ci * b[j] + F_D * 2.0 * row[j] + di * dP[j] + 1.0;
+            }
+        }
+
+        if (derivatives.withTemperature) {
+            derivatives.dT.resize(nComponents);
+
+            for (int i = 0; i < nComponents; i++) {
+                double v_i = -derivatives.dP[i] / dPdV;
+                double F_iT = F_BT * b[i] + F_DT * 2.0 * aSum[i] + F_D * 2.0 * ws.aSumdT[i];
+
+                derivatives.dT[i] = F_iT + 1.0 / T - v_i * dPdT / RT;
+
+                if (volumeTranslation) {
+                    derivatives.dT[i] += c[i] * pressure / (RT * T);
+                }
+            }
+        }
+
+        for (int i = 0; i < nComponents; i++) {
+            double v_i = -derivatives.dP[i] / dPdV;
+            derivatives.dP[i] = v_i / RT - 1.0 / pressure;
+
+            if (volumeTranslation) {
+                derivatives.dP[i] -= c[i] / RT;
+            }
+        }
+    }
+
+public:
+    /*
+    Batched compressibility factor. States are processed `Simd::Vec::LANES` at a
+    time: alpha(T), the mixing rule and the A, B coefficients are evaluated on
+    packed doubles, then the cubic of each lane is solved in closed form. The
+    scratch buffers are allocated once per call, not once per state.
+
+    Build with -mavx2 -mfma (or -mavx512f, or -march=native) to enable the wide
+    kernels; otherwise the same code runs one state at a time.
+    */
+    void compressibilityFactors(
+        const std::vector<double>& pressures,
+        const std::vector<double>& temperatures,
+        const std::vector<double>& moleFractions,
+        std::vector<double>& Z,
+        bool compositionPerState = false) const override {
+        using Simd::Vec;
+        constexpr int LANES = Vec::LANES;
+
+        int nStates = pressures.size();
+        int stride = parameters.Tc.size();
+
+        if (temperatures.size() != pressures.size()) {
+            throw std::invalid_argument("The pressures and temperatures must have the same size.");
+        }
+        if (nStates == 0) {
+            Z.clear();
+            return;
+        }
+        if (compositionPerState && moleFractions.size() % nStates != 0) {
+            throw std::invalid_argument("The compositions must have one row per state.");
+        }
+
+        int nComponents = compositionPerState ? moleFractions.size() / nStates : moleFractions.size();
+
+        if (nComponents > stride) {
+            throw std::invalid_argument("The compositions have more components than the EoS.");
+        }
+
+        Z.resize(nStates);
+
+        const double* Tc = parameters.Tc.data();
+        const double* kappa = parameters.kappa.data();
+        const double* b = parameters.b.data();
+        const double* c = parameters.c.data();
+
+        // sqrt(ac_i), then the lane-interleaved x_i and y_i = x_i sqrt(a_i(T))
+        std::vector<double> buffer(nComponents * (1 + 2 * LANES));
+        double* sqrtAc = buffer.data();
+        double* x = sqrtAc + nComponents;
+        double* y = x + nComponents * LANES;
+
+        for (int i = 0; i < nComponents; i++) {
+            sqrtAc[i] = sqrt(parameters.ac[i]);
+        }
+
+        double P[LANES], T[LANES], a_mix[LANES], A[LANES], B[LANES], shift[LANES];
+        const Vec zero = Vec::broadcast(0.0), one = Vec::broadcast(1.0), two = Vec::broadcast(2.0);
+
+        for (int k0 = 0; k0 < nStates; k0 += LANES) {
+            // The last block is padded by repeating its final state
+            int row[LANES];
+            for (int l = 0; l < LANES; l++) {
+                row[l] = std::min(k0 + l, nStates - 1);
+                P[l] = pressures[row[l]];
+                T[l] = temperatures[row[l]];
+            }
+
+            Vec Tv = Vec::load(T), Pv = Vec::load(P);
+            Vec bv = zero, cv = zero;
+
+            for (int i = 0; i < nComponents; i++) {
+                Vec xi;
+                if (compositionPerState) {
+                    for (int l = 0; l < LANES; l++) {
+                        x[i * LANES + l] = moleFractions[row[l] * nComponents + i];
+                    }
+                    xi = Vec::load(x + i * LANES);
+                } else {
+                    xi = Vec::broadcast(moleFractions[i]);
+                }
+
+                Vec sqrtAlpha = fma(Vec::broadcast(kappa[i]), one - sqrt(Tv / Vec::broadcast(Tc[i])), one);
+                (xi * Vec::broadcast(sqrtAc[i]) * sqrtAlpha).store(y + i * LANES);
+
+                bv = fma(xi, Vec::broadcast(b[i]), bv);
+                cv = fma(xi, Vec::broadcast(c[i]), cv);
+            }
+
+            // k_ij is symmetric: a_mix = sum_i y_i (y_i + 2 sum_{j > i} (1 - k_ij) y_j)
+            Vec av = zero;
+            for (int i = 0; i < nComponents; i++) {
+                Vec sum = zero;
+                for (int j = i + 1; j < nComponents; j++) {
+                    sum = fma(Vec::broadcast(1.0 - kij[i * stride + j]), Vec::load(y + j * LANES), sum);
+                }
+                Vec yi = Vec::load(y + i * LANES);
+                av = fma(yi, fma(two, sum, yi), av);
+            }
+
+            av.store(a_mix);
+            for (const auto& item : temperatureDependentKij) {
+                if (item.j >= nComponents) continue;
+                for (int l = 0; l < LANES; l++) {
+                    double dk = kij[item.i * stride + item.j] - item.table.kij(T[l]);
+                    a_mix[l] += 2.0 * y[item.i * LANES + l] * y[item.j * LANES + l] * dk;
+                }
+            }
+
+            Vec RT = Vec::broadcast(R) * Tv;
+            (Vec::load(a_mix) * Pv / (RT * RT)).store(A);
+            (bv * Pv / RT).store(B);
+            (volumeTranslation ? cv * Pv / RT : zero).store(shift);
+
+            for (int l = 0; l < LANES && k0 + l < nStates; l++) {
+                double z_roots[3];
+                int nRoots = RootFind::cubicRoots(-A[l] * B[l] + B[l] * B[l] + B[l] * B[l] * B[l], A[l] - 3.0 * B[l] * B[l] - 2.0 * B[l], B[l] - 1.0, z_roots);
+
+                Z[k0 + l] = std::max(0.0, z_roots[nRoots - 1]) - shift[l];
+            }
+        }
+    }
+
     double volume(double pressure, double temperature, const std::vector<double>& moleFractions, UnitBase unit = UnitBase::MASS) const override {
         double Z = compressibilityFactor(pressure, temperature, moleFractions);
         double Vm = Z * R * temperature / pressure;
@@ -188,7 +987,36 @@ public:
     }
 
     double enthalpy(double pressure, double temperature, const std::vector<double>& moleFractions, UnitBase unit) const override {
-        
+        Workspace ws = createWorkspace();
+        ResidualProperties residual;
+        residualProperties(pressure, temperature, moleFractions, residual, ws);
+
+        double Hm = idealGasEnthalpy(temperature, moleFractions) + residual.enthalpy;
+
+        if (unit == UnitBase::MOLAR) {
+            return 1e-3 * Hm;
+        } else if (unit == UnitBase::MASS) {
+            return Hm / averageMolarWeight(moleFractions);
+        } else {
+            throw std::invalid_argument("Unit of measurement not supported.");
+        }
+    }
+
+    // Compute the entropy, either in kJ/kg/K or in kJ/mol/K
+    double entropy(double pressure, double temperature, const std::vector<double>& moleFractions, UnitBase unit) const {
+        Workspace ws = createWorkspace();
+        ResidualProperties residual;
+        residualProperties(pressure, temperature, moleFractions, residual, ws);
+
+        double Sm = idealGasEntropy(pressure, temperature, moleFractions) + residual.entropy;
+
+        if (unit == UnitBase::MOLAR) {
+            return 1e-3 * Sm;
+        } else if (unit == UnitBase::MASS) {
+            return Sm / averageMolarWeight(moleFractions);
+        } else {
+            throw std::invalid_argument("Unit of measurement not supported.");
+        }
     }
 
 };
@@ -0,0 +1,563 @@
+#ifndef PHASEENVELOPE
+#define PHASEENVELOPE
+
+#include "PengRobinson.cpp"
+#include "../include/LinearAlgebra.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/*
+Struct to store a traced phase envelope.
+
+Fields:
+- `temperatures`, `pressures`: Points along the envelope, in tracing order;
+- `lnK`: ln K_i = ln(y_i / x_i) of each point, row-major with one row per point;
+- `incipientVapor`: Whether the phase y of each point is the vapor, false past
+    an odd number of critical points;
+- `criticalTemperatures`, `criticalPressures`: Critical points crossed by the trace;
+- `cricondenbarTemperature`, `cricondenbarPressure`: Point of highest pressure;
+- `cricondenthermTemperature`, `cricondenthermPressure`: Point of highest temperature;
+- `iterations`: Newton iterations over all points;
+- `complete`: Whether the trace came back down to `minimumPressure`.
+*/
+struct PhaseEnvelope {
+    std::vector<double> temperatures;
+    std::vector<double> pressures;
+    std::vector<double> lnK;
+    std::vector<bool> incipientVapor;
+    std::vector<double> criticalTemperatures;
+    std::vector<double> criticalPressures;
+    double cricondenbarTemperature = 0.0;
+    double cricondenbarPressure = 0.0;
+    double cricondenthermTemperature = 0.0;
+    double cricondenthermPressure = 0.0;
+    int iterations = 0;
+    bool complete = false;
+
+    int size() const { return temperatures.size(); }
+};
+
+/*
+Phase envelope tracer with the Peng-Robinson EoS, after Michelsen (1980).
+
+The unknowns are X = (ln K_1, ..., ln K_N, ln T, ln P) for the phase split at
+a fixed vapor fraction beta (0 for the bubble curve, 1 for the dew curve),
+with x_i = z_i / (1 - beta + beta K_i) and y_i = K_i x_i. They solve
+    F_i = ln K_i + ln(phi_i^V(y)) - ln(phi_i^L(x)) = 0,
+    F_N+1 = sum_i (y_i - x_i) = 0,
+    F_N+2 = X_s - S = 0,
+by Newton's method with the analytic derivatives of ln(phi).
+
+From each converged point, the sensitivity dX/dS = J^-1 e_N+2 gives the
+tangent of the curve. The next specified variable X_s is the one that
+changes fastest along it, and the next point is extrapolated by a cubic
+Hermite polynomial through the last two points and their tangents. The
+step grows when Newton converges in few iterations and shrinks when it
+struggles or fails.
+
+Near a critical point every ln K goes to 0, so a ln K is specified there.
+When the next step would cross or land next to ln K_s = 0, the trace first
+lands at half `criticalApproach` from it, then mirrors ln K_s: it jumps over
+the trivial solution and carries on along the other branch, with the roles
+of the two phases swapped. The critical point is interpolated at
+ln K_s = 0 over that short step, which stays accurate where k12(T) bends.
+
+The trace starts at `minimumPressure` on the low-temperature side of the
+envelope, from Wilson K-values, and stops when it comes back below
+`minimumPressure`.
+*/
+class PhaseEnvelopeTracer {
+public:
+    // Scratch buffers of `trace`, must not be shared between threads
+    struct Workspace {
+        PengRobinsonEOS::Workspace eos;
+        PengRobinsonEOS::FugacityDerivatives liquidDerivatives;
+        PengRobinsonEOS::FugacityDerivatives vaporDerivatives;
+        std::vector<double> lnPhiL;
+        std::vector<double> lnPhiV;
+        std::vector<double> x;
+        std::vector<double> y;
+        std::vector<double> F;
+        std::vector<double> jacobian;
+        std::vector<double> factors;
+        std::vector<double> dX;
+        std::vector<int> pivots;
+        std::vector<double> X;
+        std::vector<double> tangent;
+        std::vector<double> previousX;
+        std::vector<double> previousTangent;
+        std::vector<double> trialX;
+    };
+
+    double vaporFraction = 0.0;      // beta of the traced curve
+    double minimumPressure = 1e5;    // Start and end of the trace (in Pa)
+    double maximumPressure = 1e9;    // The trace stops above this pressure (in Pa)
+    double tolerance = 1e-10;        // On max |F_i|
+    int maxIterations = 15;          // Newton iterations per point
+    int maxPoints = 1000;
+    double initialStep = 0.05;       // Steps are changes of the specified variable
+    double maxStep = 0.3;
+    double minStep = 1e-6;
+    double criticalApproach = 0.05;  // |ln K_s| after a step below which it is mirrored
+
+    explicit PhaseEnvelopeTracer(const PengRobinsonEOS& eos) : eos(eos) {}
+
+    Workspace createWorkspace() const {
+        Workspace ws;
+        ws.eos = eos.createWorkspace();
+        return ws;
+    }
+
+    PhaseEnvelope trace(const std::vector<double>& z) const {
+        Workspace ws = createWorkspace();
+        PhaseEnvelope envelope;
+        trace(z, envelope, ws);
+        return envelope;
+    }
+
+    void trace(const std::vector<double>& z, PhaseEnvelope& envelope, Workspace& ws) const {
+        int n = z.size();
+        int m = n + 2;
+
+        envelope.temperatures.clear();
+        envelope.pressures.clear();
+        envelope.lnK.clear();
+        envelope.incipientVapor.clear();
+        envelope.criticalTemperatures.clear();
+        envelope.criticalPressures.clear();
+        envelope.iterations = 0;
+        envelope.complete = false;
+
+        resize(n, ws);
+
+        bool yVapor = true;
+        int spec = n + 1;
+        double S = log(minimumPressure);
+        if (!initialPoint(z, ws)) return;
+
+        int iterations = 0;
+        if (!solve(z, spec, S, ws, iterations)) return;
+        envelope.iterations += iterations;
+        store(n, ws.X, yVapor, envelope);
+
+        // Leave the starting point towards higher pressure
+        sensitivity(m, ws.tangent, ws);
+        if (ws.tangent[n + 1] < 0.0) {
+            for (int i = 0; i < m; i++) ws.tangent[i] = -ws.tangent[i];
+        }
+
+        bool hasPrevious = false;
+        double step = initialStep;
+
+        while (envelope.size() < maxPoints) {
+            // Specify the variable that changes fastest along the curve
+            spec = 0;
+            for (int i = 1; i < m; i++) {
+                if (std::abs(ws.tangent[i]) > std::abs(ws.tangent[spec])) spec = i;
+            }
+
+            double current = ws.X[spec];
+            double delta = ws.tangent[spec] > 0.0 ? step : -step;
+            bool crossing = false;
+
+            if (spec < n) {
+                double next = current + delta;
+                if (std::abs(current) > criticalApproach && (next * current <= 0.0 || std::abs(next) < criticalApproach)) {
+                    // Land next to ln K_s = 0 first, so the crossing and its interpolation span a short step
+                    delta = (current > 0.0 ? 0.5 : -0.5) * criticalApproach - current;
+                } else if (next * current <= 0.0 || std::abs(next) < criticalApproach) {
+                    delta = -2.0 * current;
+                    crossing = true;
+                }
+            }
+
+            S = current + delta;
+            predict(m, spec, S, hasPrevious, ws);
+
+            // ws.X now holds the prediction, ws.trialX the last point
+            std::swap(ws.trialX, ws.X);
+            iterations = 0;
+            bool converged = solve(z, spec, S, ws, iterations);
+            envelope.iterations += iterations;
+
+            // Only a specified ln K keeps Newton away from the trivial solution K = 1
+            if (converged && spec >= n && maxAbsLnK(n, ws.X) < 1e-4) converged = false;
+
+            if (!converged) {
+                std::swap(ws.trialX, ws.X);
+                step *= 0.5;
+                if (step < minStep) break;
+                continue;
+            }
+
+            ws.previousX.assign(ws.trialX.begin(), ws.trialX.end());
+            ws.previousTangent.assign(ws.tangent.begin(), ws.tangent.end());
+            hasPrevious = true;
+            advance(m, ws);
+
+            if (crossing) {
+                yVapor = !yVapor;
+                criticalPoint(n, spec, envelope, ws);
+            }
+
+            // End exactly on the starting pressure
+            if (ws.X[n + 1] < log(minimumPressure)) {
+                ws.trialX.assign(ws.X.begin(), ws.X.end());
+                iterations = 0;
+                if (!solve(z, n + 1, log(minimumPressure), ws, iterations)) std::swap(ws.trialX, ws.X);
+                envelope.iterations += iterations;
+
+                store(n, ws.X, yVapor, envelope);
+                envelope.complete = true;
+                break;
+            }
+
+            store(n, ws.X, yVapor, envelope);
+
+            double P = exp(ws.X[n + 1]);
+            if (P > maximumPressure) break;
+
+            if (iterations <= 3) {
+                step = std::min(1.5 * step, maxStep);
+            } else if (iterations >= 6) {
+                step *= 0.7;
+            }
+        }
+
+        extrema(z, envelope, ws);
+    }
+
+    /*
+    Solve one point of the envelope with X_spec = S, from the estimate in
+    `X` (ln K_1, ..., ln K_N, ln T, ln P). On success `X` holds the solution
+    and `tangent` the sensitivity dX/dS.
+    */
+    bool solvePoint(const std::vector<double>& z, int spec, double S, std::vector<double>& X, std::vector<double>& tangent, Workspace& ws, int& iterations) const {
+        int n = z.size();
+        resize(n, ws);
+        ws.X.assign(X.begin(), X.end());
+
+        if (!solve(z, spec, S, ws, iterations)) return false;
+
+        X.assign(ws.X.begin(), ws.X.end());
+        sensitivity(n + 2, tangent, ws);
+        return true;
+    }
+
+private:
+    const PengRobinsonEOS& eos;
+
+    void resize(int n, Workspace& ws) const {
+        int m = n + 2;
+        ws.x.resize(n);
+        ws.y.resize(n);
+        ws.F.resize(m);
+        ws.jacobian.resize(m * m);
+        ws.factors.resize(m * m);
+        ws.dX.resize(m);
+        ws.pivots.resize(m);
+        ws.X.resize(m);
+        ws.tangent.resize(m);
+        ws.trialX.resize(m);
+    }
+
+    static double maxAbsLnK(int n, const std::vector<double>& X) {
+        double value = 0.0;
+        for (int i = 0; i < n; i++) value = std::max(value, std::abs(X[i]));
+        return value;
+    }
+
+    // Tangent at the new solution in ws.X, oriented along ws.previousTangent
+    void advance(int m, Workspace& ws) const {
+        sensitivity(m, ws.tangent, ws);
+
+        double dot = 0.0;
+        for (int i = 0; i < m; i++) dot += ws.tangent[i] * ws.previousTangent[i];
+        if (dot < 0.0) {
+            for (int i = 0; i < m; i++) ws.tangent[i] = -ws.tangent[i];
+        }
+    }
+
+    static void store(int n, const std::vector<double>& X, bool yVapor, PhaseEnvelope& envelope) {
+        envelope.incipientVapor.push_back(yVapor);
+        envelope.temperatures.push_back(exp(X[n]));
+        envelope.pressures.push_back(exp(X[n + 1]));
+        envelope.lnK.insert(envelope.lnK.end(), X.begin(), X.begin() + n);
+    }
+
+    // Wilson K-values and the temperature where they satisfy sum_i (y_i - x_i) = 0 at `minimumPressure`
+    bool initialPoint(const std::vector<double>& z, Workspace& ws) const {
+        int n = z.size();
+        const PengRobinsonEOS::ComponentParameters& parameters = eos.getComponentParameters();
+        double P = minimumPressure;
+
+        auto balance = [&](double T) {
+            double sum = 0.0;
+            for (int i = 0; i < n; i++) {
+                double K = parameters.Pc[i] / P * exp(5.373 * (1.0 + parameters.omega[i]) * (1.0 - parameters.Tc[i] / T));
+                sum += z[i] * (K - 1.0) / (1.0 - vaporFraction + vaporFraction * K);
+            }
+            return sum;
+        };
+
+        // The balance grows with T, bisect on ln T
+        double lo = 10.0, hi = 2000.0;
+        if (balance(lo) > 0.0 || balance(hi) < 0.0) return false;
+        for (int k = 0; k < 60; k++) {
+            double mid = sqrt(lo * hi);
+            if (balance(mid) > 0.0) {
+                hi = mid;
+            } else {
+                lo = mid;
+            }
+        }
+
+        double T = sqrt(lo * hi);
+        for (int i = 0; i < n; i++) {
+            ws.X[i] = log(parameters.Pc[i] / P) + 5.373 * (1.0 + parameters.omega[i]) * (1.0 - parameters.Tc[i] / T);
+        }
+        ws.X[n] = log(T);
+        ws.X[n + 1] = log(P);
+
+        return true;
+    }
+
+    // Residuals and Jacobian at ws.X, returns max |F_i|
+    double evaluate(const std::vector<double>& z, int spec, double S, Workspace& ws) const {
+        int n = z.size();
+        int m = n + 2;
+        double beta = vaporFraction;
+        double T = exp(ws.X[n]), P = exp(ws.X[n + 1]);
+
+        double sumX = 0.0, sumY = 0.0;
+        for (int i = 0; i < n; i++) {
+            double K = exp(ws.X[i]);
+            ws.x[i] = z[i] / (1.0 - beta + beta * K);
+            ws.y[i] = K * ws.x[i];
+            sumX += ws.x[i];
+            sumY += ws.y[i];
+        }
+
+        ws.F[n] = sumY - sumX;
+
+        // ln(phi) only depends on the normalized compositions
+        for (int i = 0; i < n; i++) {
+            ws.x[i] /= sumX;
+            ws.y[i] /= sumY;
+        }
+
+        eos.lnPhi(P, T, ws.x, ws.lnPhiL, ws.eos, PhaseRoot::STABLE, &ws.liquidDerivatives);
+        eos.lnPhi(P, T, ws.y, ws.lnPhiV, ws.eos, PhaseRoot::STABLE, &ws.vaporDerivatives);
+
+        const double* dnL = ws.liquidDerivatives.dn.data();
+        const double* dnV = ws.vaporDerivatives.dn.data();
+        double* J = ws.jacobian.data();
+
+        double error = std::abs(ws.F[n]);
+        for (int i = 0; i < n; i++) {
+            ws.F[i] = ws.X[i] + ws.lnPhiV[i] - ws.lnPhiL[i];
+            error = std::max(error, std::abs(ws.F[i]));
+        }
+
+        // d n_j / d ln K_j of the unnormalized phases, divided by their totals
+        for (int j = 0; j < n; j++) {
+            double K = exp(ws.X[j]);
+            double d = 1.0 - beta + beta * K;
+            double dxj = -beta * K * z[j] / (d * d);
+            double dyj = (1.0 - beta) * K * z[j] / (d * d);
+
+            for (int i = 0; i < n; i++) {
+                J[i * m + j] = dnV[i * n + j] * dyj / sumY - dnL[i * n + j] * dxj / sumX;
+            }
+            J[n * m + j] = dyj - dxj;
+            J[j * m + j] += 1.0;
+        }
+
+        for (int i = 0; i < n; i++) {
+            J[i * m + n] = T * (ws.vaporDerivatives.dT[i] - ws.liquidDerivatives.dT[i]);
+            J[i * m + n + 1] = P * (ws.vaporDerivatives.dP[i] - ws.liquidDerivatives.dP[i]);
+        }
+        J[n * m + n] = 0.0;
+        J[n * m + n + 1] = 0.0;
+
+        for (int j = 0; j < m; j++) J[(n + 1) * m + j] = 0.0;
+        J[(n + 1) * m + spec] = 1.0;
+        ws.F[n + 1] = ws.X[spec] - S;
+
+        return error;
+    }
+
+    // Newton's method from ws.X, leaves the Jacobian of the solution in ws.jacobian
+    bool solve(const std::vector<double>& z, int spec, double S, Workspace& ws, int& iterations) const {
+        int n = z.size();
+        int m = n + 2;
+
+        ws.X[spec] = S;
+
+        for (int k = 0; k < maxIterations; k++) {
+            double error = evaluate(z, spec, S, ws);
+            if (!std::isfinite(error)) return false;
+            if (error < tolerance) return true;
+
+            iterations++;
+            std::copy(ws.jacobian.begin(), ws.jacobian.end(), ws.factors.begin());
+            for (int i = 0; i < m; i++) ws.dX[i] = -ws.F[i];
+            if (!LinearAlgebra::solve(ws.factors.data(), ws.dX.data(), m, ws.pivots.data())) return false;
+
+            // Damp steps that would change T, P or a K-value by more than a factor e
+            double alpha = 1.0;
+            for (int i = 0; i < m; i++) {
+                if (std::abs(ws.dX[i]) > 1.0) alpha = std::min(alpha, 1.0 / std::abs(ws.dX[i]));
+            }
+            for (int i = 0; i < m; i++) ws.X[i] += alpha * ws.dX[i];
+        }
+
+        return false;
+    }
+
+    // dX/dS at the last solution, J dX/dS = e_N+2
+    void sensitivity(int m, std::vector<double>& tangent, Workspace& ws) const {
+        std::copy(ws.jacobian.begin(), ws.jacobian.end(), ws.factors.begin());
+        tangent.assign(m, 0.0);
+        tangent[m - 1] = 1.0;
+        LinearAlgebra::solve(ws.factors.data(), tangent.data(), m, ws.pivots.data());
+    }
+
+    /*
+    Estimate of the point at X_spec = S, written to ws.trialX. With the
+    previous point, a cubic Hermite polynomial in X_spec through both points
+    and their tangents; otherwise, or when X_spec is not monotonic between
+    them, a step along the current tangent.
+    */
+    void predict(int m, int spec, double S, bool hasPrevious, Workspace& ws) const {
+        const double* X1 = ws.X.data();
+        double m1 = ws.tangent[spec];
+        double S1 = X1[spec];
+
+        bool cubic = hasPrevious;
+        double S0 = 0.0, m0 = 0.0;
+        if (hasPrevious) {
+            S0 = ws.previousX[spec];
+            m0 = ws.previousTangent[spec];
+            cubic = m0 * m1 > 0.0 && (S1 - S0) * m1 > 0.0;
+        }
+
+        if (!cubic) {
+            for (int i = 0; i < m; i++) {
+                ws.trialX[i] = X1[i] + ws.tangent[i] / m1 * (S - S1);
+            }
+            ws.trialX[spec] = S;
+            return;
+        }
+
+        double h = S1 - S0, u = (S - S0) / h;
+        double h00 = (2.0 * u - 3.0) * u * u + 1.0;
+        double h10 = ((u - 2.0) * u + 1.0) * u;
+        double h01 = (3.0 - 2.0 * u) * u * u;
+        double h11 = (u - 1.0) * u * u;
+
+        for (int i = 0; i < m; i++) {
+            ws.trialX[i] = h00 * ws.previousX[i] + h10 * h * ws.previousTangent[i] / m0
+                + h01 * X1[i] + h11 * h * ws.tangent[i] / m1;
+        }
+        ws.trialX[spec] = S;
+    }
+
+    // Critical point between ws.previousX and ws.X, by cubic interpolation at ln K_spec = 0
+    static void criticalPoint(int n, int spec, PhaseEnvelope& envelope, const Workspace& ws) {
+        double S0 = ws.previousX[spec], S1 = ws.X[spec];
+        double h = S1 - S0, u = -S0 / h;
+        double h00 = (2.0 * u - 3.0) * u * u + 1.0;
+        double h10 = ((u - 2.0) * u + 1.0) * u;
+        double h01 = (3.0 - 2.0 * u) * u * u;
+        double h11 = (u - 1.0) * u * u;
+
+        double lnTP[2];
+        for (int k = 0; k < 2; k++) {
+            int i = n + k;
+            lnTP[k] = h00 * ws.previousX[i] + h10 * h * ws.previousTangent[i] / ws.previousTangent[spec]
+                + h01 * ws.X[i] + h11 * h * ws.tangent[i] / ws.tangent[spec];
+        }
+
+        envelope.criticalTemperatures.push_back(exp(lnTP[0]));
+        envelope.criticalPressures.push_back(exp(lnTP[1]));
+    }
+
+    // Cricondenbar and cricondentherm, refined from the highest stored points
+    void extrema(const std::vector<double>& z, PhaseEnvelope& envelope, Workspace& ws) const {
+        int n = z.size();
+        int nPoints = envelope.size();
+        if (nPoints == 0) return;
+
+        int kP = std::max_element(envelope.pressures.begin(), envelope.pressures.end()) - envelope.pressures.begin();
+        int kT = std::max_element(envelope.temperatures.begin(), envelope.temperatures.end()) - envelope.temperatures.begin();
+
+        // Highest pressure at fixed ln T, highest temperature at fixed ln P
+        maximum(z, envelope, kP, n + 1, n, envelope.cricondenbarTemperature, envelope.cricondenbarPressure, ws);
+        maximum(z, envelope, kT, n, n + 1, envelope.cricondenthermTemperature, envelope.cricondenthermPressure, ws);
+    }
+
+    /*
+    Maximum of X_value along the envelope near point k, by the secant method
+    on dX_value/dX_spec = 0 with X_spec specified. Falls back to point k when
+    the maximum is an end of the trace or a point fails to converge.
+    */
+    void maximum(const std::vector<double>& z, PhaseEnvelope& envelope, int k, int value, int spec, double& temperature, double& pressure, Workspace& ws) const {
+        int n = z.size();
+        int nPoints = envelope.size();
+
+        temperature = envelope.temperatures[k];
+        pressure = envelope.pressures[k];
+        if (k == 0 || k == nPoints - 1) return;
+
+        bool yVapor = envelope.incipientVapor[k];
+        std::vector<double> X(n + 2), tangent(n + 2), next(n + 2);
+
+        auto point = [&](int index) {
+            std::copy(envelope.lnK.begin() + index * n, envelope.lnK.begin() + (index + 1) * n, X.begin());
+            X[n] = log(envelope.temperatures[index]);
+            X[n + 1] = log(envelope.pressures[index]);
+        };
+
+        int iterations = 0;
+        point(k);
+        if (!solvePoint(z, spec, X[spec], X, tangent, ws, iterations)) return;
+
+        double S1 = X[spec], slope1 = tangent[value] / tangent[spec];
+
+        // Second point from the neighbour on the rising side
+        double before = log(spec == n ? envelope.temperatures[k - 1] : envelope.pressures[k - 1]);
+        int other = (before - S1) * slope1 > 0.0 ? k - 1 : k + 1;
+        if (envelope.incipientVapor[other] != yVapor) return;
+
+        point(other);
+        if (!solvePoint(z, spec, X[spec], X, tangent, ws, iterations)) return;
+        double S0 = X[spec], slope0 = tangent[value] / tangent[spec];
+
+        for (int iteration = 0; iteration < 20; iteration++) {
+            if (slope1 == slope0) break;
+            double S = S1 - slope1 * (S1 - S0) / (slope1 - slope0);
+
+            for (int i = 0; i < n + 2; i++) {
+                next[i] = X[i] + tangent[i] / tangent[spec] * (S - X[spec]);
+            }
+            if (!solvePoint(z, spec, S, next, tangent, ws, iterations)) return;
+
+            X.swap(next);
+            S0 = S1;
+            slope0 = slope1;
+            S1 = S;
+            slope1 = tangent[value] / tangent[spec];
+
+            temperature = exp(X[n]);
+            pressure = exp(X[n + 1]);
+
+            if (std::abs(S1 - S0) < 1e-10) break;
+        }
+
+        envelope.iterations += iterations;
+    }
+};
+
+#endif
@@ -0,0 +1,284 @@
+// RachfordRice.cpp
+// Implementation of the Rachford-Rice solvers
+#include "../include/RachfordRice.hpp"
+#include "../include/LinearAlgebra.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace RachfordRice {
+
+    double residual(const double* z, const double* K, int n, double beta) {
+        double f = 0.0;
+
+        for (int i = 0; i < n; i++) {
+            f += z[i] * (K[i] - 1.0) / (1.0 + beta * (K[i] - 1.0));
+        }
+
+        return f;
+    }
+
+    bool window(const double* z, const double* K, int n, double& betaMin, double& betaMax) {
+        betaMin = -std::numeric_limits<double>::infinity();
+        betaMax = std::numeric_limits<double>::infinity();
+
+        for (int i = 0; i < n; i++) {
+            if (K[i] > 1.0) {
+                betaMin = std::max(betaMin, (K[i] * z[i] - 1.0) / (K[i] - 1.0));
+            } else if (K[i] < 1.0) {
+                betaMax = std::min(betaMax, (1.0 - z[i]) / (1.0 - K[i]));
+            }
+        }
+
+        return std::isfinite(betaMin) && std::isfinite(betaMax);
+    }
+
+    double solve(const double* z, const double* K, int n, double initialGuess, double tolerance, int maxIterations) {
+        double lo, hi;
+
+        if (!window(z, K, n, lo, hi)) {
+            return std::isfinite(lo) ? 1.0 : 0.0;
+        }
+
+        double beta = (initialGuess > lo && initialGuess < hi) ? initialGuess : 0.5 * (lo + hi);
+
+        for (int k = 0; k < maxIterations; k++) {
+            double f = 0.0, df = 0.0;
+
+            for (int i = 0; i < n; i++) {
+                double t = 1.0 / (1.0 + beta * (K[i] - 1.0));
+                double u = (K[i] - 1.0) * t;
+                f += z[i] * u;
+                df -= z[i] * u * u;
+            }
+
+            if (f == 0.0) break;
+
+            // f decreases monotonically inside the window
+            if (f > 0.0) lo = beta; else hi = beta;
+
+            // A Newton step within the tolerance is kept even if rounding puts it on a bound of the bracket
+            double next = beta - f / df;
+            bool converging = std::abs(next - beta) <= tolerance * std::max(1.0, std::abs(beta));
+            if (!converging && !(next > lo && next < hi)) next = 0.5 * (lo + hi);
+
+            double step = std::abs(next - beta);
+            beta = next;
+
+            if (step <= tolerance * std::max(1.0, std::abs(beta))) break;
+        }
+
+        return beta;
+    }
+
+    // Smallest t_i - max(z_i, max_j K_ij z_i) at beta, positive inside the region of `multiphase`
+    static double margin(const double* z, const double* K, int n, int m, const double* beta) {
+        double worst = std::numeric_limits<double>::infinity();
+
+        for (int i = 0; i < n; i++) {
+            if (z[i] <= 0.0) continue;
+
+            double t = 1.0, bound = z[i];
+            for (int j = 0; j < m; j++) {
+                t += beta[j] * (K[i * m + j] - 1.0);
+                bound = std::max(bound, K[i * m + j] * z[i]);
+            }
+            worst = std::min(worst, t - bound);
+        }
+
+        return worst;
+    }
+
+    // F(beta) = -sum_i z_i ln t_i
+    static double objective(const double* z, const double* K, int n, int m, const double* beta) {
+        double F = 0.0;
+
+        for (int i = 0; i < n; i++) {
+            if (z[i] <= 0.0) continue;
+
+            double t = 1.0;
+            for (int j = 0; j < m; j++) {
+                t += beta[j] * (K[i * m + j] - 1.0);
+            }
+            F -= z[i] * log(t);
+        }
+
+        return F;
+    }
+
+    /*
+    Move `beta` inside the region of `multiphase`, where r_i = 1 - t_i / c_i < 0
+    with c_i = max(z_i, max_j K_ij z_i). The barrier function
+        s - mu sum_i ln(s - r_i)
+    is minimized in (beta, s) by Newton's method for decreasing mu, from an s
+    above every r_i, until max r_i < 0. Returns false if that did not happen.
+    */
+    static bool feasiblePoint(const double* z, const double* K, int n, int m, double* beta) {
+        const int size = m + 1;
+        double g[MAX_PHASES + 1], H[(MAX_PHASES + 1) * (MAX_PHASES + 1)], d[MAX_PHASES + 1], v[MAX_PHASES + 1];
+        int pivots[MAX_PHASES + 1];
+
+        // r_i at b, and dr_i/dbeta_j = -(K_ij - 1) / c_i in `gradient` if given
+        auto constraint = [&](int i, const double* b, double* gradient) {
+            double t = 1.0, bound = z[i];
+            for (int j = 0; j < m; j++) {
+                t += b[j] * (K[i * m + j] - 1.0);
+                bound = std::max(bound, K[i * m + j] * z[i]);
+            }
+            if (gradient) {
+                for (int j = 0; j < m; j++) gradient[j] = -(K[i * m + j] - 1.0) / bound;
+            }
+            return 1.0 - t / bound;
+        };
+        auto worst = [&](const double* b) {
+            double r = -std::numeric_limits<double>::infinity();
+            for (int i = 0; i < n; i++) {
+                if (z[i] > 0.0) r = std::max(r, constraint(i, b, nullptr));
+            }
+            return r;
+        };
+
+        double x[MAX_PHASES + 1], trial[MAX_PHASES + 1];
+        std::copy(beta, beta + m, x);
+        x[m] = worst(x) + 1.0;
+
+        auto barrier = [&](const double* u, double mu) {
+            double phi = u[m];
+            for (int i = 0; i < n; i++) {
+                if (z[i] <= 0.0) continue;
+                double gap = u[m] - constraint(i, u, nullptr);
+                if (!(gap > 0.0)) return std::numeric_limits<double>::infinity();
+                phi -= mu * log(gap);
+            }
+            return phi;
+        };
+
+        for (double mu = 1.0; mu > 1e-12; mu *= 0.1) {
+            for (int iteration = 0; iteration < 20; iteration++) {
+                std::fill(g, g + size, 0.0);
+                std::fill(H, H + size * size, 0.0);
+                g[m] = 1.0;
+
+                for (int i = 0; i < n; i++) {
+                    if (z[i] <= 0.0) continue;
+
+                    // d(s - r_i) = (-dr_i/dbeta, 1)
+                    double gap = x[m] - constraint(i, x, v);
+                    for (int j = 0; j < m; j++) v[j] = -v[j];
+                    v[m] = 1.0;
+
+                    for (int j = 0; j < size; j++) {
+                        g[j] -= mu * v[j] / gap;
+                        for (int k = 0; k < size; k++) H[j * size + k] += mu * v[j] * v[k] / (gap * gap);
+                    }
+                }
+
+                for (int j = 0; j < size; j++) {
+                    H[j * size + j] *= 1.0 + 1e-12;
+                    d[j] = -g[j];
+                }
+                if (!LinearAlgebra::solve(H, d, size, pivots)) return false;
+
+                double alpha = 1.0, phi = barrier(x, mu);
+                bool decreased = false;
+                for (int k = 0; k < 50 && !decreased; k++) {
+                    for (int j = 0; j < size; j++) trial[j] = x[j] + alpha * d[j];
+                    decreased = barrier(trial, mu) < phi;
+                    alpha *= 0.5;
+                }
+                if (!decreased) break;
+                std::copy(trial, trial + size, x);
+
+                if (worst(x) < 0.0) {
+                    std::copy(x, x + m, beta);
+                    return true;
+                }
+                if (2.0 * alpha * std::abs(d[m]) < 1e-14) break;
+            }
+        }
+
+        return false;
+    }
+
+    bool multiphase(const double* z, const double* K, int n, int m, double* beta, double tolerance, int maxIterations) {
+        if (m > MAX_PHASES) return false;
+        if (m == 0) return true;
+
+        double g[MAX_PHASES], H[MAX_PHASES * MAX_PHASES], d[MAX_PHASES], trial[MAX_PHASES];
+        int pivots[MAX_PHASES];
+
+        if (!(margin(z, K, n, m, beta) > 0.0) && !feasiblePoint(z, K, n, m, beta)) return false;
+
+        double F = objective(z, K, n, m, beta);
+
+        for (int iteration = 0; iteration < maxIterations; iteration++) {
+            std::fill(g, g + m, 0.0);
+            std::fill(H, H + m * m, 0.0);
+
+            // dF/dbeta_j = sum_i z_i (1 - K_ij) / t_i, d2F/dbeta_j dbeta_k = sum_i z_i (1 - K_ij) (1 - K_ik) / t_i^2
+            for (int i = 0; i < n; i++) {
+                if (z[i] <= 0.0) continue;
+
+                double t = 1.0;
+                for (int j = 0; j < m; j++) t += beta[j] * (K[i * m + j] - 1.0);
+
+                double w = z[i] / t;
+                for (int j = 0; j < m; j++) {
+                    double aj = (1.0 - K[i * m + j]) * w;
+                    g[j] += aj;
+                    for (int k = 0; k <= j; k++) {
+                        H[j * m + k] += aj * (1.0 - K[i * m + k]) * w / z[i];
+                    }
+                }
+            }
+
+            double gradient = 0.0;
+            for (int j = 0; j < m; j++) {
+                gradient = std::max(gradient, std::abs(g[j]));
+                for (int k = 0; k < j; k++) H[k * m + j] = H[j * m + k];
+                d[j] = -g[j];
+            }
+            if (gradient < tolerance) return true;
+
+            if (!LinearAlgebra::solve(H, d, m, pivots)) return false;
+
+            // Largest step inside the region: t_i decreases along d for sum_j (1 - K_ij) d_j > 0
+            double alpha = 1.0;
+            for (int i = 0; i < n; i++) {
+                if (z[i] <= 0.0) continue;
+
+                double t = 1.0, bound = z[i], slope = 0.0;
+                for (int j = 0; j < m; j++) {
+                    t += beta[j] * (K[i * m + j] - 1.0);
+                    bound = std::max(bound, K[i * m + j] * z[i]);
+                    slope += (1.0 - K[i * m + j]) * d[j];
+                }
+                if (slope > 0.0) alpha = std::min(alpha, 0.99 * (t - bound) / slope);
+            }
+
+            // Backtrack until F decreases enough, F being convex the full Newton step is taken near the minimum
+            double descent = 0.0;
+            for (int j = 0; j < m; j++) descent += g[j] * d[j];
+
+            double next = F;
+            for (int k = 0; k < 30; k++) {
+                for (int j = 0; j < m; j++) trial[j] = beta[j] + alpha * d[j];
+                next = objective(z, K, n, m, trial);
+                if (next <= F + 1e-4 * alpha * descent) break;
+                alpha *= 0.5;
+            }
+
+            double step = 0.0;
+            for (int j = 0; j < m; j++) {
+                step = std::max(step, std::abs(trial[j] - beta[j]));
+                beta[j] = trial[j];
+            }
+            F = next;
+
+            if (step <= tolerance) return true;
+        }
+
+        return false;
+    }
+
+}
@@ -11,12 +11,11 @@
 
 namespace RootFind {
 
-    std::complex<double> Laguerre(const std::vector<std::complex<double>>& a, std::complex<double>& x) {
+    std::complex<double> Laguerre(const std::complex<double>* a, int m, std::complex<double>& x) {
         const int MR = 8, MT = 10, MAXIT = MT * MR;
         const double EPS = std::numeric_limits<double>::epsilon();
         static const double frac[MR + 1] = {0.0, 0.5, 0.25, 0.75, 0.13, 0.38, 0.62, 0.88, 1.0};
         std::complex<double> dx, x1, b, d, f, g, h, sq, gp, gm, g2;
-        int m = a.size() - 1;
 
         for (int i = 1; i < MAXIT; i++) {
             b = a[m];
@@ -56,22 +55,29 @@ namespace RootFind {
         throw std::runtime_error("Method did not converge within the maximum number of iterations.");
     }
 
+    std::complex<double> Laguerre(const std::vector<std::complex<double>>& a, std::complex<double>& x) {
+        return Laguerre(a.data(), a.size() - 1, x);
+    }
+
     std::vector<std::complex<double>> roots(const std::vector<std::complex<double>>& a) {
+        std::vector<std::complex<double>> results, work;
+        roots(a, results, work);
+        return results;
+    }
+
+    void roots(const std::vector<std::complex<double>>& a, std::vector<std::complex<double>>& results, std::vector<std::complex<double>>& work) {
         const double EPS = 1.0e-14;
         int i;
         std::complex<double> x, b, c;
         int m = a.size() - 1;
-        std::vector<std::complex<double>> ad(m + 1), results(m);
+        std::vector<std::complex<double>>& ad = work;
 
-        for (int j = 0; j <= m; j++) ad[j] = a[j];
+        ad.assign(a.begin(), a.end());
+        results.resize(m);
 
         for (int j = m - 1; j >= 0; j--) {
             x = 0.0;
-            std::vector<std::complex<double>> ad_v(j + 2);
-
-            for (int k = 0; k < j + 2; k++) ad_v[k] = ad[k];
-
-            x = Laguerre(ad_v, x);
+            x = Laguerre(ad.data(), j + 1, x);
 
             if (abs(std::imag(x)) <= 2.0 * EPS * abs(std::real(x))) {
                 x = std::complex<double>(std::real(x), 0.0);
@@ -87,7 +93,7 @@ namespace RootFind {
             }
         }
 
-        for (int j = 0; j < m; j++) results[j] = Laguerre(a, results[j]);
+        for (int j = 0; j < m; j++) results[j] = Laguerre(a.data(), m, results[j]);
 
         for (int j = 1; j < m; j++) {
             x = results[j];
@@ -97,8 +103,74 @@ namespace RootFind {
             }
             results[i + 1] = x;
         }
+    }
 
-        return results;
+    int cubicRoots(double a0, double a1, double a2, double x[3]) {
+        const double EPS = std::numeric_limits<double>::epsilon();
+        const double PI = 3.14159265358979323846;
+        int n;
+
+        // Depressed cubic t^3 + p t + q with x = t - a2 / 3
+        double shift = a2 / 3.0;
+        double p = a1 - a2 * shift;
+        double q = a0 - a1 * shift + 2.0 * shift * shift * shift;
+        double halfQ = 0.5 * q, thirdP = p / 3.0;
+        double disc = halfQ * halfQ + thirdP * thirdP * thirdP;
+        double scale = halfQ * halfQ + std::abs(thirdP * thirdP * thirdP);
+
+        if (scale == 0.0) {
+            // Triple root
+            x[0] = x[1] = x[2] = 0.0 - shift;
+            n = 3;
+        } else if (std::abs(disc) <= 64.0 * EPS * scale) {
+            // Double root (or triple root when p ~ q ~ 0)
+            double u = std::cbrt(-halfQ);
+            x[0] = 2.0 * u - shift;
+            x[1] = x[2] = -u - shift;
+            n = 3;
+        } else if (disc > 0.0) {
+            // One real root, Cardano's formula written to avoid cancellation
+            double u = -std::copysign(std::cbrt(std::abs(halfQ) + std::sqrt(disc)), q);
+            double v = (u != 0.0) ? -thirdP / u : 0.0;
+            x[0] = u + v - shift;
+            n = 1;
+        } else {
+            // Three distinct real roots, trigonometric method
+            double r = 2.0 * std::sqrt(-thirdP);
+            double cosArg = 3.0 * q / (p * r);
+            double phi = std::acos(std::max(-1.0, std::min(1.0, cosArg))) / 3.0;
+            x[0] = r * std::cos(phi) - shift;
+            x[1] = r * std::cos(phi - 2.0 * PI / 3.0) - shift;
+            x[2] = r * std::cos(phi - 4.0 * PI / 3.0) - shift;
+            n = 3;
+        }
+
+        for (int k = 0; k < n; k++) {
+            double xk = x[k];
+            double f = ((xk + a2) * xk + a1) * xk + a0;
+
+            for (int it = 0; it < 2 && f != 0.0; it++) {
+                double df = (3.0 * xk + 2.0 * a2) * xk + a1;
+                if (df == 0.0) break;
+
+                double xNew = xk - f / df;
+                double fNew = ((xNew + a2) * xNew + a1) * xNew + a0;
+                if (std::abs(fNew) >= std::abs(f)) break;
+
+                xk = xNew;
+                f = fNew;
+            }
+
+            x[k] = xk;
+        }
+
+        if (n == 3) {
+            if (x[0] > x[1]) std::swap(x[0], x[1]);
+            if (x[1] > x[2]) std::swap(x[1], x[2]);
+            if (x[0] > x[1]) std::swap(x[0], x[1]);
+        }
+
+        return n;
     }
 }
 
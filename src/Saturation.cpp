@@ -0,0 +1,354 @@
+#ifndef SATURATION
+#define SATURATION
+
+#include "PengRobinson.cpp"
+#include "../include/LinearAlgebra.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Kind of saturation point: the feed is a liquid at its bubble point, or a vapor at its dew point
+enum class SaturationType {
+    BUBBLE,
+    DEW
+};
+
+/*
+Struct to store a saturation point.
+
+Fields:
+- `temperature`, `pressure`: Saturation state (in K and Pa);
+- `lnK`: ln K_i = ln(y_i / x_i), with the incipient phase y_i = K_i z_i at a
+    bubble point and x_i = z_i / K_i at a dew point;
+- `iterations`: Newton iterations of this point;
+- `converged`: Whether Newton converged to a non-trivial solution.
+*/
+struct SaturationPoint {
+    double temperature = 0.0;
+    double pressure = 0.0;
+    std::vector<double> lnK;
+    int iterations = 0;
+    bool converged = false;
+};
+
+/*
+Bubble and dew point solver with the Peng-Robinson EoS.
+
+With the feed z in one phase and the incipient phase w, the unknowns
+X = (ln K_1, ..., ln K_N, ln T, ln P) solve
+    F_i = ln K_i + s (ln(phi_i(w)) - ln(phi_i(z))) = 0,
+    F_N+1 = sum_i w_i - 1 = 0,
+    F_N+2 = X_s - S = 0,
+with w_i = z_i K_i^s, s = 1 for a bubble point and s = -1 for a dew point,
+and S the specified ln T or ln P. Only ln(phi(w)) depends on the K-values,
+and Newton's method uses its analytic composition, temperature and
+pressure derivatives.
+
+A single point starts from Wilson K-values, at the pressure or the
+temperature where they satisfy F_N+1. In the batched calls each point
+starts from the previous solution, extrapolated along dX/dS = J^-1 e_N+2
+from the Jacobian of that solution, and falls back to Wilson when Newton
+fails. Solutions with max |ln K_i| below `trivialTolerance` are the
+trivial solution and count as failures.
+*/
+class SaturationSolver {
+public:
+    // Scratch buffers of the Newton iterations, must not be shared between threads
+    struct Workspace {
+        PengRobinsonEOS::Workspace eos;
+        PengRobinsonEOS::FugacityDerivatives feedDerivatives;
+        PengRobinsonEOS::FugacityDerivatives incipientDerivatives;
+        std::vector<double> lnPhiZ;
+        std::vector<double> lnPhiW;
+        std::vector<double> w;
+        std::vector<double> F;
+        std::vector<double> jacobian;
+        std::vector<double> dX;
+        std::vector<int> pivots;
+        std::vector<double> X;
+        std::vector<double> tangent;
+        std::vector<double> previousX;
+    };
+
+    double tolerance = 1e-10;        // On max |F_i|
+    int maxIterations = 30;          // Newton iterations per point
+    double trivialTolerance = 1e-4;  // On max |ln K_i| of a solution
+
+    explicit SaturationSolver(const PengRobinsonEOS& eos) : eos(eos) {}
+
+    Workspace createWorkspace() const {
+        Workspace ws;
+        ws.eos = eos.createWorkspace();
+        return ws;
+    }
+
+    // Saturation pressure at the temperature T (in K), from Wilson K-values
+    SaturationPoint pressure(SaturationType type, double T, const std::vector<double>& z) const {
+        Workspace ws = createWorkspace();
+        SaturationPoint point;
+        pressure(type, T, z, point, ws);
+        return point;
+    }
+
+    void pressure(SaturationType type, double T, const std::vector<double>& z, SaturationPoint& point, Workspace& ws) const {
+        resize(z.size(), ws);
+        point.iterations = 0;
+        point.converged = wilsonPressure(type, T, z, ws) && solve(type, z, z.size(), log(T), ws, point.iterations);
+        store(z.size(), point, ws);
+    }
+
+    // Saturation temperature at the pressure P (in Pa), from Wilson K-values
+    SaturationPoint temperature(SaturationType type, double P, const std::vector<double>& z) const {
+        Workspace ws = createWorkspace();
+        SaturationPoint point;
+        temperature(type, P, z, point, ws);
+        return point;
+    }
+
+    void temperature(SaturationType type, double P, const std::vector<double>& z, SaturationPoint& point, Workspace& ws) const {
+        resize(z.size(), ws);
+        point.iterations = 0;
+        point.converged = wilsonTemperature(type, P, z, ws) && solve(type, z, z.size() + 1, log(P), ws, point.iterations);
+        store(z.size(), point, ws);
+    }
+
+    // Saturation pressures at each of `temperatures`, every point seeded from the previous one
+    std::vector<SaturationPoint> pressures(SaturationType type, const std::vector<double>& temperatures, const std::vector<double>& z) const {
+        Workspace ws = createWorkspace();
+        std::vector<SaturationPoint> points;
+        pressures(type, temperatures, z, points, ws);
+        return points;
+    }
+
+    void pressures(SaturationType type, const std::vector<double>& temperatures, const std::vector<double>& z, std::vector<SaturationPoint>& points, Workspace& ws) const {
+        sequence(type, temperatures, z, z.size(), points, ws);
+    }
+
+    // Saturation temperatures at each of `pressures`, every point seeded from the previous one
+    std::vector<SaturationPoint> temperatures(SaturationType type, const std::vector<double>& pressures, const std::vector<double>& z) const {
+        Workspace ws = createWorkspace();
+        std::vector<SaturationPoint> points;
+        temperatures(type, pressures, z, points, ws);
+        return points;
+    }
+
+    void temperatures(SaturationType type, const std::vector<double>& pressures, const std::vector<double>& z, std::vector<SaturationPoint>& points, Workspace& ws) const {
+        sequence(type, pressures, z, z.size() + 1, points, ws);
+    }
+
+private:
+    const PengRobinsonEOS& eos;
+
+    void resize(int n, Workspace& ws) const {
+        int m = n + 2;
+        ws.w.resize(n);
+        ws.F.resize(m);
+        ws.jacobian.resize(m * m);
+        ws.dX.resize(m);
+        ws.pivots.resize(m);
+        ws.X.resize(m);
+        ws.tangent.resize(m);
+        ws.previousX.resize(m);
+    }
+
+    static void store(int n, SaturationPoint& point, const Workspace& ws) {
+        point.lnK.assign(ws.X.begin(), ws.X.begin() + n);
+        point.temperature = exp(ws.X[n]);
+        point.pressure = exp(ws.X[n + 1]);
+    }
+
+    // Points at each value of X_spec, from the previous solution and its tangent when there is one
+    void sequence(SaturationType type, const std::vector<double>& values, const std::vector<double>& z, int spec, std::vector<SaturationPoint>& points, Workspace& ws) const {
+        int n = z.size();
+        int m = n + 2;
+        resize(n, ws);
+        points.resize(values.size());
+
+        bool seeded = false;
+        double previousS = 0.0;
+
+        for (std::size_t k = 0; k < values.size(); k++) {
+            SaturationPoint& point = points[k];
+            double S = log(values[k]);
+            point.iterations = 0;
+            point.converged = false;
+
+            if (seeded) {
+                // First order prediction, then the previous solution itself
+                std::copy(ws.X.begin(), ws.X.end(), ws.previousX.begin());
+                for (int i = 0; i < m; i++) ws.X[i] += ws.tangent[i] * (S - previousS);
+                point.converged = solve(type, z, spec, S, ws, point.iterations);
+
+                if (!point.converged) {
+                    std::copy(ws.previousX.begin(), ws.previousX.end(), ws.X.begin());
+                    point.converged = solve(type, z, spec, S, ws, point.iterations);
+                }
+            }
+
+            if (!point.converged) {
+                bool initialized = spec == n ? wilsonPressure(type, values[k], z, ws) : wilsonTemperature(type, values[k], z, ws);
+                point.converged = initialized && solve(type, z, spec, S, ws, point.iterations);
+            }
+
+            store(n, point, ws);
+
+            seeded = point.converged;
+            if (seeded) {
+                sensitivity(m, ws);
+                previousS = S;
+            }
+        }
+    }
+
+    // Wilson K-value of component i, at T and P
+    double wilsonLnK(int i, double T, double P) const {
+        const PengRobinsonEOS::ComponentParameters& parameters = eos.getComponentParameters();
+        return log(parameters.Pc[i] / P) + 5.373 * (1.0 + parameters.omega[i]) * (1.0 - parameters.Tc[i] / T);
+    }
+
+    // Wilson K-values at T and the pressure where sum_i w_i = 1, which is explicit
+    bool wilsonPressure(SaturationType type, double T, const std::vector<double>& z, Workspace& ws) const {
+        int n = z.size();
+
+        // At P = 1 Pa, sum_i z_i K_i = P_bubble and sum_i z_i / K_i = 1 / P_dew
+        double sum = 0.0;
+        for (int i = 0; i < n; i++) {
+            double K = exp(wilsonLnK(i, T, 1.0));
+            sum += type == SaturationType::BUBBLE ? z[i] * K : z[i] / K;
+        }
+        double P = type == SaturationType::BUBBLE ? sum : 1.0 / sum;
+        if (!(P > 0.0) || !std::isfinite(P)) return false;
+
+        for (int i = 0; i < n; i++) ws.X[i] = wilsonLnK(i, T, P);
+        ws.X[n] = log(T);
+        ws.X[n + 1] = log(P);
+
+        return true;
+    }
+
+    // Wilson K-values at P and the temperature where sum_i w_i = 1, by bisection on ln T
+    bool wilsonTemperature(SaturationType type, double P, const std::vector<double>& z, Workspace& ws) const {
+        int n = z.size();
+        double s = type == SaturationType::BUBBLE ? 1.0 : -1.0;
+
+        // sum_i z_i K_i grows with T, and sum_i z_i / K_i decreases
+        auto balance = [&](double T) {
+            double sum = 0.0;
+            for (int i = 0; i < n; i++) sum += z[i] * exp(s * wilsonLnK(i, T, P));
+            return s * (sum - 1.0);
+        };
+
+        double lo = 10.0, hi = 2000.0;
+        if (balance(lo) > 0.0 || balance(hi) < 0.0) return false;
+        for (int k = 0; k < 60; k++) {
+            double mid = sqrt(lo * hi);
+            if (balance(mid) > 0.0) {
+                hi = mid;
+            } else {
+                lo = mid;
+            }
+        }
+
+        double T = sqrt(lo * hi);
+        for (int i = 0; i < n; i++) ws.X[i] = wilsonLnK(i, T, P);
+        ws.X[n] = log(T);
+        ws.X[n + 1] = log(P);
+
+        return true;
+    }
+
+    // Residuals and Jacobian at ws.X, returns max |F_i|
+    double evaluate(SaturationType type, const std::vector<double>& z, int spec, double S, Workspace& ws) const {
+        int n = z.size();
+        int m = n + 2;
+        double s = type == SaturationType::BUBBLE ? 1.0 : -1.0;
+        double T = exp(ws.X[n]), P = exp(ws.X[n + 1]);
+
+        double sumW = 0.0;
+        for (int i = 0; i < n; i++) {
+            ws.w[i] = z[i] * exp(s * ws.X[i]);
+            sumW += ws.w[i];
+        }
+        ws.F[n] = sumW - 1.0;
+
+        // ln(phi) only depends on the normalized composition
+        for (int i = 0; i < n; i++) ws.w[i] /= sumW;
+
+        eos.lnPhi(P, T, z, ws.lnPhiZ, ws.eos, PhaseRoot::STABLE, &ws.feedDerivatives);
+        eos.lnPhi(P, T, ws.w, ws.lnPhiW, ws.eos, PhaseRoot::STABLE, &ws.incipientDerivatives);
+
+        const double* dn = ws.incipientDerivatives.dn.data();
+        double* J = ws.jacobian.data();
+
+        double error = std::abs(ws.F[n]);
+        for (int i = 0; i < n; i++) {
+            ws.F[i] = ws.X[i] + s * (ws.lnPhiW[i] - ws.lnPhiZ[i]);
+            error = std::max(error, std::abs(ws.F[i]));
+        }
+
+        // d w_j / d ln K_j = s w_j on the unnormalized composition, then divided by its total
+        for (int j = 0; j < n; j++) {
+            for (int i = 0; i < n; i++) {
+                J[i * m + j] = dn[i * n + j] * ws.w[j];
+            }
+            J[n * m + j] = s * ws.w[j] * sumW;
+            J[j * m + j] += 1.0;
+        }
+
+        for (int i = 0; i < n; i++) {
+            J[i * m + n] = s * T * (ws.incipientDerivatives.dT[i] - ws.feedDerivatives.dT[i]);
+            J[i * m + n + 1] = s * P * (ws.incipientDerivatives.dP[i] - ws.feedDerivatives.dP[i]);
+        }
+        J[n * m + n] = 0.0;
+        J[n * m + n + 1] = 0.0;
+
+        for (int j = 0; j < m; j++) J[(n + 1) * m + j] = 0.0;
+        J[(n + 1) * m + spec] = 1.0;
+        ws.F[n + 1] = ws.X[spec] - S;
+
+        return error;
+    }
+
+    // Newton's method from ws.X, leaves the LU factors of the Jacobian of the solution in ws.jacobian
+    bool solve(SaturationType type, const std::vector<double>& z, int spec, double S, Workspace& ws, int& iterations) const {
+        int n = z.size();
+        int m = n + 2;
+
+        ws.X[spec] = S;
+
+        for (int k = 0; k <= maxIterations; k++) {
+            double error = evaluate(type, z, spec, S, ws);
+            if (!std::isfinite(error)) return false;
+            if (LinearAlgebra::factorize(ws.jacobian.data(), m, ws.pivots.data()) == 0) return false;
+
+            if (error < tolerance) {
+                double largest = 0.0;
+                for (int i = 0; i < n; i++) largest = std::max(largest, std::abs(ws.X[i]));
+                return largest > trivialTolerance;
+            }
+            if (k == maxIterations) break;
+
+            iterations++;
+            for (int i = 0; i < m; i++) ws.dX[i] = -ws.F[i];
+            LinearAlgebra::substitute(ws.jacobian.data(), ws.dX.data(), m, ws.pivots.data());
+
+            // Damp steps that would change T, P or a K-value by more than a factor e
+            double alpha = 1.0;
+            for (int i = 0; i < m; i++) {
+                if (std::abs(ws.dX[i]) > 1.0) alpha = std::min(alpha, 1.0 / std::abs(ws.dX[i]));
+            }
+            for (int i = 0; i < m; i++) ws.X[i] += alpha * ws.dX[i];
+        }
+
+        return false;
+    }
+
+    // dX/dS at the last solution, J dX/dS = e_N+2 with the factors left by `solve`
+    void sensitivity(int m, Workspace& ws) const {
+        std::fill(ws.tangent.begin(), ws.tangent.end(), 0.0);
+        ws.tangent[m - 1] = 1.0;
+        LinearAlgebra::substitute(ws.jacobian.data(), ws.tangent.data(), m, ws.pivots.data());
+    }
+};
+
+#endif
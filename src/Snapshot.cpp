@@ -0,0 +1,315 @@
+#include "../include/Snapshot.hpp"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Snapshot {
+
+    static_assert(sizeof(StringRef) == 8, "Unexpected StringRef layout.");
+    static_assert(sizeof(Header) == 56, "Unexpected Header layout.");
+    static_assert(sizeof(GasRecord) == 88, "Unexpected GasRecord layout.");
+    static_assert(sizeof(InteractionParameterRecord) == 64, "Unexpected InteractionParameterRecord layout.");
+
+    MappedFile::MappedFile(const std::string& filePath) {
+#ifdef _WIN32
+        HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("Failed to open the snapshot file " + filePath + ".");
+        }
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+            CloseHandle(file);
+            throw std::runtime_error("Failed to read the size of the snapshot file " + filePath + ".");
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr) {
+            CloseHandle(file);
+            throw std::runtime_error("Failed to map the snapshot file " + filePath + ".");
+        }
+
+        void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (view == nullptr) {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            throw std::runtime_error("Failed to map the snapshot file " + filePath + ".");
+        }
+
+        fileHandle_ = file;
+        mappingHandle_ = mapping;
+        data_ = static_cast<const unsigned char*>(view);
+        size_ = static_cast<std::size_t>(fileSize.QuadPart);
+#else
+        int fd = ::open(filePath.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open the snapshot file " + filePath + ".");
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            throw std::runtime_error("Failed to read the size of the snapshot file " + filePath + ".");
+        }
+
+        void* view = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+
+        if (view == MAP_FAILED) {
+            throw std::runtime_error("Failed to map the snapshot file " + filePath + ".");
+        }
+
+        data_ = static_cast<const unsigned char*>(view);
+        size_ = static_cast<std::size_t>(st.st_size);
+#endif
+    }
+
+    MappedFile::~MappedFile() {
+        release();
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            release();
+            data_ = other.data_;
+            size_ = other.size_;
+            other.data_ = nullptr;
+            other.size_ = 0;
+#ifdef _WIN32
+            fileHandle_ = other.fileHandle_;
+            mappingHandle_ = other.mappingHandle_;
+            other.fileHandle_ = nullptr;
+            other.mappingHandle_ = nullptr;
+#endif
+        }
+        return *this;
+    }
+
+    void MappedFile::release() {
+        if (data_ == nullptr) return;
+#ifdef _WIN32
+        UnmapViewOfFile(data_);
+        CloseHandle(static_cast<HANDLE>(mappingHandle_));
+        CloseHandle(static_cast<HANDLE>(fileHandle_));
+        fileHandle_ = nullptr;
+        mappingHandle_ = nullptr;
+#else
+        munmap(const_cast<unsigned char*>(data_), size_);
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    Database::Database(const std::string& filePath) : file_(filePath) {
+        if (file_.size() < sizeof(Header)) {
+            throw std::runtime_error("Invalid snapshot file " + filePath + ": file is too small.");
+        }
+
+        const Header& h = header();
+
+        if (std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0) {
+            throw std::runtime_error("Invalid snapshot file " + filePath + ": bad magic number.");
+        }
+
+        if (h.version != VERSION
+            || h.gasRecordSize != sizeof(GasRecord)
+            || h.interactionParameterRecordSize != sizeof(InteractionParameterRecord)) {
+            throw std::runtime_error("Invalid snapshot file " + filePath + ": unsupported version or layout.");
+        }
+
+        const std::uint64_t size = file_.size();
+        if (h.gasesOffset + std::uint64_t(h.nGases) * sizeof(GasRecord) > size
+            || h.interactionParametersOffset + std::uint64_t(h.nInteractionParameters) * sizeof(InteractionParameterRecord) > size
+            || h.stringsOffset + h.stringsSize > size
+            || h.gasesOffset % alignof(GasRecord) != 0
+            || h.interactionParametersOffset % alignof(InteractionParameterRecord) != 0) {
+            throw std::runtime_error("Invalid snapshot file " + filePath + ": truncated or misaligned sections.");
+        }
+    }
+
+    const GasRecord& Database::gas(std::size_t i) const {
+        const unsigned char* base = file_.data() + header().gasesOffset;
+        return reinterpret_cast<const GasRecord*>(base)[i];
+    }
+
+    const InteractionParameterRecord& Database::interactionParameter(std::size_t i) const {
+        const unsigned char* base = file_.data() + header().interactionParametersOffset;
+        return reinterpret_cast<const InteractionParameterRecord*>(base)[i];
+    }
+
+    std::string_view Database::string(const StringRef& ref) const {
+        if (std::uint64_t(ref.offset) + ref.length > header().stringsSize) {
+            throw std::runtime_error("Invalid snapshot file: string reference out of bounds.");
+        }
+        const char* base = reinterpret_cast<const char*>(file_.data() + header().stringsOffset);
+        return std::string_view(base + ref.offset, ref.length);
+    }
+
+    std::vector<GasConstants::GasProperties> Database::gasProperties() const {
+        std::vector<GasConstants::GasProperties> gases;
+        gases.reserve(gasCount());
+
+        for (std::size_t i = 0; i < gasCount(); i++) {
+            const GasRecord& record = gas(i);
+            GasConstants::GasProperties gas;
+
+            gas.name = std::string(string(record.name));
+            gas.CASN = std::string(string(record.CASN));
+            gas.criticalTemperature = record.criticalTemperature;
+            gas.criticalPressure = record.criticalPressure;
+            gas.criticalVolume = record.criticalVolume;
+            gas.molecularWeight = record.molecularWeight;
+            gas.acentricFactor = record.acentricFactor;
+            for (int k = 0; k < 4; k++) {
+                gas.idealGasHeatCapacityPolyCoeffs[k] = record.idealGasHeatCapacityPolyCoeffs[k];
+            }
+
+            gases.push_back(gas);
+        }
+
+        return gases;
+    }
+
+    std::vector<BinaryIPs::InteractionParameter> Database::interactionParameters() const {
+        std::vector<BinaryIPs::InteractionParameter> gasesIPs;
+        gasesIPs.reserve(interactionParameterCount());
+
+        for (std::size_t i = 0; i < interactionParameterCount(); i++) {
+            const InteractionParameterRecord& record = interactionParameter(i);
+            BinaryIPs::InteractionParameter auxIP;
+
+            auxIP.CASN_1 = std::string(string(record.CASN_1));
+            auxIP.CASN_2 = std::string(string(record.CASN_2));
+            auxIP.Name_1 = std::string(string(record.Name_1));
+            auxIP.Name_2 = std::string(string(record.Name_2));
+            auxIP.Comments = std::string(string(record.Comments));
+            auxIP.k12 = record.k12;
+            auxIP.minTemperature = record.minTemperature;
+            auxIP.maxTemperature = record.maxTemperature;
+
+            gasesIPs.push_back(auxIP);
+        }
+
+        return gasesIPs;
+    }
+
+    namespace {
+
+        StringRef addString(std::string& table, const std::string& value) {
+            StringRef ref;
+            ref.offset = static_cast<std::uint32_t>(table.size());
+            ref.length = static_cast<std::uint32_t>(value.size());
+            table += value;
+            return ref;
+        }
+
+        std::uint64_t alignTo(std::uint64_t offset, std::uint64_t alignment) {
+            return (offset + alignment - 1) / alignment * alignment;
+        }
+
+    }
+
+    void writeSnapshot(
+        const std::string& filePath,
+        const std::vector<GasConstants::GasProperties>& gases,
+        const std::vector<BinaryIPs::InteractionParameter>& gasesIPs) {
+        std::string strings;
+        std::vector<GasRecord> gasRecords(gases.size());
+        std::vector<InteractionParameterRecord> ipRecords(gasesIPs.size());
+
+        for (std::size_t i = 0; i < gases.size(); i++) {
+            const auto& gas = gases[i];
+            GasRecord& record = gasRecords[i];
+
+            record.name = addString(strings, gas.name);
+            record.CASN = addString(strings, gas.CASN);
+            record.criticalTemperature = gas.criticalTemperature;
+            record.criticalPressure = gas.criticalPressure;
+            record.criticalVolume = gas.criticalVolume;
+            record.molecularWeight = gas.molecularWeight;
+            record.acentricFactor = gas.acentricFactor;
+            for (int k = 0; k < 4; k++) {
+                record.idealGasHeatCapacityPolyCoeffs[k] = gas.idealGasHeatCapacityPolyCoeffs[k];
+            }
+        }
+
+        for (std::size_t i = 0; i < gasesIPs.size(); i++) {
+            const auto& ip = gasesIPs[i];
+            InteractionParameterRecord& record = ipRecords[i];
+
+            record.CASN_1 = addString(strings, ip.CASN_1);
+            record.CASN_2 = addString(strings, ip.CASN_2);
+            record.Name_1 = addString(strings, ip.Name_1);
+            record.Name_2 = addString(strings, ip.Name_2);
+            record.Comments = addString(strings, ip.Comments);
+            record.k12 = ip.k12;
+            record.minTemperature = ip.minTemperature;
+            record.maxTemperature = ip.maxTemperature;
+        }
+
+        Header header;
+        std::memset(&header, 0, sizeof(Header));
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.gasRecordSize = sizeof(GasRecord);
+        header.interactionParameterRecordSize = sizeof(InteractionParameterRecord);
+        header.nGases = static_cast<std::uint32_t>(gasRecords.size());
+        header.nInteractionParameters = static_cast<std::uint32_t>(ipRecords.size());
+        header.gasesOffset = alignTo(sizeof(Header), alignof(GasRecord));
+        header.interactionParametersOffset = alignTo(header.gasesOffset + gasRecords.size() * sizeof(GasRecord), alignof(InteractionParameterRecord));
+        header.stringsOffset = header.interactionParametersOffset + ipRecords.size() * sizeof(InteractionParameterRecord);
+        header.stringsSize = strings.size();
+
+        std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to create the snapshot file " + filePath + ".");
+        }
+
+        std::vector<char> padding(8, 0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        file.write(padding.data(), header.gasesOffset - sizeof(Header));
+        file.write(reinterpret_cast<const char*>(gasRecords.data()), gasRecords.size() * sizeof(GasRecord));
+        file.write(padding.data(), header.interactionParametersOffset - (header.gasesOffset + gasRecords.size() * sizeof(GasRecord)));
+        file.write(reinterpret_cast<const char*>(ipRecords.data()), ipRecords.size() * sizeof(InteractionParameterRecord));
+        file.write(strings.data(), strings.size());
+
+        if (!file) {
+            throw std::runtime_error("Failed to write the snapshot file " + filePath + ".");
+        }
+
+        file.close();
+    }
+
+    std::vector<GasConstants::GasProperties> loadGasProperties(const std::string& snapshotPath, const std::string& jsonPath) {
+        try {
+            return Database(snapshotPath).gasProperties();
+        } catch (const std::runtime_error& e) {
+            return GasConstants::parseGasProperties(jsonPath);
+        }
+    }
+
+    std::vector<BinaryIPs::InteractionParameter> loadInteractionParameters(const std::string& snapshotPath, const std::string& jsonPath) {
+        try {
+            return Database(snapshotPath).interactionParameters();
+        } catch (const std::runtime_error& e) {
+            return BinaryIPs::parseInteractionParameters(jsonPath);
+        }
+    }
+
+}
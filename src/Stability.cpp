@@ -0,0 +1,308 @@
+#ifndef STABILITY
+#define STABILITY
+
+#include "PengRobinson.cpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+/*
+Struct to store the result of a stability analysis.
+
+Fields:
+- `stable`: Whether no trial phase lowers the Gibbs energy of the feed;
+- `tpd`: Lowest modified tangent plane distance tm found, negative if unstable;
+- `K`: K-values estimated from the trial phase with the lowest tm;
+- `stationary`: Whether that trial phase reached its stationary point, its
+    K-values are only a good flash estimate then;
+- `w`: Mole fractions of that trial phase;
+- `iterations`: Successive substitution iterations over all trial phases;
+- `trials`: Number of trial phases evaluated;
+- `warmStarted`: Whether the cached stationary point was tried first.
+*/
+struct StabilityResult {
+    bool stable = true;
+    double tpd = 0.0;
+    std::vector<double> K;
+    bool stationary = false;
+    std::vector<double> w;
+    int iterations = 0;
+    int trials = 0;
+    bool warmStarted = false;
+};
+
+/*
+Tangent plane stability analysis of Michelsen with the Peng-Robinson EoS.
+
+For a feed z with d_i = ln z_i + ln(phi_i(z)), each trial phase is iterated
+by successive substitution on ln W_i = d_i - ln(phi_i(w)), w = W / sum(W),
+while tracking the modified tangent plane distance
+    tm = 1 + sum_i W_i (ln W_i + ln(phi_i(w)) - d_i - 1).
+The analysis stops at the first trial with tm < `tpdTolerance`, short of
+its stationary point; `converge` then iterates that trial phase on to it,
+for the K-values of a flash.
+
+Trials are, in order: the trial phase that proved the previous feed
+unstable, stored in the workspace and given `warmStartIterations`, then a
+vapor-like phase W_i = K_i z_i and a liquid-like phase W_i = z_i / K_i with
+Wilson K-values, and with `waterIndex` set a nearly pure water phase. The
+cache is dropped when a feed is found stable. A workspace therefore follows
+one stream, so give each stream its own.
+
+With `reuseTrialPhases`, the vapor-like and liquid-like trials start from
+their previous non-trivial stationary points instead of the Wilson
+estimates. Meant for marching through close states, where a stable feed is
+then confirmed in a few iterations.
+*/
+class StabilityAnalysis {
+public:
+    // Scratch buffers and the cached stationary point, must not be shared between threads
+    struct Workspace {
+        PengRobinsonEOS::Workspace eos;
+        std::vector<double> d;
+        std::vector<double> lnW;
+        std::vector<double> w;
+        std::vector<double> lnPhi;
+        std::vector<double> cachedLnW;
+        bool hasCache = false;        // Whether `cachedLnW` holds a trial phase
+        std::vector<double> vaporLnW;
+        std::vector<double> liquidLnW;
+        bool hasVaporLnW = false;     // Whether `vaporLnW` holds a stationary point
+        bool hasLiquidLnW = false;
+        double Zfeed = 0.0;           // Of the feed last analyzed
+    };
+
+    double tolerance = 1e-8;      // On max |ln W_i| change between iterations
+    double tpdTolerance = -1e-8;  // tm below which the feed is unstable
+    int maxIterations = 100;      // Per trial phase
+    int warmStartIterations = 3;  // For the cached trial phase, which cannot prove stability
+    bool reuseTrialPhases = false;
+    int waterIndex = -1;          // Component of the aqueous trial phase, -1 for none
+
+    explicit StabilityAnalysis(const PengRobinsonEOS& eos) : eos(eos) {}
+
+    // Create a workspace sized for this EoS, so that no trial phase allocates later
+    Workspace createWorkspace() const {
+        int nComponents = eos.getComponentParameters().Tc.size();
+        Workspace ws;
+        ws.eos = eos.createWorkspace();
+
+        ws.d.reserve(nComponents);
+        ws.lnW.reserve(nComponents);
+        ws.w.reserve(nComponents);
+        ws.lnPhi.reserve(nComponents);
+        ws.cachedLnW.reserve(nComponents);
+        ws.vaporLnW.reserve(nComponents);
+        ws.liquidLnW.reserve(nComponents);
+
+        return ws;
+    }
+
+    StabilityResult analyze(double pressure, double temperature, const std::vector<double>& z) const {
+        Workspace ws = createWorkspace();
+        StabilityResult result;
+        analyze(pressure, temperature, z, result, ws);
+        return result;
+    }
+
+    void analyze(double pressure, double temperature, const std::vector<double>& z, StabilityResult& result, Workspace& ws) const {
+        analyze(pressure, temperature, z, result, ws, ws.eos);
+    }
+
+    // Same as above, with the PR parameters taken from `eosWs` so a caller can share its cache
+    void analyze(double pressure, double temperature, const std::vector<double>& z, StabilityResult& result, Workspace& ws, PengRobinsonEOS::Workspace& eosWs) const {
+        int n = z.size();
+
+        // Stored trial phases are only valid for the same number of components
+        if ((int)ws.vaporLnW.size() != n) ws.hasVaporLnW = false;
+        if ((int)ws.liquidLnW.size() != n) ws.hasLiquidLnW = false;
+
+        ws.d.resize(n);
+        ws.lnW.resize(n);
+        ws.w.resize(n);
+        result.K.resize(n);
+        result.w.resize(n);
+
+        result.stable = true;
+        result.tpd = std::numeric_limits<double>::infinity();
+        result.stationary = false;
+        result.iterations = 0;
+        result.trials = 0;
+        result.warmStarted = false;
+
+        double Zfeed = eos.lnPhi(pressure, temperature, z, ws.lnPhi, eosWs);
+        ws.Zfeed = Zfeed;
+        for (int i = 0; i < n; i++) {
+            ws.d[i] = z[i] > 0.0 ? log(z[i]) + ws.lnPhi[i] : 0.0;
+        }
+
+        for (int trial = 0; trial < 4; trial++) {
+            if (trial == 0) {
+                if (!ws.hasCache || (int)ws.cachedLnW.size() != n) continue;
+                std::copy(ws.cachedLnW.begin(), ws.cachedLnW.end(), ws.lnW.begin());
+                result.warmStarted = true;
+            } else if (trial == 3) {
+                if (waterIndex < 0 || waterIndex >= n || z[waterIndex] <= 0.0) continue;
+                waterTrial(z, ws);
+            } else if (reuseTrialPhases && (trial == 1 ? ws.hasVaporLnW : ws.hasLiquidLnW)) {
+                const std::vector<double>& seed = trial == 1 ? ws.vaporLnW : ws.liquidLnW;
+                std::copy(seed.begin(), seed.end(), ws.lnW.begin());
+            } else {
+                wilsonTrial(pressure, temperature, z, trial == 1, ws);
+            }
+
+            bool trivial = false, stationary = false;
+            double Ztrial = Zfeed;
+            int iterations = trial == 0 ? warmStartIterations : maxIterations;
+            double tm = iterate(pressure, temperature, z, iterations, false, ws, eosWs, result, trivial, stationary, Ztrial);
+            result.trials++;
+
+            // Keep the stationary point for the next call, forget a trial that went trivial
+            if (reuseTrialPhases && trial > 0 && trial < 3 && (trivial || stationary)) {
+                bool& hasSeed = trial == 1 ? ws.hasVaporLnW : ws.hasLiquidLnW;
+                std::vector<double>& seed = trial == 1 ? ws.vaporLnW : ws.liquidLnW;
+                hasSeed = !trivial;
+                if (hasSeed) seed.assign(ws.lnW.begin(), ws.lnW.end());
+            }
+
+            if (trivial) continue;
+
+            if (tm < result.tpd) record(z, tm, stationary, Ztrial, result, ws);
+
+            if (tm < tpdTolerance) {
+                // Start the next call from this trial phase
+                ws.cachedLnW.assign(ws.lnW.begin(), ws.lnW.end());
+                ws.hasCache = true;
+                result.stable = false;
+                return;
+            }
+        }
+
+        ws.hasCache = false;
+        if (!std::isfinite(result.tpd)) result.tpd = 0.0;
+    }
+
+    // Iterate the trial phase that proved the feed of the last `analyze` unstable on to its stationary
+    // point, and take tm and the K-values of `result` from there. Returns whether it was reached
+    bool converge(double pressure, double temperature, const std::vector<double>& z, StabilityResult& result, Workspace& ws, PengRobinsonEOS::Workspace& eosWs) const {
+        if (result.stable || !ws.hasCache) return false;
+        if (result.stationary) return true;
+
+        std::copy(ws.cachedLnW.begin(), ws.cachedLnW.end(), ws.lnW.begin());
+        bool trivial = false, stationary = false;
+        double Ztrial = ws.Zfeed;
+        double tm = iterate(pressure, temperature, z, maxIterations, true, ws, eosWs, result, trivial, stationary, Ztrial);
+        if (!stationary) return false;
+
+        record(z, tm, stationary, Ztrial, result, ws);
+        ws.cachedLnW.assign(ws.lnW.begin(), ws.lnW.end());
+        return true;
+    }
+
+private:
+    const PengRobinsonEOS& eos;
+
+    // Keep the trial phase in ws.w as the one with the lowest tm
+    void record(const std::vector<double>& z, double tm, bool stationary, double Ztrial, StabilityResult& result, const Workspace& ws) const {
+        int n = z.size();
+        result.tpd = tm;
+        result.stationary = stationary;
+
+        // A trial phase lighter than the feed plays the vapor
+        bool vaporLike = Ztrial > ws.Zfeed;
+        std::copy(ws.w.begin(), ws.w.end(), result.w.begin());
+        for (int i = 0; i < n; i++) {
+            if (z[i] > 0.0) {
+                result.K[i] = vaporLike ? ws.w[i] / z[i] : z[i] / ws.w[i];
+            } else {
+                result.K[i] = 1.0;
+            }
+        }
+    }
+
+    // ln W_i = ln z_i +/- ln K_i with Wilson K-values, + for the vapor-like trial phase
+    void wilsonTrial(double pressure, double temperature, const std::vector<double>& z, bool vaporLike, Workspace& ws) const {
+        int n = z.size();
+        const PengRobinsonEOS::ComponentParameters& parameters = eos.getComponentParameters();
+        double sign = vaporLike ? 1.0 : -1.0;
+
+        for (int i = 0; i < n; i++) {
+            double lnK = log(parameters.Pc[i] / pressure) + 5.373 * (1.0 + parameters.omega[i]) * (1.0 - parameters.Tc[i] / temperature);
+            ws.lnW[i] = z[i] > 0.0 ? log(z[i]) + sign * lnK : 0.0;
+        }
+    }
+
+    // Water with 1e-6 of every other component of the feed
+    void waterTrial(const std::vector<double>& z, Workspace& ws) const {
+        int n = z.size();
+
+        for (int i = 0; i < n; i++) {
+            ws.lnW[i] = i == waterIndex ? 0.0 : log(1e-6);
+        }
+    }
+
+    // Successive substitution on one trial phase, returns tm and leaves the trial in ws.lnW and ws.w.
+    // Unless `toStationary`, stops as soon as tm proves the feed unstable
+    double iterate(
+        double pressure,
+        double temperature,
+        const std::vector<double>& z,
+        int iterations,
+        bool toStationary,
+        Workspace& ws,
+        PengRobinsonEOS::Workspace& eosWs,
+        StabilityResult& result,
+        bool& trivial,
+        bool& stationary,
+        double& Ztrial) const {
+        int n = z.size();
+        double tm = 0.0;
+
+        for (int k = 0; k < iterations; k++) {
+            double sumW = 0.0;
+            for (int i = 0; i < n; i++) {
+                sumW += z[i] > 0.0 ? exp(ws.lnW[i]) : 0.0;
+            }
+            for (int i = 0; i < n; i++) {
+                ws.w[i] = z[i] > 0.0 ? exp(ws.lnW[i]) / sumW : 0.0;
+            }
+
+            Ztrial = eos.lnPhi(pressure, temperature, ws.w, ws.lnPhi, eosWs);
+            result.iterations++;
+
+            tm = 1.0;
+            double change = 0.0, distance = 0.0;
+            for (int i = 0; i < n; i++) {
+                if (z[i] <= 0.0) continue;
+
+                double W = exp(ws.lnW[i]);
+                tm += W * (ws.lnW[i] + ws.lnPhi[i] - ws.d[i] - 1.0);
+
+                double lnW = ws.d[i] - ws.lnPhi[i];
+                change = std::max(change, std::abs(lnW - ws.lnW[i]));
+                ws.lnW[i] = lnW;
+
+                double lnRatio = log(ws.w[i] / z[i]);
+                distance += lnRatio * lnRatio;
+            }
+
+            // Early exit, a negative tm anywhere along the path proves instability
+            if (tm < tpdTolerance && !toStationary) return tm;
+
+            if (distance < 1e-8) {
+                trivial = true;
+                return tm;
+            }
+
+            if (change < tolerance) {
+                stationary = true;
+                return tm;
+            }
+        }
+
+        return tm;
+    }
+};
+
+#endif
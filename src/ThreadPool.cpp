@@ -0,0 +1,154 @@
+// ThreadPool.cpp
+// Implementation of the work-stealing thread pool
+#include "../include/ThreadPool.hpp"
+#include <algorithm>
+
+ThreadPool::ThreadPool(int nThreads) {
+    nThreads_ = nThreads > 0 ? nThreads : std::max(1u, std::thread::hardware_concurrency());
+    queues_.reset(new Queue[nThreads_]);
+
+    threads_.reserve(nThreads_ - 1);
+    for (int t = 1; t < nThreads_; t++) {
+        threads_.emplace_back(&ThreadPool::workerLoop, this, t);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    start_.notify_all();
+
+    for (std::thread& thread : threads_) thread.join();
+}
+
+void ThreadPool::parallelFor(std::size_t n, std::size_t grain, const Body& body) {
+    if (n == 0) return;
+
+    std::lock_guard<std::mutex> call(callMutex_);
+    grain = std::max<std::size_t>(grain, 1);
+    std::size_t nChunks = (n + grain - 1) / grain;
+    steals_ = 0;
+
+    // Nothing to share, the chunks run in order on the caller
+    if (nThreads_ == 1 || nChunks == 1) {
+        for (std::size_t begin = 0; begin < n; begin += grain) {
+            body(begin, std::min(n, begin + grain), 0);
+        }
+        return;
+    }
+
+    for (int t = 0; t < nThreads_; t++) {
+        std::lock_guard<std::mutex> lock(queues_[t].mutex);
+        queues_[t].begin = nChunks * t / nThreads_;
+        queues_[t].end = nChunks * (t + 1) / nThreads_;
+    }
+
+    body_ = &body;
+    n_ = n;
+    grain_ = grain;
+    failed_ = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        error_ = nullptr;
+        active_ = nThreads_ - 1;
+        generation_++;
+    }
+    start_.notify_all();
+
+    runChunks(0);
+
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] { return active_ == 0; });
+        error = error_;
+        error_ = nullptr;
+    }
+    body_ = nullptr;
+
+    if (error) std::rethrow_exception(error);
+}
+
+void ThreadPool::workerLoop(int thread) {
+    std::uint64_t seen = 0;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+            if (stopping_) return;
+            seen = generation_;
+        }
+
+        runChunks(thread);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--active_ == 0) done_.notify_one();
+        }
+    }
+}
+
+void ThreadPool::runChunks(int thread) {
+    std::size_t chunk;
+
+    while (!failed_.load(std::memory_order_relaxed) && take(thread, chunk)) {
+        std::size_t begin = chunk * grain_;
+        try {
+            (*body_)(begin, std::min(n_, begin + grain_), thread);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!error_) error_ = std::current_exception();
+            failed_ = true;
+        }
+    }
+}
+
+bool ThreadPool::take(int thread, std::size_t& chunk) {
+    Queue& own = queues_[thread];
+    {
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.begin < own.end) {
+            chunk = own.begin++;
+            return true;
+        }
+    }
+
+    // Runs only shrink during a job, so once every one is empty the job is done
+    for (;;) {
+        int victim = -1;
+        std::size_t longest = 0;
+        for (int t = 0; t < nThreads_; t++) {
+            if (t == thread) continue;
+            std::lock_guard<std::mutex> lock(queues_[t].mutex);
+            if (queues_[t].end - queues_[t].begin > longest) {
+                longest = queues_[t].end - queues_[t].begin;
+                victim = t;
+            }
+        }
+        if (victim < 0) return false;
+
+        std::size_t begin, end;
+        {
+            Queue& queue = queues_[victim];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            std::size_t remaining = queue.end - queue.begin;
+            if (remaining == 0) continue;
+
+            end = queue.end;
+            begin = end - (remaining + 1) / 2;
+            queue.end = begin;
+        }
+        steals_++;
+
+        {
+            std::lock_guard<std::mutex> lock(own.mutex);
+            own.begin = begin + 1;
+            own.end = end;
+        }
+        chunk = begin;
+        return true;
+    }
+}
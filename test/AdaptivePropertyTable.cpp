@@ -0,0 +1,177 @@
+#include "../src/AdaptivePropertyTable.cpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> gasNames = {
+        "Carbon dioxide",
+        "Nitrogen",
+        "Methane",
+        "Ethane",
+        "Propane",
+        "N-butane",
+        "Isobutane",
+        "Isopentane",
+        "N-pentane",
+        "N-hexane",
+        "N-heptane"
+    };
+    std::vector<double> zs = {
+        0.39903778076171875,
+        0.004628387093544006,
+        0.4591173553466797,
+        0.05989595890045166,
+        0.044221301078796384,
+        0.015023279190063476,
+        0.007778112888336182,
+        0.004155109822750092,
+        0.0050702130794525145,
+        0.001051282286643982,
+        2.121955156326294e-05
+    };
+
+    PengRobinsonEOS eos = PengRobinsonEOS(gasNames);
+
+    // Range around the phase envelope and its critical region
+    AdaptivePropertyTableOptions options;
+    options.minPressure = 5e5;
+    options.maxPressure = 150e5;
+    options.minTemperature = 180.0;
+    options.maxTemperature = 320.0;
+    options.tolerance = 1e-5;
+    options.minDepth = 3;
+    options.maxDepth = 8;
+
+    auto build = [&](int nThreads, double& seconds) {
+        options.nThreads = nThreads;
+        auto t0 = std::chrono::steady_clock::now();
+        AdaptivePropertyTable table = AdaptivePropertyTable::generate(eos, zs, options);
+        auto t1 = std::chrono::steady_clock::now();
+        seconds = std::chrono::duration<double>(t1 - t0).count();
+        return table;
+    };
+
+    double serialTime, parallelTime;
+    AdaptivePropertyTable table = build(1, serialTime);
+    AdaptivePropertyTable parallel = build(4, parallelTime);
+
+    int counts[3] = {0, 0, 0};
+    for (const AdaptivePropertyTable::Leaf& leaf : table.getLeaves()) counts[int(leaf.state)]++;
+
+    std::cout << table.nodeCount() << " nodes, " << table.leafCount() << " leaves (" << counts[0] << " single-phase, " << counts[1] << " two-phase, "
+              << counts[2] << " boundary), depth " << table.maxDepth() << ", " << table.memoryUsage() / 1024 << " kB\n";
+    std::cout << "Build: " << serialTime << " s on 1 thread, " << parallelTime << " s on 4 threads (" << std::thread::hardware_concurrency()
+              << " hardware threads)\n";
+
+    // The table must not depend on the number of threads
+    bool identical = table.nodeCount() == parallel.nodeCount() && table.leafCount() == parallel.leafCount()
+        && table.getTree().size() == parallel.getTree().size();
+    for (std::size_t k = 0; identical && k < table.leafCount(); k++) {
+        const AdaptivePropertyTable::Leaf& a = table.getLeaves()[k];
+        const AdaptivePropertyTable::Leaf& b = parallel.getLeaves()[k];
+        identical = std::memcmp(a.corners, b.corners, sizeof(a.corners)) == 0 && a.state == b.state && a.error == b.error;
+    }
+
+    bool passed = identical;
+    std::cout << "Same table on 1 and 4 threads: " << (identical ? "yes" : "no") << "\n";
+
+    // Random states against the flash and the EoS
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<double> lnP(log(options.minPressure), log(options.maxPressure));
+    std::uniform_real_distribution<double> T(options.minTemperature, options.maxTemperature);
+
+    const int nStates = 5000;
+    std::vector<double> pressures(nStates), temperatures(nStates);
+    for (int k = 0; k < nStates; k++) {
+        pressures[k] = exp(lnP(generator));
+        temperatures[k] = T(generator);
+    }
+
+    // A uniform table with as many nodes, for comparison
+    PropertyTableGrid grid;
+    grid.minPressure = options.minPressure;
+    grid.maxPressure = options.maxPressure;
+    grid.minTemperature = options.minTemperature;
+    grid.maxTemperature = options.maxTemperature;
+    grid.nPressures = grid.nTemperatures = std::lround(std::sqrt(double(table.nodeCount())));
+    PropertyTable uniform = PropertyTable::generate(eos, zs, grid);
+
+    PTFlash flash(eos);
+    PTFlash::Workspace flashWs = flash.createWorkspace();
+    FlashResult result;
+
+    int nProperties = table.propertyCount(), misclassified = 0, singlePhase = 0, unrefined = 0;
+    std::vector<double> values(nProperties), uniformValues(nProperties);
+    double maxError = 0.0, maxUniformError = 0.0, maxRefinedError = 0.0, maxRatio = 0.0;
+
+    for (int k = 0; k < nStates; k++) {
+        double P = pressures[k], temperature = temperatures[k];
+        CellState state = table.evaluate(P, temperature, values.data());
+        flash.flash(P, temperature, zs, result, flashWs);
+
+        if (state == CellState::BOUNDARY) continue;
+        if ((state == CellState::SINGLE_PHASE) != (result.nPhases == 1)) {
+            misclassified++;
+            continue;
+        }
+        if (state != CellState::SINGLE_PHASE) continue;
+
+        singlePhase++;
+        double Z = eos.compressibilityFactor(P, temperature, zs);
+        uniform.evaluate(P, temperature, uniformValues.data());
+        double error = std::abs(values[PropertyTable::Z] - Z);
+        maxError = std::max(maxError, error);
+        maxUniformError = std::max(maxUniformError, std::abs(uniformValues[PropertyTable::Z] - Z));
+
+        // Leaves refined to the tolerance, and those stopped at the deepest level by a step of the EoS
+        double estimate = table.errorEstimate(P, temperature);
+        if (estimate <= options.tolerance) {
+            maxRefinedError = std::max(maxRefinedError, error);
+        } else {
+            unrefined++;
+        }
+        maxRatio = std::max(maxRatio, error / std::max(estimate, 1e-15));
+    }
+
+    std::cout << nStates << " random states: " << misclassified << " in a leaf of the wrong phase state, " << singlePhase << " single-phase\n";
+    std::cout << "Single-phase Z, max error: " << maxError << " adaptive, " << maxUniformError << " uniform " << grid.nPressures << " x "
+              << grid.nTemperatures << " (" << uniform.header().size / 1024 << " kB)\n";
+    std::cout << "Leaves within the tolerance, max error: " << maxRefinedError << "; " << unrefined
+              << " states in leaves above it; error / leaf estimate " << maxRatio << "\n";
+    passed = passed && misclassified <= nStates / 1000 && maxRefinedError <= options.tolerance && maxRatio <= 1.0 && maxError < maxUniformError;
+
+    // Lookup time, against the uniform table
+    double sum = 0.0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < 20; r++) {
+        for (int k = 0; k < nStates; k++) {
+            table.evaluate(pressures[k], temperatures[k], values.data());
+            sum += values[PropertyTable::DENSITY];
+        }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (int r = 0; r < 20; r++) {
+        for (int k = 0; k < nStates; k++) {
+            uniform.evaluate(pressures[k], temperatures[k], values.data());
+            sum += values[PropertyTable::DENSITY];
+        }
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    std::cout << "Lookup: " << std::chrono::duration<double, std::nano>(t1 - t0).count() / (20 * nStates) << " ns adaptive, "
+              << std::chrono::duration<double, std::nano>(t2 - t1).count() / (20 * nStates) << " ns uniform (checksum " << sum << ")\n";
+
+    if (!passed) {
+        std::cout << "FAILED\n";
+        return 1;
+    }
+
+    std::cout << "PASSED\n";
+    return 0;
+}
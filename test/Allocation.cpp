@@ -0,0 +1,189 @@
+#include "../src/CriticalPoint.cpp"
+#include "../src/MultiphaseFlash.cpp"
+#include "../src/PHFlash.cpp"
+#include "../src/PTFlash.cpp"
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+// Global allocation counter, only incremented while `countAllocations` is set
+static bool countAllocations = false;
+static long nAllocations = 0;
+
+void* operator new(std::size_t size) {
+    if (countAllocations) nAllocations++;
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+// Out of line, so that GCC does not see free() paired with the new expressions of the callers
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    operator delete(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    operator delete(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    operator delete(p);
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> gasNames = {
+        "Carbon dioxide",
+        "Nitrogen",
+        "Methane",
+        "Ethane",
+        "Propane",
+        "N-butane",
+        "Isobutane",
+        "Isopentane",
+        "N-pentane",
+        "N-hexane",
+        "N-heptane"
+    };
+    std::vector<double> zs = {
+        0.39903778076171875,
+        0.004628387093544006,
+        0.4591173553466797,
+        0.05989595890045166,
+        0.044221301078796384,
+        0.015023279190063476,
+        0.007778112888336182,
+        0.004155109822750092,
+        0.0050702130794525145,
+        0.001051282286643982,
+        2.121955156326294e-05
+    };
+
+    PengRobinsonEOS eos = PengRobinsonEOS(gasNames);
+    PengRobinsonEOS::Workspace ws = eos.createWorkspace();
+
+    // Warm up, so any lazily sized buffer is already allocated
+    double Z = eos.compressibilityFactor(167e5, 313.15, zs, ws);
+
+    countAllocations = true;
+    for (int k = 0; k < 1000; k++) {
+        double P = 1e5 + k * 5e4, T = 250.0 + 0.2 * k;
+        Z = eos.compressibilityFactor(P, T, zs, ws);
+    }
+    countAllocations = false;
+
+    std::cout << "Z = " << Z << "\n";
+    std::cout << "Heap allocations in 1000 compressibilityFactor calls: " << nAllocations << "\n";
+
+    if (nAllocations != 0) {
+        std::cout << "FAILED: compressibilityFactor allocated with a reused workspace\n";
+        return 1;
+    }
+
+    PTFlash flash(eos);
+    PTFlash::Workspace flashWs = flash.createWorkspace();
+    FlashResult result;
+
+    // Warm up on a two-phase state, so the Newton buffers are sized too
+    flash.flash(40e5, 230.0, zs, result, flashWs);
+
+    nAllocations = 0;
+    countAllocations = true;
+    for (int k = 0; k < 100; k++) {
+        double P = 10e5 + k * 4e5, T = 200.0 + 0.6 * k;
+        flash.flash(P, T, zs, result, flashWs);
+    }
+    countAllocations = false;
+
+    std::cout << "Heap allocations in 100 flash calls: " << nAllocations << "\n";
+
+    if (nAllocations != 0) {
+        std::cout << "FAILED: flash allocated with a reused workspace\n";
+        return 1;
+    }
+
+    CriticalPointSolver critical(eos);
+    CriticalPointSolver::Workspace criticalWs = critical.createWorkspace();
+    CriticalPoint point;
+
+    critical.solve(zs, point, criticalWs);
+
+    nAllocations = 0;
+    countAllocations = true;
+    for (int k = 0; k < 10; k++) {
+        critical.solve(zs, point, criticalWs);
+    }
+    countAllocations = false;
+
+    std::cout << "Heap allocations in 10 critical point calls: " << nAllocations << "\n";
+
+    if (nAllocations != 0) {
+        std::cout << "FAILED: the critical point solver allocated with a reused workspace\n";
+        return 1;
+    }
+
+    PHFlash phFlash(eos);
+    PHFlash::Workspace phWs = phFlash.createWorkspace();
+    PHFlashResult phResult;
+
+    // Warm up with a two-phase solution, so the Newton buffers of both methods are sized too
+    double H = phFlash.value(FlashSpecification::ENTHALPY, 40e5, 240.0, flash.flash(40e5, 240.0, zs), phWs, Z);
+    phFlash.solve(FlashSpecification::ENTHALPY, 40e5, H, zs, 260.0, phResult, phWs);
+
+    nAllocations = 0;
+    countAllocations = true;
+    for (int k = 0; k < 10; k++) {
+        phFlash.direct = k % 2 == 0;
+        phFlash.solve(FlashSpecification::ENTHALPY, 40e5, H, zs, 230.0 + 5.0 * k, phResult, phWs);
+    }
+    countAllocations = false;
+
+    std::cout << "Heap allocations in 10 PH flash calls: " << nAllocations << "\n";
+
+    if (nAllocations != 0) {
+        std::cout << "FAILED: the PH flash allocated with a reused workspace\n";
+        return 1;
+    }
+
+    // The gas with 5 % water, for a three-phase split
+    std::vector<std::string> wetNames = gasNames;
+    wetNames.push_back("Water");
+    std::vector<double> wet = zs;
+    wet.push_back(0.05);
+    PengRobinsonEOS wetEos = PengRobinsonEOS(wetNames);
+
+    MultiphaseFlash multiphase(wetEos);
+    multiphase.stability.waterIndex = 11;
+    MultiphaseFlash::Workspace multiphaseWs = multiphase.createWorkspace();
+    MultiphaseFlashResult multiphaseResult;
+
+    // Warm up with three phases, so the result holds three compositions
+    multiphase.flash(50e5, 250.0, wet, multiphaseResult, multiphaseWs);
+
+    nAllocations = 0;
+    countAllocations = true;
+    for (int k = 0; k < 10; k++) {
+        multiphase.stability.waterIndex = k % 2 == 0 ? 11 : -1;
+        multiphase.flash(10e5 + k * 8e5, 240.0 + 6.0 * k, wet, multiphaseResult, multiphaseWs);
+    }
+    countAllocations = false;
+
+    std::cout << "Heap allocations in 10 multiphase flash calls: " << nAllocations << "\n";
+
+    if (nAllocations != 0) {
+        std::cout << "FAILED: the multiphase flash allocated with a reused workspace\n";
+        return 1;
+    }
+
+    std::cout << "PASSED\n";
+    return 0;
+}
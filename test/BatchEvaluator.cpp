@@ -0,0 +1,170 @@
+#include "../src/BatchEvaluator.cpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> gasNames = {
+        "Carbon dioxide",
+        "Nitrogen",
+        "Methane",
+        "Ethane",
+        "Propane",
+        "N-butane",
+        "Isobutane",
+        "Isopentane",
+        "N-pentane",
+        "N-hexane",
+        "N-heptane"
+    };
+    std::vector<double> zs = {
+        0.39903778076171875,
+        0.004628387093544006,
+        0.4591173553466797,
+        0.05989595890045166,
+        0.044221301078796384,
+        0.015023279190063476,
+        0.007778112888336182,
+        0.004155109822750092,
+        0.0050702130794525145,
+        0.001051282286643982,
+        2.121955156326294e-05
+    };
+
+    PengRobinsonEOS eos = PengRobinsonEOS(gasNames);
+    bool passed = true;
+
+    // Every index once, with uneven chunks, and an exception from a body
+    {
+        ThreadPool pool(4);
+        const std::size_t n = 10007;
+        std::vector<int> hits(n, 0);
+        pool.parallelFor(n, 7, [&](std::size_t begin, std::size_t end, int) {
+            for (std::size_t k = begin; k < end; k++) {
+                volatile double x = 0.0;
+                for (std::size_t r = 0; r < (k % 97) * 20; r++) x = x + 1.0;
+                hits[k]++;
+            }
+        });
+        bool once = std::all_of(hits.begin(), hits.end(), [](int h) { return h == 1; });
+
+        bool rethrown = false;
+        try {
+            pool.parallelFor(n, 7, [&](std::size_t begin, std::size_t, int) {
+                if (begin == 700) throw std::runtime_error("Chunk failed.");
+            });
+        } catch (const std::runtime_error&) {
+            rethrown = true;
+        }
+
+        // The pool must stay usable after a failed job
+        std::fill(hits.begin(), hits.end(), 0);
+        pool.parallelFor(n, 100, [&](std::size_t begin, std::size_t end, int) {
+            for (std::size_t k = begin; k < end; k++) hits[k]++;
+        });
+        once = once && std::all_of(hits.begin(), hits.end(), [](int h) { return h == 1; });
+
+        std::cout << "Thread pool: every index once " << (once ? "yes" : "no") << ", exception rethrown " << (rethrown ? "yes" : "no") << "\n";
+        passed = passed && once && rethrown;
+    }
+
+    // States across the phase envelope, one to one hundred iterations each
+    std::mt19937 generator(3);
+    std::uniform_real_distribution<double> lnP(log(5e5), log(150e5));
+    std::uniform_real_distribution<double> T(180.0, 320.0);
+
+    const int nStates = 4000;
+    std::vector<double> pressures(nStates), temperatures(nStates);
+    for (int k = 0; k < nStates; k++) {
+        pressures[k] = exp(lnP(generator));
+        temperatures[k] = T(generator);
+    }
+
+    // Serial reference with a single workspace, without the trial phase cached from the state before
+    std::vector<double> Z(nStates);
+    std::vector<FlashResult> reference(nStates);
+    std::vector<PengRobinsonEOS::ResidualProperties> referenceResidual(nStates);
+    {
+        PTFlash flash(eos);
+        PTFlash::Workspace ws = flash.createWorkspace();
+        for (int k = 0; k < nStates; k++) {
+            Z[k] = eos.compressibilityFactor(pressures[k], temperatures[k], zs, ws.eos);
+            ws.stability.hasCache = false;
+            flash.flash(pressures[k], temperatures[k], zs, reference[k], ws);
+            eos.residualProperties(pressures[k], temperatures[k], zs, referenceResidual[k], ws.eos);
+        }
+    }
+
+    auto same = [](const FlashResult& a, const FlashResult& b) {
+        return a.nPhases == b.nPhases && a.vaporFraction == b.vaporFraction && a.x == b.x && a.y == b.y && a.K == b.K && a.ZL == b.ZL
+            && a.ZV == b.ZV && a.iterations == b.iterations && a.converged == b.converged;
+    };
+
+    // Scaling from one thread to every hardware thread, and at least 4 for the ordering check
+    int hardware = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<int> threadCounts;
+    for (int t = 1; t < hardware; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(hardware);
+    if (hardware < 4) threadCounts.push_back(4);
+
+    std::vector<double> batchZ;
+    std::vector<PengRobinsonEOS::ResidualProperties> residual;
+    std::vector<FlashResult> results;
+    double serialZTime = 0.0, serialFlashTime = 0.0;
+
+    std::cout << hardware << " hardware threads, " << nStates << " states\n";
+    for (int nThreads : threadCounts) {
+        BatchEvaluator evaluator(eos, nThreads);
+
+        auto t0 = std::chrono::steady_clock::now();
+        for (int r = 0; r < 10; r++) evaluator.compressibilityFactors(pressures, temperatures, zs, batchZ);
+        auto t1 = std::chrono::steady_clock::now();
+        evaluator.flashes(pressures, temperatures, zs, results);
+        auto t2 = std::chrono::steady_clock::now();
+        evaluator.residualProperties(pressures, temperatures, zs, residual);
+
+        double zTime = std::chrono::duration<double, std::nano>(t1 - t0).count() / (10 * nStates);
+        double flashTime = std::chrono::duration<double, std::micro>(t2 - t1).count() / nStates;
+        if (nThreads == 1) {
+            serialZTime = zTime;
+            serialFlashTime = flashTime;
+        }
+
+        bool identical = batchZ == Z;
+        for (int k = 0; k < nStates; k++) {
+            identical = identical && same(results[k], reference[k]) && residual[k].Z == referenceResidual[k].Z
+                && residual[k].enthalpy == referenceResidual[k].enthalpy && residual[k].entropy == referenceResidual[k].entropy;
+        }
+
+        std::cout << nThreads << " threads: Z " << zTime << " ns per state (speedup " << serialZTime / zTime << "), flash " << flashTime
+                  << " us per state (speedup " << serialFlashTime / flashTime << "), " << evaluator.getPool().steals() << " steals, "
+                  << (identical ? "same results" : "DIFFERENT results") << "\n";
+        passed = passed && identical;
+    }
+
+    // Mismatched inputs
+    {
+        BatchEvaluator evaluator(eos, 2);
+        bool thrown = false;
+        try {
+            evaluator.compressibilityFactors(pressures, std::vector<double>(3, 300.0), zs, batchZ);
+        } catch (const std::invalid_argument&) {
+            thrown = true;
+        }
+        passed = passed && thrown;
+    }
+
+    if (!passed) {
+        std::cout << "FAILED\n";
+        return 1;
+    }
+
+    std::cout << "PASSED\n";
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include "../src/CriticalPoint.cpp"
+#include "../src/PhaseEnvelope.cpp"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> gasNames = {
+        "Carbon dioxide",
+        "Nitrogen",
+        "Methane",
+        "Ethane",
+        "Propane",
+        "N-butane",
+        "Isobutane",
+        "Isopentane",
+        "N-pentane",
+        "N-hexane",
+        "N-heptane"
+    };
+    std::vector<double> zs = {
+        0.39903778076171875,
+        0.004628387093544006,
+        0.4591173553466797,
+        0.05989595890045166,
+        0.044221301078796384,
+        0.015023279190063476,
+        0.007778112888336182,
+        0.004155109822750092,
+        0.0050702130794525145,
+        0.001051282286643982,
+        2.121955156326294e-05
+    };
+
+    bool passed = true;
+
+    // A pure component must reproduce its own Tc and Pc, up to the rounding of the PR constants
+    PengRobinsonEOS methane = PengRobinsonEOS({"Methane"});
+    CriticalPointSolver pureSolver(methane);
+    CriticalPoint pure = pureSolver.solve({1.0});
+    double Tc = methane.getComponentParameters().Tc[0], Pc = methane.getComponentParameters().Pc[0];
+
+    std::cout << "Methane: T = " << pure.temperature << " K (Tc = " << Tc << "), P = " << pure.pressure / 1e5
+              << " bar (Pc = " << Pc / 1e5 << "), " << pure.iterations << " iterations\n";
+    passed = passed && pure.converged && std::abs(pure.temperature / Tc - 1.0) < 1e-4 && std::abs(pure.pressure / Pc - 1.0) < 1e-4;
+
+    // The mixture critical point must lie where the phase envelope crosses K = 1
+    PengRobinsonEOS eos = PengRobinsonEOS(gasNames);
+    CriticalPointSolver solver(eos);
+    CriticalPointSolver::Workspace ws = solver.createWorkspace();
+    CriticalPoint critical;
+    solver.solve(zs, critical, ws);
+
+    std::cout << "Mixture: T = " << critical.temperature << " K, P = " << critical.pressure / 1e5 << " bar, V = "
+              << critical.volume * 1e6 << " cm3/mol, " << critical.iterations << " iterations, "
+              << (critical.converged ? "converged" : "not converged") << "\n";
+    // All iterations count: the initial temperature search, the Newton iterations on ln T and the volume steps
+    passed = passed && critical.converged && critical.iterations <= 45;
+
+    PhaseEnvelopeTracer tracer(eos);
+    PhaseEnvelope envelope = tracer.trace(zs);
+    if (envelope.criticalTemperatures.size() == 1) {
+        double dT = critical.temperature - envelope.criticalTemperatures[0];
+        double dP = critical.pressure / envelope.criticalPressures[0] - 1.0;
+        std::cout << "Envelope: T = " << envelope.criticalTemperatures[0] << " K, P = " << envelope.criticalPressures[0] / 1e5 << " bar\n";
+        passed = passed && std::abs(dT) < 1e-3 && std::abs(dP) < 1e-4;
+    } else {
+        passed = false;
+    }
+
+    // Time per critical point
+    const int nRepeats = 1000;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < nRepeats; r++) {
+        solver.solve(zs, critical, ws);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    std::cout << "Critical point: " << std::chrono::duration<double, std::micro>(t1 - t0).count() / nRepeats << " us\n";
+
+    if (!passed) {
+        std::cout << "FAILED\n";
+        return 1;
+    }
+
+    std::cout << "PASSED\n";
+    return 0;
+}
@@ -0,0 +1,191 @@
+#include "../src/FlashSequence.cpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> gasNames = {
+        "Carbon dioxide",
+        "Nitrogen",
+        "Methane",
+        "Ethane",
+        "Propane",
+        "N-butane",
+        "Isobutane",
+        "Isopentane",
+        "N-pentane",
+        "N-hexane",
+        "N-heptane"
+    };
+    std::vector<double> zs = {
+        0.39903778076171875,
+        0.004628387093544006,
+        0.4591173553466797,
+        0.05989595890045166,
+        0.044221301078796384,
+        0.015023279190063476,
+        0.007778112888336182,
+        0.004155109822750092,
+        0.0050702130794525145,
+        0.001051282286643982,
+        2.121955156326294e-05
+    };
+
+    PengRobinsonEOS eos = PengRobinsonEOS(gasNames);
+    PTFlash flash(eos);
+    PTFlash::Workspace ws = flash.createWorkspace();
+    FlashResult result;
+
+    flash.flash(40e5, 230.0, zs, result, ws);
+    std::cout << "P = 40 bar, T = 230 K: " << result.nPhases << " phases, vapor fraction " << result.vaporFraction
+              << ", ZL = " << result.ZL << ", ZV = " << result.ZV << ", " << result.iterations << " iterations\n";
+
+    // Two-phase states of the gas
+    std::vector<std::pair<double, double>> states;
+    for (double T = 200.0; T <= 260.0; T += 5.0) {
+        for (double P = 10e5; P <= 50e5; P += 5e5) {
+            states.push_back({P, T});
+        }
+    }
+
+    // Newton and successive substitution must agree, and the phases must be in equilibrium
+    PTFlash substitution(eos);
+    substitution.newtonSwitch = 0.0;
+    substitution.maxIterations = 2000;
+    FlashResult reference;
+    PengRobinsonEOS::Workspace eosWs = eos.createWorkspace();
+    std::vector<double> lnPhiL, lnPhiV;
+
+    std::vector<std::pair<double, double>> twoPhaseStates;
+    int n = zs.size(), nTwoPhase = 0, totalIterations = 0;
+    double maxBalance = 0.0, maxFugacity = 0.0, maxDifference = 0.0;
+    bool passed = true;
+
+    for (const auto& state : states) {
+        flash.flash(state.first, state.second, zs, result, ws);
+        substitution.flash(state.first, state.second, zs, reference, ws);
+
+        passed = passed && result.converged && result.nPhases == reference.nPhases;
+        if (result.nPhases != 2) continue;
+
+        nTwoPhase++;
+        twoPhaseStates.push_back(state);
+        totalIterations += result.iterations;
+        maxDifference = std::max(maxDifference, std::abs(result.vaporFraction - reference.vaporFraction));
+
+        eos.lnPhi(state.first, state.second, result.x, lnPhiL, eosWs);
+        eos.lnPhi(state.first, state.second, result.y, lnPhiV, eosWs);
+
+        for (int i = 0; i < n; i++) {
+            double balance = (1.0 - result.vaporFraction) * result.x[i] + result.vaporFraction * result.y[i] - zs[i];
+            double fugacity = log(result.y[i]) + lnPhiV[i] - log(result.x[i]) - lnPhiL[i];
+            maxBalance = std::max(maxBalance, std::abs(balance));
+            maxFugacity = std::max(maxFugacity, std::abs(fugacity));
+        }
+    }
+
+    std::cout << nTwoPhase << " two-phase states out of " << states.size() << ", "
+              << double(totalIterations) / nTwoPhase << " iterations on average\n";
+    std::cout << "Max material balance error: " << maxBalance << "\n";
+    std::cout << "Max fugacity residual: " << maxFugacity << "\n";
+    std::cout << "Max vapor fraction difference with successive substitution: " << maxDifference << "\n";
+
+    passed = passed && nTwoPhase > 0 && maxBalance < 1e-12 && maxFugacity < 1e-9 && maxDifference < 1e-8;
+
+    // Time per converged two-phase flash, stability analysis included, the best of several batches
+    // so that other processes do not count. It must stay below 10 us
+    const int nBatches = 20, nRepeats = 5;
+    double nFlashes = double(nRepeats) * twoPhaseStates.size();
+    double flashTime = std::numeric_limits<double>::infinity(), substitutionTime = flashTime;
+
+    for (int batch = 0; batch < nBatches; batch++) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (int r = 0; r < nRepeats; r++) {
+            for (const auto& state : twoPhaseStates) {
+                flash.flash(state.first, state.second, zs, result, ws);
+            }
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        for (int r = 0; r < nRepeats; r++) {
+            for (const auto& state : twoPhaseStates) {
+                substitution.flash(state.first, state.second, zs, reference, ws);
+            }
+        }
+        auto t2 = std::chrono::steady_clock::now();
+
+        flashTime = std::min(flashTime, std::chrono::duration<double, std::micro>(t1 - t0).count() / nFlashes);
+        substitutionTime = std::min(substitutionTime, std::chrono::duration<double, std::micro>(t2 - t1).count() / nFlashes);
+    }
+
+    std::cout << "Flash with Newton: " << flashTime << " us/flash (limit 10 us)\n";
+    std::cout << "Successive substitution only: " << substitutionTime << " us/flash\n";
+
+    passed = passed && flashTime < 10.0;
+
+    // March along a pipeline profile, each state must match an independent flash
+    const int nProfile = 2000;
+    FlashSequence sequence(eos);
+    int sequenceIterations = 0, coldIterations = 0, nProfileTwoPhase = 0, profileMismatches = 0;
+    double maxProfileDifference = 0.0;
+
+    for (int k = 0; k < nProfile; k++) {
+        double s = double(k) / (nProfile - 1);
+        double P = 80e5 - 70e5 * s, T = 300.0 - 90.0 * s;
+
+        const FlashResult& marched = sequence.next(P, T, zs);
+        flash.flash(P, T, zs, result, ws);
+
+        if (marched.nPhases != result.nPhases) {
+            profileMismatches++;
+            continue;
+        }
+        maxProfileDifference = std::max(maxProfileDifference, std::abs(marched.vaporFraction - result.vaporFraction));
+
+        if (marched.nPhases == 2) {
+            nProfileTwoPhase++;
+            sequenceIterations += marched.iterations;
+            coldIterations += result.iterations;
+        }
+    }
+
+    std::cout << "Profile of " << nProfile << " states, " << sequence.coldStarts << " cold starts, "
+              << profileMismatches << " phase count mismatches\n";
+    std::cout << "Iterations per two-phase state: " << double(sequenceIterations) / nProfileTwoPhase << " marched, "
+              << double(coldIterations) / nProfileTwoPhase << " cold\n";
+    std::cout << "Max vapor fraction difference along the profile: " << maxProfileDifference << "\n";
+
+    passed = passed && profileMismatches == 0 && nProfileTwoPhase > 0 && maxProfileDifference < 1e-8;
+
+    auto t3 = std::chrono::steady_clock::now();
+    for (int r = 0; r < nRepeats; r++) {
+        sequence.reset();
+        for (int k = 0; k < nProfile; k++) {
+            double s = double(k) / (nProfile - 1);
+            sequence.next(80e5 - 70e5 * s, 300.0 - 90.0 * s, zs);
+        }
+    }
+    auto t4 = std::chrono::steady_clock::now();
+    for (int r = 0; r < nRepeats; r++) {
+        for (int k = 0; k < nProfile; k++) {
+            double s = double(k) / (nProfile - 1);
+            flash.flash(80e5 - 70e5 * s, 300.0 - 90.0 * s, zs, result, ws);
+        }
+    }
+    auto t5 = std::chrono::steady_clock::now();
+
+    double nStates = double(nRepeats) * nProfile;
+    std::cout << "Marched profile: " << std::chrono::duration<double, std::micro>(t4 - t3).count() / nStates << " us/state\n";
+    std::cout << "Independent flashes: " << std::chrono::duration<double, std::micro>(t5 - t4).count() / nStates << " us/state\n";
+
+    if (!passed) {
+        std::cout << "FAILED\n";
+        return 1;
+    }
+
+    std::cout << "PASSED\n";
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include "../src/PengRobinson.cpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Largest relative deviation between the analytic derivatives and central differences
+double checkDerivatives(const PengRobinsonEOS& eos, double P, double T, const std::vector<double>& x, PhaseRoot root) {
+    int n = x.size();
+    PengRobinsonEOS::Workspace ws = eos.createWorkspace();
+    PengRobinsonEOS::FugacityDerivatives derivatives;
+    std::vector<double> lnPhi, lnPhiPlus, lnPhiMinus;
+
+    eos.lnPhi(P, T, x, lnPhi, ws, root, &derivatives);
+
+    double maxError = 0.0;
+    auto compare = [&](double analytic, double numeric, double scale) {
+        maxError = std::max(maxError, std::abs(analytic - numeric) / std::max(scale, 1e-300));
+    };
+
+    double hT = 1e-7 * T;
+    eos.lnPhi(P, T + hT, x, lnPhiPlus, ws, root);
+    eos.lnPhi(P, T - hT, x, lnPhiMinus, ws, root);
+    double scaleT = 0.0;
+    for (int i = 0; i < n; i++) scaleT = std::max(scaleT, std::abs(derivatives.dT[i]));
+    for (int i = 0; i < n; i++) compare(derivatives.dT[i], (lnPhiPlus[i] - lnPhiMinus[i]) / (2.0 * hT), scaleT);
+
+    double hP = 1e-6 * P;
+    eos.lnPhi(P + hP, T, x, lnPhiPlus, ws, root);
+    eos.lnPhi(P - hP, T, x, lnPhiMinus, ws, root);
+    double scaleP = 0.0;
+    for (int i = 0; i < n; i++) scaleP = std::max(scaleP, std::abs(derivatives.dP[i]));
+    for (int i = 0; i < n; i++) compare(derivatives.dP[i], (lnPhiPlus[i] - lnPhiMinus[i]) / (2.0 * hP), scaleP);
+
+    // Perturb the moles of component j, for one mole in total
+    double scaleN = 0.0;
+    for (double value : derivatives.dn) scaleN = std::max(scaleN, std::abs(value));
+
+    for (int j = 0; j < n; j++) {
+        double h = 1e-7;
+        std::vector<double> xPlus = x, xMinus = x;
+        xPlus[j] += h;
+        xMinus[j] -= h;
+        for (int i = 0; i < n; i++) {
+            xPlus[i] /= 1.0 + h;
+            xMinus[i] /= 1.0 - h;
+        }
+
+        eos.lnPhi(P, T, xPlus, lnPhiPlus, ws, root);
+        eos.lnPhi(P, T, xMinus, lnPhiMinus, ws, root);
+
+        for (int i = 0; i < n; i++) {
+            compare(derivatives.dn[i * n + j], (lnPhiPlus[i] - lnPhiMinus[i]) / (2.0 * h), scaleN);
+        }
+    }
+
+    return maxError;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> gasNames = {
+        "Carbon dioxide",
+        "Nitrogen",
+        "Methane",
+        "Ethane",
+        "Propane",
+        "N-butane",
+        "Isobutane",
+        "Isopentane",
+        "N-pentane",
+        "N-hexane",
+        "N-heptane"
+    };
+    std::vector<double> zs = {
+        0.39903778076171875,
+        0.004628387093544006,
+        0.4591173553466797,
+        0.05989595890045166,
+        0.044221301078796384,
+        0.015023279190063476,
+        0.007778112888336182,
+        0.004155109822750092,
+        0.0050702130794525145,
+        0.001051282286643982,
+        2.121955156326294e-05
+    };
+
+    PengRobinsonEOS eos = PengRobinsonEOS(gasNames);
+    PengRobinsonEOS::Workspace ws = eos.createWorkspace();
+    bool passed = true;
+
+    // Fugacity coefficients of the reference gas
+    std::vector<double> lnPhi = eos.lnPhi(167e5, 313.15, zs);
+    for (std::size_t i = 0; i < lnPhi.size(); i++) {
+        std::cout << gasNames[i] << ": ln(phi) = " << lnPhi[i] << "\n";
+    }
+
+    struct State {
+        double P;
+        double T;
+        PhaseRoot root;
+    };
+    std::vector<State> states = {
+        {167e5, 313.15, PhaseRoot::STABLE},
+        {50e5, 250.0, PhaseRoot::VAPOR},
+        {50e5, 250.0, PhaseRoot::LIQUID},
+        {1e5, 400.0, PhaseRoot::STABLE}
+    };
+
+    for (const auto& state : states) {
+        double error = checkDerivatives(eos, state.P, state.T, zs, state.root);
+        std::cout << "P = " << state.P << " Pa, T = " << state.T << " K, max derivative error vs central differences: " << error << "\n";
+        passed = passed && error < 1e-5;
+    }
+
+    // Gibbs-Duhem: sum_i x_i d ln(phi_i) / d n_j = 0
+    PengRobinsonEOS::FugacityDerivatives derivatives;
+    eos.lnPhi(167e5, 313.15, zs, lnPhi, ws, PhaseRoot::STABLE, &derivatives);
+
+    int n = zs.size();
+    double gibbsDuhem = 0.0;
+    for (int j = 0; j < n; j++) {
+        double sum = 0.0;
+        for (int i = 0; i < n; i++) sum += zs[i] * derivatives.dn[i * n + j];
+        gibbsDuhem = std::max(gibbsDuhem, std::abs(sum));
+    }
+    std::cout << "Gibbs-Duhem residual: " << gibbsDuhem << "\n";
+    passed = passed && gibbsDuhem < 1e-10;
+
+    // Cost of a full gradient compared to a single Z evaluation
+    const int nCalls = 20000;
+    double sink = 0.0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int k = 0; k < nCalls; k++) {
+        sink += eos.compressibilityFactor(167e5, 250.0 + 0.01 * k, zs, ws);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (int k = 0; k < nCalls; k++) {
+        sink += eos.lnPhi(167e5, 250.0 + 0.01 * k, zs, lnPhi, ws, PhaseRoot::STABLE, &derivatives);
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    std::cout << "compressibilityFactor: " << std::chrono::duration<double, std::nano>(t1 - t0).count() / nCalls << " ns/call\n";
+    std::cout << "lnPhi with derivatives: " << std::chrono::duration<double, std::nano>(t2 - t1).count() / nCalls << " ns/call\n";
+    std::cout << "(checksum " << sink << ")\n";
+
+    if (!passed) {
+        std::cout << "FAILED\n";
+        return 1;
+    }
+
+    std::cout << "PASSED\n";
+    return 0;
+}
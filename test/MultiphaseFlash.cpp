@@ -0,0 +1,180 @@
+#include "../src/MultiphaseFlash.cpp"
+#include "../src/PTFlash.cpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> gasNames = {
+        "Carbon dioxide",
+        "Nitrogen",
+        "Methane",
+        "Ethane",
+        "Propane",
+        "N-butane",
+        "Isobutane",
+        "Isopentane",
+        "N-pentane",
+        "N-hexane",
+        "N-heptane",
+        "Water"
+    };
+    std::vector<double> gas = {
+        0.39903778076171875,
+        0.004628387093544006,
+        0.4591173553466797,
+        0.05989595890045166,
+        0.044221301078796384,
+        0.015023279190063476,
+        0.007778112888336182,
+        0.004155109822750092,
+        0.0050702130794525145,
+        0.001051282286643982,
+        2.121955156326294e-05
+    };
+    const int water = 11;
+
+    // The gas with a water mole fraction of `fraction`
+    auto wetGas = [&](double fraction) {
+        double sum = 0.0;
+        for (double z : gas) sum += z;
+
+        std::vector<double> z;
+        for (double zi : gas) z.push_back(zi * (1.0 - fraction) / sum);
+        z.push_back(fraction);
+        return z;
+    };
+
+    PengRobinsonEOS eos = PengRobinsonEOS(gasNames);
+    MultiphaseFlash solver(eos);
+    solver.stability.waterIndex = water;
+    MultiphaseFlash::Workspace ws = solver.createWorkspace();
+    MultiphaseFlashResult result;
+    PengRobinsonEOS::Workspace eosWs = eos.createWorkspace();
+
+    bool passed = true;
+
+    struct Case {
+        double pressure;
+        double temperature;
+        double waterFraction;
+        int nPhases;
+    };
+    std::vector<Case> cases = {
+        {50e5, 250.0, 0.05, 3},  // Vapor, hydrocarbon liquid and free water
+        {10e5, 260.0, 0.1, 3},   // Little hydrocarbon liquid
+        {50e5, 300.0, 0.05, 2},  // Vapor and free water
+        {80e5, 240.0, 0.5, 2},   // Dense gas and free water
+        {5e5, 350.0, 0.05, 1},   // Superheated, the water stays in the vapor
+        {50e5, 250.0, 0.0, 2},   // Dry gas
+    };
+
+    // Largest fugacity difference and relative material balance error
+    auto maxResidual = [&](const Case& c, const std::vector<double>& z) {
+        int n = z.size();
+        std::vector<std::vector<double>> lnPhi(result.nPhases, std::vector<double>(n));
+        for (int k = 0; k < result.nPhases; k++) {
+            eos.lnPhi(c.pressure, c.temperature, result.compositions[k], lnPhi[k], eosWs);
+        }
+
+        double error = 0.0;
+        for (int i = 0; i < n; i++) {
+            if (z[i] <= 0.0) continue;
+
+            double sum = 0.0;
+            for (int k = 0; k < result.nPhases; k++) {
+                sum += result.phaseFractions[k] * result.compositions[k][i];
+                double lnf0 = log(result.compositions[0][i]) + lnPhi[0][i];
+                double lnf = log(result.compositions[k][i]) + lnPhi[k][i];
+                error = std::max(error, std::abs(lnf - lnf0));
+            }
+            error = std::max(error, std::abs(sum / z[i] - 1.0));
+        }
+        return error;
+    };
+
+    for (const Case& c : cases) {
+        std::vector<double> z = wetGas(c.waterFraction);
+        solver.flash(c.pressure, c.temperature, z, result, ws);
+
+        double error = maxResidual(c, z);
+        std::cout << c.pressure / 1e5 << " bar, " << c.temperature << " K, water " << c.waterFraction << ": " << result.nPhases
+                  << " phases, " << result.iterations << " iterations, " << result.stabilityTests << " stability tests, residual " << error << "\n";
+        for (int k = 0; k < result.nPhases; k++) {
+            std::cout << "  beta " << result.phaseFractions[k] << ", Z " << result.Z[k] << ", x_water " << result.compositions[k][water] << "\n";
+        }
+
+        passed = passed && result.converged && result.nPhases == c.nPhases && error < 1e-8;
+    }
+
+    // Capped at two phases, the three-phase feed keeps an unstable split, which must not count as converged
+    {
+        const Case& c = cases.front();
+        MultiphaseFlash capped(eos);
+        capped.maxPhases = 2;
+        capped.stability.waterIndex = water;
+        MultiphaseFlash::Workspace cappedWs = capped.createWorkspace();
+        capped.flash(c.pressure, c.temperature, wetGas(c.waterFraction), result, cappedWs);
+
+        std::cout << "At most 2 phases: " << result.nPhases << " phases, " << (result.converged ? "converged" : "not converged") << "\n";
+        passed = passed && result.nPhases == 2 && !result.converged;
+    }
+
+    // Without water, the split must match the two-phase flash
+    {
+        const Case& c = cases.back();
+        std::vector<double> z = wetGas(0.0);
+        solver.flash(c.pressure, c.temperature, z, result, ws);
+        FlashResult twoPhase = PTFlash(eos).flash(c.pressure, c.temperature, z);
+
+        double error = std::abs(result.phaseFractions[0] - twoPhase.vaporFraction);
+        for (int i = 0; i < water; i++) {
+            error = std::max(error, std::abs(result.compositions[0][i] - twoPhase.y[i]));
+            error = std::max(error, std::abs(result.compositions[1][i] - twoPhase.x[i]));
+        }
+        std::cout << "Deviation from the two-phase flash: " << error << "\n";
+        passed = passed && twoPhase.nPhases == 2 && error < 1e-8;
+    }
+
+    // Cold starts with and without the free-water K-values
+    auto run = [&](int waterIndex, const char* name) {
+        solver.stability.waterIndex = waterIndex;
+        int iterations = 0, stabilityTests = 0;
+        for (const Case& c : cases) {
+            solver.flash(c.pressure, c.temperature, wetGas(c.waterFraction), result, ws);
+            iterations += result.iterations;
+            stabilityTests += result.stabilityTests;
+        }
+
+        std::vector<std::vector<double>> feeds;
+        for (const Case& c : cases) feeds.push_back(wetGas(c.waterFraction));
+
+        const int nRepeats = 50;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int r = 0; r < nRepeats; r++) {
+            for (std::size_t k = 0; k < cases.size(); k++) {
+                solver.flash(cases[k].pressure, cases[k].temperature, feeds[k], result, ws);
+            }
+        }
+        auto t1 = std::chrono::steady_clock::now();
+
+        double time = std::chrono::duration<double, std::micro>(t1 - t0).count() / (nRepeats * cases.size());
+        std::cout << name << ": " << iterations << " iterations, " << stabilityTests << " stability tests, " << time << " us per flash\n";
+        return iterations;
+    };
+
+    int seeded = run(water, "Free-water start");
+    int unseeded = run(-1, "Single-phase start");
+    passed = passed && seeded <= unseeded;
+
+    if (!passed) {
+        std::cout << "FAILED\n";
+        return 1;
+    }
+
+    std::cout << "PASSED\n";
+    return 0;
+}
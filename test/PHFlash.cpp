@@ -0,0 +1,143 @@
+#include "../src/PHFlash.cpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> gasNames = {
+        "Carbon dioxide",
+        "Nitrogen",
+        "Methane",
+        "Ethane",
+        "Propane",
+        "N-butane",
+        "Isobutane",
+        "Isopentane",
+        "N-pentane",
+        "N-hexane",
+        "N-heptane"
+    };
+    std::vector<double> zs = {
+        0.39903778076171875,
+        0.004628387093544006,
+        0.4591173553466797,
+        0.05989595890045166,
+        0.044221301078796384,
+        0.015023279190063476,
+        0.007778112888336182,
+        0.004155109822750092,
+        0.0050702130794525145,
+        0.001051282286643982,
+        2.121955156326294e-05
+    };
+
+    PengRobinsonEOS eos = PengRobinsonEOS(gasNames);
+    PHFlash solver(eos);
+    PHFlash::Workspace ws = solver.createWorkspace();
+    PHFlashResult result;
+
+    // States on both sides of the phase envelope, each specification solved 20 K away from its temperature.
+    // 230, 273 and 283 K lie on the blends between fitted k_ij ranges
+    std::vector<double> pressures = {10e5, 30e5, 50e5, 80e5};
+    std::vector<double> temperatures = {210.0, 230.0, 245.0, 260.0, 273.0, 283.0, 300.0, 330.0};
+    std::vector<FlashSpecification> specifications = {FlashSpecification::ENTHALPY, FlashSpecification::ENTROPY};
+
+    struct Case {
+        FlashSpecification specification;
+        double pressure;
+        double temperature;
+        double value;
+        int nPhases;
+        double vaporFraction;
+    };
+    std::vector<Case> cases;
+
+    for (double P : pressures) {
+        for (double T : temperatures) {
+            FlashResult phases = solver.flash.flash(P, T, zs);
+            for (FlashSpecification specification : specifications) {
+                double derivative;
+                double value = solver.value(specification, P, T, phases, ws, derivative);
+                cases.push_back({specification, P, T, value, phases.nPhases, phases.vaporFraction});
+            }
+        }
+    }
+
+    bool passed = true;
+
+    auto run = [&](bool direct, const char* name) {
+        solver.direct = direct;
+        int failed = 0, iterations = 0, flashes = 0, twoPhase = 0, otherRoots = 0;
+        double maxError = 0.0;
+
+        for (const Case& c : cases) {
+            double start = c.temperature + (c.nPhases == 2 ? -20.0 : 20.0);
+            solver.solve(c.specification, c.pressure, c.value, zs, start, result, ws);
+
+            double error = std::abs(result.temperature / c.temperature - 1.0);
+            if (result.phases.nPhases == 2) error = std::max(error, std::abs(result.phases.vaporFraction - c.vaporFraction));
+
+            // Narrow k_ij steps fold H(T) and S(T), another temperature counts if it reproduces the specification
+            if (error > 1e-8 && result.converged) {
+                FlashResult phases = solver.flash.flash(c.pressure, result.temperature, zs);
+                double derivative;
+                double value = solver.value(c.specification, c.pressure, result.temperature, phases, ws, derivative);
+                double scale = c.specification == FlashSpecification::ENTHALPY ? 8.3145 * result.temperature : 8.3145;
+                if (phases.nPhases == result.phases.nPhases && std::abs(value - c.value) / scale < 1e-8) {
+                    error = 0.0;
+                    otherRoots++;
+                }
+            } else if (result.phases.nPhases != c.nPhases) {
+                failed++;
+            }
+            if (!result.converged) failed++;
+
+            maxError = std::max(maxError, error);
+            iterations += result.iterations;
+            flashes += result.flashes;
+            if (c.nPhases == 2) twoPhase++;
+        }
+
+        std::cout << name << ": " << cases.size() << " flashes (" << twoPhase << " two-phase), " << failed << " failed, "
+                  << otherRoots << " on another root, " << iterations << " iterations, " << flashes << " PT flashes, max deviation " << maxError << "\n";
+        passed = passed && failed == 0 && maxError < 1e-8;
+
+        // Time per flash
+        const int nRepeats = 20;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int r = 0; r < nRepeats; r++) {
+            for (const Case& c : cases) {
+                double start = c.temperature + (c.nPhases == 2 ? -20.0 : 20.0);
+                solver.solve(c.specification, c.pressure, c.value, zs, start, result, ws);
+            }
+        }
+        auto t1 = std::chrono::steady_clock::now();
+
+        double time = std::chrono::duration<double, std::micro>(t1 - t0).count() / (nRepeats * cases.size());
+        std::cout << name << " flash: " << time << " us\n";
+        return time;
+    };
+
+    double nested = run(false, "Nested");
+    double direct = run(true, "Direct");
+    std::cout << "Direct / nested time: " << direct / nested << "\n";
+
+    // Joule-Thomson expansion through a valve, from 80 bar and 300 K down to 20 bar
+    FlashResult inlet = solver.flash.flash(80e5, 300.0, zs);
+    double derivative;
+    double H = solver.value(FlashSpecification::ENTHALPY, 80e5, 300.0, inlet, ws, derivative);
+    solver.solve(FlashSpecification::ENTHALPY, 20e5, H, zs, 300.0, result, ws);
+    std::cout << "Valve outlet at 20 bar: " << result.temperature << " K, vapor fraction " << result.phases.vaporFraction << "\n";
+    passed = passed && result.converged && result.temperature < 300.0;
+
+    if (!passed) {
+        std::cout << "FAILED\n";
+        return 1;
+    }
+
+    std::cout << "PASSED\n";
+    return 0;
+}
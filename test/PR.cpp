@@ -1,5 +1,10 @@
 #include "../src/PengRobinson.cpp"
 #include "../src/IdealGas.cpp"
+#include "../src/FixedMixture.cpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <optional>
 #include <vector>
 #include <string>
 #include <iomanip>
@@ -56,6 +61,120 @@ int main(int argc, char* argv[]) {
 
     std::cout << h << "\n";
 
+    // Batched Z over a (P, T) grid must match the one-state-at-a-time path
+    std::vector<double> Ps, Ts, Zs;
+    for (int i = 0; i < 23; i++) {
+        for (int j = 0; j < 17; j++) {
+            Ps.push_back(1e5 + i * 1e6);
+            Ts.push_back(220.0 + j * 10.0);
+        }
+    }
+
+    eos.compressibilityFactors(Ps, Ts, zs, Zs);
+
+    double maxDeviation = 0.0;
+    for (std::size_t k = 0; k < Ps.size(); k++) {
+        double Zk = eos.compressibilityFactor(Ps[k], Ts[k], zs);
+        maxDeviation = std::max(maxDeviation, std::abs(Zs[k] - Zk) / Zk);
+    }
+
+    std::cout << "Batched Z, " << Ps.size() << " states, max relative deviation: " << maxDeviation << "\n";
+    bool passed = maxDeviation < 1e-12;
+
+    // The fixed-size mixture must match the runtime-sized EoS
+    FixedMixture<11> mixture(eos);
+    std::array<double, 11> xs;
+    std::copy(zs.begin(), zs.end(), xs.begin());
+
+    maxDeviation = 0.0;
+    for (std::size_t k = 0; k < Ps.size(); k++) {
+        maxDeviation = std::max(maxDeviation, std::abs(mixture.compressibilityFactor(Ps[k], Ts[k], xs) - Zs[k]) / Zs[k]);
+    }
+
+    std::cout << "FixedMixture<11> Z, max relative deviation: " << maxDeviation << "\n";
+    passed = passed && maxDeviation < 1e-12;
+
+    // A workspace reused by a new EoS at the address of a destroyed one must not keep its a_ij cache
+    std::optional<PengRobinsonEOS> reused;
+    PengRobinsonEOS::Workspace reusedWs;
+    reused.emplace(gasNames);
+    reused->compressibilityFactor(P, T, zs, reusedWs);
+    reused.emplace(std::vector<std::string>{"Methane", "Carbon dioxide"});
+    double Zreused = reused->compressibilityFactor(P, T, {0.6, 0.4}, reusedWs);
+    double Zfresh = reused->compressibilityFactor(P, T, {0.6, 0.4});
+
+    std::cout << "Z with a workspace of a destroyed EoS: " << Zreused << " (fresh workspace " << Zfresh << ")\n";
+    passed = passed && Zreused == Zfresh;
+
+    // k12(T) keeps the fitted value at the midpoint of the part of each range where its record wins
+    const ComponentRegistry& registry = ComponentRegistry::instance();
+    std::size_t nChecked = 0;
+    maxDeviation = 0.0;
+
+    for (const auto& item : registry.interactionParameters()) {
+        if (std::isnan(item.minTemperature)) continue;
+
+        std::optional<ComponentId> id_1 = registry.findComponent(item.CASN_1);
+        std::optional<ComponentId> id_2 = registry.findComponent(item.CASN_2);
+        if (!id_1) id_1 = registry.findComponent(item.Name_1);
+        if (!id_2) id_2 = registry.findComponent(item.Name_2);
+        if (!id_1 || !id_2) continue;
+
+        const BinaryIPs::KijTable* table = registry.findKijTable(*id_1, *id_2);
+        if (!table) continue;
+
+        std::vector<const BinaryIPs::InteractionParameter*> records;
+        std::vector<double> endpoints;
+        for (std::size_t k = 0; k < registry.interactionParameterCount(*id_1, *id_2); k++) {
+            records.push_back(&registry.interactionParameter(*id_1, *id_2, k));
+            if (!std::isnan(records.back()->minTemperature)) {
+                endpoints.push_back(records.back()->minTemperature);
+                endpoints.push_back(records.back()->maxTemperature);
+            }
+        }
+        std::sort(endpoints.begin(), endpoints.end());
+
+        // Narrowest record containing the temperature, the first one on ties
+        auto winner = [&](double temperature, bool point) {
+            const BinaryIPs::InteractionParameter* best = nullptr;
+            for (const auto* record : records) {
+                if ((record->maxTemperature > record->minTemperature) == point) continue;
+                if (record->minTemperature <= temperature && record->maxTemperature >= temperature) {
+                    if (!best || record->maxTemperature - record->minTemperature < best->maxTemperature - best->minTemperature) {
+                        best = record;
+                    }
+                }
+            }
+            return best;
+        };
+
+        std::vector<double> midpoints;
+        if (item.minTemperature == item.maxTemperature) {
+            if (!winner(item.minTemperature, false) && winner(item.minTemperature, true) == &item) {
+                midpoints.push_back(item.minTemperature);
+            }
+        } else {
+            double begin = std::numeric_limits<double>::quiet_NaN();
+            for (std::size_t k = 0; k + 1 < endpoints.size(); k++) {
+                bool wins = endpoints[k] < endpoints[k + 1] && winner(0.5 * (endpoints[k] + endpoints[k + 1]), false) == &item;
+                if (wins && std::isnan(begin)) begin = endpoints[k];
+                if (!wins && endpoints[k] < endpoints[k + 1] && !std::isnan(begin)) {
+                    midpoints.push_back(0.5 * (begin + endpoints[k]));
+                    begin = std::numeric_limits<double>::quiet_NaN();
+                }
+            }
+            if (!std::isnan(begin)) midpoints.push_back(0.5 * (begin + endpoints.back()));
+        }
+
+        for (double temperature : midpoints) {
+            maxDeviation = std::max(maxDeviation, std::abs(table->kij(temperature) - item.k12));
+            nChecked++;
+        }
+    }
+
+    std::cout << "k12(T) at " << nChecked << " range midpoints, max deviation from the fit: " << maxDeviation << "\n";
+    passed = passed && nChecked > 0 && maxDeviation < 1e-12;
+
     // std::vector<std::vector<double>> k12 = eos.getKIJ();
 
     // const int width = 10;
@@ -66,5 +185,11 @@ int main(int argc, char* argv[]) {
     //     std::cout << std::endl;
     // }
 
+    if (!passed) {
+        std::cout << "FAILED\n";
+        return 1;
+    }
+
+    std::cout << "PASSED\n";
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "../src/PhaseEnvelope.cpp"
+#include "../src/PTFlash.cpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> gasNames = {
+        "Carbon dioxide",
+        "Nitrogen",
+        "Methane",
+        "Ethane",
+        "Propane",
+        "N-butane",
+        "Isobutane",
+        "Isopentane",
+        "N-pentane",
+        "N-hexane",
+        "N-heptane"
+    };
+    std::vector<double> zs = {
+        0.39903778076171875,
+        0.004628387093544006,
+        0.4591173553466797,
+        0.05989595890045166,
+        0.044221301078796384,
+        0.015023279190063476,
+        0.007778112888336182,
+        0.004155109822750092,
+        0.0050702130794525145,
+        0.001051282286643982,
+        2.121955156326294e-05
+    };
+
+    PengRobinsonEOS eos = PengRobinsonEOS(gasNames);
+    PhaseEnvelopeTracer tracer(eos);
+    PhaseEnvelopeTracer::Workspace ws = tracer.createWorkspace();
+    PhaseEnvelope envelope;
+
+    tracer.trace(zs, envelope, ws);
+
+    std::cout << envelope.size() << " points, " << envelope.iterations << " Newton iterations, "
+              << (envelope.complete ? "complete" : "incomplete") << "\n";
+    for (std::size_t k = 0; k < envelope.criticalTemperatures.size(); k++) {
+        std::cout << "Critical point: T = " << envelope.criticalTemperatures[k] << " K, P = " << envelope.criticalPressures[k] / 1e5 << " bar\n";
+    }
+    std::cout << "Cricondenbar: T = " << envelope.cricondenbarTemperature << " K, P = " << envelope.cricondenbarPressure / 1e5 << " bar\n";
+    std::cout << "Cricondentherm: T = " << envelope.cricondenthermTemperature << " K, P = " << envelope.cricondenthermPressure / 1e5 << " bar\n";
+
+    bool passed = envelope.complete && envelope.criticalTemperatures.size() == 1;
+
+    // Every point must be an incipient phase in equilibrium with the feed
+    int n = zs.size();
+    PengRobinsonEOS::Workspace eosWs = eos.createWorkspace();
+    std::vector<double> y(n), lnPhiZ, lnPhiY;
+    double maxResidual = 0.0;
+
+    for (int k = 0; k < envelope.size(); k++) {
+        double T = envelope.temperatures[k], P = envelope.pressures[k];
+        double sumY = 0.0;
+        for (int i = 0; i < n; i++) {
+            y[i] = zs[i] * exp(envelope.lnK[k * n + i]);
+            sumY += y[i];
+        }
+        maxResidual = std::max(maxResidual, std::abs(sumY - 1.0));
+
+        eos.lnPhi(P, T, zs, lnPhiZ, eosWs);
+        eos.lnPhi(P, T, y, lnPhiY, eosWs);
+        for (int i = 0; i < n; i++) {
+            maxResidual = std::max(maxResidual, std::abs(log(y[i] / zs[i]) + lnPhiY[i] - lnPhiZ[i]));
+        }
+    }
+
+    std::cout << "Max residual along the envelope: " << maxResidual << "\n";
+    passed = passed && maxResidual < 1e-8;
+
+    // The flash must find one phase beyond the cricondenbar and cricondentherm, two just inside
+    PTFlash flash(eos);
+    PTFlash::Workspace flashWs = flash.createWorkspace();
+    FlashResult result;
+    int misplaced = 0;
+
+    for (int k = 0; k < envelope.size(); k++) {
+        // Below about 157 K the EoS splits the feed into two liquids beyond the cricondenbar as well
+        if (envelope.temperatures[k] < 160.0) continue;
+        flash.flash(1.01 * envelope.cricondenbarPressure, envelope.temperatures[k], zs, result, flashWs);
+        if (result.nPhases != 1) misplaced++;
+    }
+    for (double P = 1.5e5; P < envelope.cricondenbarPressure; P *= 1.5) {
+        flash.flash(P, envelope.cricondenthermTemperature + 0.5, zs, result, flashWs);
+        if (result.nPhases != 1) misplaced++;
+    }
+    flash.flash(envelope.cricondenbarPressure * 0.99, envelope.cricondenbarTemperature, zs, result, flashWs);
+    if (result.nPhases != 2) misplaced++;
+    flash.flash(envelope.cricondenthermPressure, envelope.cricondenthermTemperature - 0.5, zs, result, flashWs);
+    if (result.nPhases != 2) misplaced++;
+
+    std::cout << "Flashes on the wrong side of the extrema: " << misplaced << "\n";
+    passed = passed && misplaced == 0;
+
+    // Time per full envelope
+    const int nRepeats = 100;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < nRepeats; r++) {
+        tracer.trace(zs, envelope, ws);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    std::cout << "Full envelope: " << std::chrono::duration<double, std::milli>(t1 - t0).count() / nRepeats << " ms\n";
+
+    if (!passed) {
+        std::cout << "FAILED\n";
+        return 1;
+    }
+
+    std::cout << "PASSED\n";
+    return 0;
+}
@@ -0,0 +1,174 @@
+#include "../src/PropertyTable.cpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> gasNames = {
+        "Carbon dioxide",
+        "Nitrogen",
+        "Methane",
+        "Ethane",
+        "Propane",
+        "N-butane",
+        "Isobutane",
+        "Isopentane",
+        "N-pentane",
+        "N-hexane",
+        "N-heptane"
+    };
+    std::vector<double> zs = {
+        0.39903778076171875,
+        0.004628387093544006,
+        0.4591173553466797,
+        0.05989595890045166,
+        0.044221301078796384,
+        0.015023279190063476,
+        0.007778112888336182,
+        0.004155109822750092,
+        0.0050702130794525145,
+        0.001051282286643982,
+        2.121955156326294e-05
+    };
+
+    PengRobinsonEOS eos = PengRobinsonEOS(gasNames);
+
+    // Supercritical gas, above the cricondentherm
+    PropertyTableGrid grid;
+    grid.minPressure = 1e5;
+    grid.maxPressure = 200e5;
+    grid.minTemperature = 300.0;
+    grid.maxTemperature = 450.0;
+    grid.nPressures = 64;
+    grid.nTemperatures = 64;
+
+    auto t0 = std::chrono::steady_clock::now();
+    PropertyTable table = PropertyTable::generate(eos, zs, grid);
+    auto t1 = std::chrono::steady_clock::now();
+    std::cout << "Generated " << grid.nPressures << " x " << grid.nTemperatures << " nodes, " << table.propertyCount() << " properties, "
+              << table.header().size / 1024 << " kB in " << std::chrono::duration<double, std::milli>(t1 - t0).count() << " ms\n";
+
+    const char* names[] = {"Z", "density", "enthalpy", "entropy"};
+    int nProperties = table.propertyCount();
+
+    // Random states against the EoS: every error must stay within the bound of its cell
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> lnP(log(grid.minPressure), log(grid.maxPressure));
+    std::uniform_real_distribution<double> T(grid.minTemperature, grid.maxTemperature);
+
+    const int nStates = 2000;
+    std::vector<double> pressures(nStates), temperatures(nStates);
+    for (int k = 0; k < nStates; k++) {
+        pressures[k] = exp(lnP(generator));
+        temperatures[k] = T(generator);
+    }
+
+    PengRobinsonEOS::Workspace ws = eos.createWorkspace();
+    PengRobinsonEOS::ResidualProperties residual;
+    std::vector<double> values(nProperties), dT(nProperties), dP(nProperties), lnPhi;
+    std::vector<double> maxError(nProperties, 0.0), maxRatio(nProperties, 0.0);
+
+    for (int k = 0; k < nStates; k++) {
+        double P = pressures[k], temperature = temperatures[k];
+        table.evaluate(P, temperature, values.data());
+
+        eos.residualProperties(P, temperature, zs, residual, ws);
+        eos.lnPhi(P, temperature, zs, lnPhi, ws);
+
+        std::vector<double> exact = {
+            residual.Z,
+            eos.density(P, temperature, zs),
+            eos.enthalpy(P, temperature, zs, UnitBase::MASS),
+            eos.entropy(P, temperature, zs, UnitBase::MASS)
+        };
+        exact.insert(exact.end(), lnPhi.begin(), lnPhi.end());
+
+        for (int p = 0; p < nProperties; p++) {
+            double error = std::abs(values[p] - exact[p]);
+            maxError[p] = std::max(maxError[p], error);
+            maxRatio[p] = std::max(maxRatio[p], error / std::max(table.errorBound(p, P, temperature), 1e-15));
+        }
+    }
+
+    bool passed = true;
+    for (int p = 0; p < nProperties; p++) {
+        std::string name = p < PropertyTable::LN_PHI ? names[p] : "ln phi " + gasNames[p - PropertyTable::LN_PHI];
+        std::cout << name << ": max error " << maxError[p] << ", table bound " << table.maxErrorBound(p) << ", error / cell bound " << maxRatio[p] << "\n";
+        passed = passed && maxRatio[p] <= 1.0;
+    }
+
+    // Interpolated derivatives against central differences of the interpolant
+    double derivativeError = 0.0;
+    for (int k = 0; k < 100; k++) {
+        double P = pressures[k], temperature = temperatures[k];
+        std::vector<double> plus(nProperties), minus(nProperties);
+
+        table.evaluate(P, temperature, values.data(), dT.data(), dP.data());
+        table.evaluate(P, temperature + 1e-4, plus.data());
+        table.evaluate(P, temperature - 1e-4, minus.data());
+        for (int p = 0; p < nProperties; p++) {
+            double fd = (plus[p] - minus[p]) / 2e-4;
+            derivativeError = std::max(derivativeError, std::abs(dT[p] - fd) / std::max(1.0, std::abs(fd)));
+        }
+
+        table.evaluate(P * (1.0 + 1e-6), temperature, plus.data());
+        table.evaluate(P * (1.0 - 1e-6), temperature, minus.data());
+        for (int p = 0; p < nProperties; p++) {
+            double fd = (plus[p] - minus[p]) / (2e-6 * P);
+            derivativeError = std::max(derivativeError, std::abs(dP[p] - fd) / std::max(1e-5, std::abs(fd)));
+        }
+    }
+    std::cout << "Interpolated derivatives, max relative deviation: " << derivativeError << "\n";
+    passed = passed && derivativeError < 1e-5;
+
+    // Round trip through a file, mapped back
+    const std::string path = "PropertyTable_Test.bin";
+    table.save(path);
+    {
+        PropertyTable mapped(path);
+        std::vector<double> fromFile(nProperties);
+        double deviation = 0.0;
+        for (int k = 0; k < nStates; k++) {
+            table.evaluate(pressures[k], temperatures[k], values.data());
+            mapped.evaluate(pressures[k], temperatures[k], fromFile.data());
+            for (int p = 0; p < nProperties; p++) deviation = std::max(deviation, std::abs(fromFile[p] - values[p]));
+        }
+        std::cout << "Mapped table, max deviation: " << deviation << "\n";
+        passed = passed && deviation == 0.0 && mapped.componentCount() == (int)zs.size();
+    }
+    std::remove(path.c_str());
+
+    // Time per state: every property from the table against Z, H and ln(phi) from the EoS
+    double sum = 0.0;
+    auto t2 = std::chrono::steady_clock::now();
+    for (int r = 0; r < 50; r++) {
+        for (int k = 0; k < nStates; k++) {
+            table.evaluate(pressures[k], temperatures[k], values.data());
+            sum += values[PropertyTable::DENSITY];
+        }
+    }
+    auto t3 = std::chrono::steady_clock::now();
+    for (int k = 0; k < nStates; k++) {
+        eos.residualProperties(pressures[k], temperatures[k], zs, residual, ws);
+        eos.lnPhi(pressures[k], temperatures[k], zs, lnPhi, ws);
+        sum += residual.Z;
+    }
+    auto t4 = std::chrono::steady_clock::now();
+
+    double tableTime = std::chrono::duration<double, std::nano>(t3 - t2).count() / (50 * nStates);
+    double eosTime = std::chrono::duration<double, std::nano>(t4 - t3).count() / nStates;
+    std::cout << "Table: " << tableTime << " ns per state, EoS: " << eosTime << " ns per state (checksum " << sum << ")\n";
+
+    if (!passed) {
+        std::cout << "FAILED\n";
+        return 1;
+    }
+
+    std::cout << "PASSED\n";
+    return 0;
+}
@@ -1,9 +1,21 @@
 #include "../include/RootFinding.hpp"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <cmath>
 #include <vector>
 #include <complex>
 
+// Largest real root of a0 + a1 x + a2 x^2 + x^3 with the Laguerre-based solver
+double largestRealRoot(double a0, double a1, double a2) {
+    std::vector<std::complex<double>> a = {a0, a1, a2, 1.0};
+    double x = -1e300;
+    for (const auto& r : RootFind::roots(a)) {
+        if (std::abs(r.imag()) <= 1e-8 * std::max(1.0, std::abs(r.real()))) x = std::max(x, r.real());
+    }
+    return x;
+}
+
 int main(int argc, char* argv[])
 {
     std::vector<std::complex<double>> a1 = {1.0, 2.0, 1.0};
@@ -36,4 +48,79 @@ int main(int argc, char* argv[])
         std::cout << r << ", ";
     }
     std::cout << "\n";
-}
\ No newline at end of file
+
+    // Closed-form cubic solver: a0, a1, a2 of a0 + a1 x + a2 x^2 + x^3
+    struct Cubic { const char* name; double a0, a1, a2; };
+    std::vector<Cubic> cubics = {
+        {"(x - 1)(x - 2)(x - 3)", -6.0, 11.0, -6.0},
+        {"(x - 1)^2 (x - 2)", -2.0, 5.0, -4.0},
+        {"(x - 1)^3", -1.0, 3.0, -3.0},
+        {"(x - 1)(x - 1 - 1e-6)(x - 1 + 1e-6)", -(1.0 - 1e-12), 3.0 - 1e-12, -3.0},
+        {"x^3 + x + 1", 1.0, 1.0, 0.0},
+        {"x^3", 0.0, 0.0, 0.0},
+        {"PR gas, A = 0.4, B = 0.08", -0.4 * 0.08 + 0.08 * 0.08 + 0.08 * 0.08 * 0.08, 0.4 - 3.0 * 0.08 * 0.08 - 2.0 * 0.08, 0.08 - 1.0},
+        {"PR two-phase, A = 0.2, B = 0.02", -0.2 * 0.02 + 0.02 * 0.02 + 0.02 * 0.02 * 0.02, 0.2 - 3.0 * 0.02 * 0.02 - 2.0 * 0.02, 0.02 - 1.0}
+    };
+
+    // Every real root must be one of the Laguerre roots, and the largest ones must agree.
+    // A triple root is only defined to about the cube root of the machine epsilon
+    bool passed = true;
+    for (const auto& c : cubics) {
+        double x[3];
+        int n = RootFind::cubicRoots(c.a0, c.a1, c.a2, x);
+        std::vector<std::complex<double>> reference = RootFind::roots({c.a0, c.a1, c.a2, 1.0});
+        double largest = largestRealRoot(c.a0, c.a1, c.a2);
+        double maxResidual = 0.0, maxDeviation = std::abs(x[n - 1] - largest);
+
+        std::cout << "The real roots of " << c.name << " are: ";
+        for (int k = 0; k < n; k++) {
+            std::cout << x[k] << ", ";
+            maxResidual = std::max(maxResidual, std::abs(((x[k] + c.a2) * x[k] + c.a1) * x[k] + c.a0));
+
+            double nearest = std::abs(reference[0] - x[k]);
+            for (const auto& r : reference) nearest = std::min(nearest, std::abs(r - x[k]));
+            maxDeviation = std::max(maxDeviation, nearest);
+        }
+        std::cout << "(max residual " << maxResidual << ", Laguerre largest root " << largest << ", max deviation " << maxDeviation << ")\n";
+        passed = passed && maxDeviation <= 1e-5 * std::max(1.0, std::abs(largest));
+    }
+
+    // Benchmark against the Laguerre path on PR-like cubics
+    const int nSolves = 200000;
+    std::vector<std::complex<double>> coeffs(4), results, work;
+    double sumCubic = 0.0, sumLaguerre = 0.0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int k = 0; k < nSolves; k++) {
+        double A = 0.05 + 0.5 * k / nSolves, B = 0.01 + 0.1 * k / nSolves, x[3];
+        int n = RootFind::cubicRoots(-A * B + B * B + B * B * B, A - 3.0 * B * B - 2.0 * B, B - 1.0, x);
+        sumCubic += x[n - 1];
+    }
+    double tCubic = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / nSolves;
+
+    start = std::chrono::steady_clock::now();
+    for (int k = 0; k < nSolves; k++) {
+        double A = 0.05 + 0.5 * k / nSolves, B = 0.01 + 0.1 * k / nSolves, Z = 0.0;
+        coeffs[0] = -A * B + B * B + B * B * B;
+        coeffs[1] = A - 3.0 * B * B - 2.0 * B;
+        coeffs[2] = B - 1.0;
+        coeffs[3] = 1.0;
+        RootFind::roots(coeffs, results, work);
+        for (const auto& r : results) Z = std::max(Z, r.real());
+        sumLaguerre += Z;
+    }
+    double tLaguerre = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / nSolves;
+
+    std::cout << "cubicRoots: " << tCubic << " ns/solve, Laguerre roots: " << tLaguerre << " ns/solve\n";
+    double meanDifference = std::abs(sumCubic - sumLaguerre) / nSolves;
+    std::cout << "Mean largest root difference: " << meanDifference << "\n";
+    passed = passed && meanDifference < 1e-12;
+
+    if (!passed) {
+        std::cout << "FAILED\n";
+        return 1;
+    }
+
+    std::cout << "PASSED\n";
+    return 0;
+}
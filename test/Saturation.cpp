@@ -0,0 +1,119 @@
+#include "../src/Saturation.cpp"
+#include "../src/PhaseEnvelope.cpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> gasNames = {
+        "Carbon dioxide",
+        "Nitrogen",
+        "Methane",
+        "Ethane",
+        "Propane",
+        "N-butane",
+        "Isobutane",
+        "Isopentane",
+        "N-pentane",
+        "N-hexane",
+        "N-heptane"
+    };
+    std::vector<double> zs = {
+        0.39903778076171875,
+        0.004628387093544006,
+        0.4591173553466797,
+        0.05989595890045166,
+        0.044221301078796384,
+        0.015023279190063476,
+        0.007778112888336182,
+        0.004155109822750092,
+        0.0050702130794525145,
+        0.001051282286643982,
+        2.121955156326294e-05
+    };
+
+    PengRobinsonEOS eos = PengRobinsonEOS(gasNames);
+    SaturationSolver solver(eos);
+    SaturationSolver::Workspace ws = solver.createWorkspace();
+
+    // Reference points: the bubble branch up to the critical point and the lower dew branch,
+    // both from 1 bar upwards, as traced by the envelope
+    PhaseEnvelopeTracer tracer(eos);
+    PhaseEnvelope envelope = tracer.trace(zs);
+
+    std::vector<double> bubbleT, bubbleP, dewT, dewP;
+    for (int k = 0; k < envelope.size(); k++) {
+        if (envelope.incipientVapor[k]) {
+            bubbleT.push_back(envelope.temperatures[k]);
+            bubbleP.push_back(envelope.pressures[k]);
+        } else if (envelope.pressures[k] < envelope.cricondenthermPressure) {
+            dewT.push_back(envelope.temperatures[k]);
+            dewP.push_back(envelope.pressures[k]);
+        }
+    }
+    std::reverse(dewT.begin(), dewT.end());
+    std::reverse(dewP.begin(), dewP.end());
+
+    // Keep to the two ends of the curves, away from the critical point and the cricondentherm
+    bubbleT.resize(bubbleT.size() / 2);
+    bubbleP.resize(bubbleP.size() / 2);
+    dewT.resize(dewT.size() * 3 / 4);
+    dewP.resize(dewP.size() * 3 / 4);
+
+    bool passed = true;
+    std::vector<SaturationPoint> points;
+
+    auto check = [&](const char* name, const std::vector<double>& expected, bool pressures) {
+        int failed = 0, iterations = 0;
+        double maxError = 0.0;
+        for (std::size_t k = 0; k < points.size(); k++) {
+            if (!points[k].converged) failed++;
+            iterations += points[k].iterations;
+            double value = pressures ? points[k].pressure : points[k].temperature;
+            maxError = std::max(maxError, std::abs(value / expected[k] - 1.0));
+        }
+        std::cout << name << ": " << points.size() << " points, " << failed << " failed, " << iterations
+                  << " Newton iterations, max relative deviation from the envelope " << maxError << "\n";
+        passed = passed && failed == 0 && maxError < 1e-6;
+        return iterations;
+    };
+
+    solver.pressures(SaturationType::BUBBLE, bubbleT, zs, points, ws);
+    check("Bubble pressures", bubbleP, true);
+    solver.pressures(SaturationType::DEW, dewT, zs, points, ws);
+    check("Dew pressures", dewP, true);
+    solver.temperatures(SaturationType::BUBBLE, bubbleP, zs, points, ws);
+    check("Bubble temperatures", bubbleT, false);
+    solver.temperatures(SaturationType::DEW, dewP, zs, points, ws);
+    int seeded = check("Dew temperatures", dewT, false);
+
+    // The same HCDP curve from Wilson K-values at every point must take more iterations
+    int wilson = 0;
+    for (std::size_t k = 0; k < dewP.size(); k++) {
+        solver.temperature(SaturationType::DEW, dewP[k], zs, points[k], ws);
+        wilson += points[k].iterations;
+    }
+    std::cout << "Dew temperatures from Wilson K-values: " << wilson << " Newton iterations\n";
+    passed = passed && seeded < wilson;
+
+    // Time per point of the HCDP curve
+    const int nRepeats = 100;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < nRepeats; r++) {
+        solver.temperatures(SaturationType::DEW, dewP, zs, points, ws);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    std::cout << "HCDP point: " << std::chrono::duration<double, std::micro>(t1 - t0).count() / (nRepeats * dewP.size()) << " us\n";
+
+    if (!passed) {
+        std::cout << "FAILED\n";
+        return 1;
+    }
+
+    std::cout << "PASSED\n";
+    return 0;
+}
@@ -0,0 +1,136 @@
+#include "../src/PTFlash.cpp"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> gasNames = {
+        "Carbon dioxide",
+        "Nitrogen",
+        "Methane",
+        "Ethane",
+        "Propane",
+        "N-butane",
+        "Isobutane",
+        "Isopentane",
+        "N-pentane",
+        "N-hexane",
+        "N-heptane"
+    };
+    std::vector<double> zs = {
+        0.39903778076171875,
+        0.004628387093544006,
+        0.4591173553466797,
+        0.05989595890045166,
+        0.044221301078796384,
+        0.015023279190063476,
+        0.007778112888336182,
+        0.004155109822750092,
+        0.0050702130794525145,
+        0.001051282286643982,
+        2.121955156326294e-05
+    };
+
+    PengRobinsonEOS eos = PengRobinsonEOS(gasNames);
+    StabilityAnalysis stability(eos);
+    StabilityAnalysis::Workspace ws = stability.createWorkspace();
+    StabilityResult result;
+
+    stability.analyze(40e5, 230.0, zs, result, ws);
+    std::cout << "P = 40 bar, T = 230 K: " << (result.stable ? "stable" : "unstable") << ", tm = " << result.tpd
+              << ", " << result.iterations << " iterations in " << result.trials << " trials\n";
+
+    // States around the two-phase region of the gas, marched as one stream
+    std::vector<std::pair<double, double>> states;
+    for (double T = 190.0; T <= 290.0; T += 5.0) {
+        for (double P = 5e5; P <= 80e5; P += 5e5) {
+            states.push_back({P, T});
+        }
+    }
+
+    // The verdict must match a flash that does not use the stability analysis
+    PTFlash flash(eos);
+    flash.stabilityTest = false;
+    flash.newtonSwitch = 0.0;
+    flash.maxIterations = 5000;
+    PTFlash::Workspace flashWs = flash.createWorkspace();
+    FlashResult flashResult;
+
+    StabilityAnalysis::Workspace coldWs = stability.createWorkspace();
+    int nUnstable = 0, mismatches = 0, warmIterations = 0, coldIterations = 0;
+
+    for (const auto& state : states) {
+        stability.analyze(state.first, state.second, zs, result, ws);
+        warmIterations += result.iterations;
+
+        coldWs.hasCache = false;
+        StabilityResult cold;
+        stability.analyze(state.first, state.second, zs, cold, coldWs);
+        coldIterations += cold.iterations;
+
+        flash.flash(state.first, state.second, zs, flashResult, flashWs);
+        bool split = flashResult.converged && flashResult.nPhases == 2;
+
+        if (!result.stable) nUnstable++;
+        if (result.stable == split || result.stable != cold.stable) {
+            mismatches++;
+            std::cout << "Mismatch at P = " << state.first << " Pa, T = " << state.second << " K, tm = " << result.tpd << "\n";
+        }
+    }
+
+    std::cout << nUnstable << " unstable states out of " << states.size() << ", " << mismatches << " mismatches with the flash\n";
+    std::cout << "Iterations per state: " << double(warmIterations) / states.size() << " with the cached stationary point, "
+              << double(coldIterations) / states.size() << " without\n";
+
+    // Liquid-liquid splits, where the flash from Wilson K-values collapses onto the feed: it must restart from
+    // the stationary point of the unstable trial phase
+    PTFlash seeded(eos);
+    PTFlash::Workspace seededWs = seeded.createWorkspace(), replayWs = seeded.createWorkspace();
+    FlashResult replay;
+    int nLiquidLiquid = 0, nStationary = 0, nReplayed = 0;
+
+    for (double T = 115.0; T <= 135.0; T += 5.0) {
+        seeded.flash(90e5, T, zs, flashResult, seededWs);
+        const StabilityResult& analysis = seededWs.stabilityResult;
+        if (flashResult.nPhases == 2 && flashResult.converged) nLiquidLiquid++;
+        if (!analysis.stable && analysis.stationary) nStationary++;
+
+        replay.K = analysis.K;
+        seeded.solveFromK(90e5, T, zs, replay, replayWs);
+        if (replay.nPhases == 2 && replay.vaporFraction == flashResult.vaporFraction && replay.K == flashResult.K) nReplayed++;
+    }
+
+    std::cout << "Liquid-liquid splits at 90 bar, 115 to 135 K: " << nLiquidLiquid << " of 5 found, " << nStationary
+              << " from a stationary point, " << nReplayed << " started from its K-values\n";
+
+    // Single-phase states no longer iterate the flash to the trivial solution
+    PTFlash checked(eos);
+    PTFlash::Workspace checkedWs = checked.createWorkspace();
+    PTFlash unchecked(eos);
+    unchecked.stabilityTest = false;
+    PTFlash::Workspace uncheckedWs = unchecked.createWorkspace();
+
+    const int nRepeats = 5;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < nRepeats; r++) {
+        for (const auto& state : states) checked.flash(state.first, state.second, zs, flashResult, checkedWs);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (int r = 0; r < nRepeats; r++) {
+        for (const auto& state : states) unchecked.flash(state.first, state.second, zs, flashResult, uncheckedWs);
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    double nFlashes = double(nRepeats) * states.size();
+    std::cout << "Flash with stability analysis: " << std::chrono::duration<double, std::micro>(t1 - t0).count() / nFlashes << " us/flash\n";
+    std::cout << "Flash without: " << std::chrono::duration<double, std::micro>(t2 - t1).count() / nFlashes << " us/flash\n";
+
+    if (mismatches > 0 || nUnstable == 0 || nLiquidLiquid != 5 || nStationary != 5 || nReplayed != 5) {
+        std::cout << "FAILED\n";
+        return 1;
+    }
+
+    std::cout << "PASSED\n";
+    return 0;
+}
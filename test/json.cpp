@@ -19,10 +19,10 @@ int main() {
     std::cout << gas.criticalPressure << "\n";
     std::cout << gas.criticalTemperature << "\n";
     std::cout << gas.molecularWeight << "\n";
-    std::cout << gas.idealGasHeatCapacityPolyCoeffs.at("A") << "\n";
-    std::cout << gas.idealGasHeatCapacityPolyCoeffs.at("B") << "\n";
-    std::cout << gas.idealGasHeatCapacityPolyCoeffs.at("C") << "\n";
-    std::cout << gas.idealGasHeatCapacityPolyCoeffs.at("D") << "\n";
+    std::cout << gas.idealGasHeatCapacityPolyCoeffs[0] << "\n";
+    std::cout << gas.idealGasHeatCapacityPolyCoeffs[1] << "\n";
+    std::cout << gas.idealGasHeatCapacityPolyCoeffs[2] << "\n";
+    std::cout << gas.idealGasHeatCapacityPolyCoeffs[3] << "\n";
 
     std::cout << "Enter ID1: ";
     std::getline(std::cin, id_1);
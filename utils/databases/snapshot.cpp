@@ -0,0 +1,36 @@
+// snapshot.cpp
+// Build step that compiles the JSON databases into the binary snapshot loaded by the EoS classes
+#include "../../include/GasProperties.hpp"
+#include "../../include/InteractionParameters.hpp"
+#include "../../include/Snapshot.hpp"
+#include <iostream>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    std::string chemsepPath = "utils/databases/chemsepdb.json";
+    std::string pripPath = "utils/databases/pripdb.json";
+    std::string outputPath = Snapshot::DEFAULT_PATH;
+
+    if (argc == 4) {
+        chemsepPath = argv[1];
+        pripPath = argv[2];
+        outputPath = argv[3];
+    } else if (argc != 1) {
+        std::cerr << "Usage: " << argv[0] << " [chemsepdb.json pripdb.json output.bin]\n";
+        return 1;
+    }
+
+    try {
+        auto gases = GasConstants::parseGasProperties(chemsepPath);
+        auto gasesIPs = BinaryIPs::parseInteractionParameters(pripPath);
+
+        Snapshot::writeSnapshot(outputPath, gases, gasesIPs);
+
+        std::cout << "Wrote " << gases.size() << " gases and " << gasesIPs.size() << " interaction parameters to " << outputPath << "\n";
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR: " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}